@@ -8,7 +8,7 @@
  *  Hardware:
  *    - u-blox GPS module on Serial1 (9600 default, configurable to 115200/5Hz)
  *    - MPU9250 9-axis IMU on I2C (accelerometer, gyroscope, magnetometer, temp)
- *    - Innovate Motorsports ISP2 daisy-chain on Serial2 (19200 baud):
+ *    - Innovate Motorsports ISP2 daisy-chain on USART2 / Serial2 pins (19200 baud):
  *        SSI-4 #1: coolant temp, oil pressure
  *        LC-1  #1: wideband AFR bank 1
  *        LC-1  #2: wideband AFR bank 2
@@ -24,6 +24,7 @@
  *    c    calibrate accelerometer  m  calibrate magnetometer
  *    C    show IMU calibration     E  erase EEPROM calibration
  *    g    reconfigure GPS (115200 baud + 5Hz)
+ *    b    toggle binary log (.bin) for the next recording
  *
  *  GPS: auto-configured at boot to 115200 baud + 5Hz (u-blox resets on power
  *       cycle, so we always reconfigure). Use 'g' to reconfigure after the GPS
@@ -50,17 +51,36 @@
  *    Change AXIS_FWD_IDX/SIGN, AXIS_RIGHT_IDX/SIGN, AXIS_DOWN_IDX/SIGN
  *    when the sensor board is mounted at a different orientation.
  *
- *  CSV output (25 columns):
- *    time, lat, lon, speed, alt, dir, sats,
- *    accx/y/z, rotx/y/z, magx/y/z, imuTemp,
- *    afr, afr1, vss, map, oilp, coolant, gpsStale, keyframe
+ *  CSV output: the columns of shared channels.h, which also declares
+ *  the logged SensorData fields and generates printRow() and the header.
+ *    afrStat, afr1Stat  LC-1 status codes (Lc1Status, isp2_defs.h)
+ *    engQual            rejected engine channels (EQ_* bits, engine_validate.h)
+ *    egt, fuelp         second ISP2 chain on the ESP32; always 0 here
+ *    roll .. linz       ESP32 attitude filter (shared ahrs.h); always 0 here
+ *    rpm, rpmConf       ESP32 vibration RPM (shared vib_rpm.h); always 0 here
+ *    linOk              ESP32: linx..linz usable (speed known); always 0 here
+ *
+ *  Binary log ('b', shared binlog.h, same records as the ESP32): the file
+ *  is preallocated contiguously and written as raw 512-byte sectors, so
+ *  no FAT or directory update happens while recording. Convert with
+ *  tools/host/bin2csv.cpp. SD access goes through SdFat (greiman/SdFat)
+ *  for both formats.
+ *
+ *  Shared headers (ISP2 protocol, parser + aux calibration tables) come from
+ *  firmware/shared, passed to the build as a library:
+ *    arduino-cli compile --fqbn arduino:avr:mega --library ../../shared .
+ *  (Arduino IDE: copy or symlink firmware/shared into ~/Arduino/libraries/)
  *
  *  Repository: github.com/mangeb/analog-bridge
  */
 #define FW_VERSION "1.1.0"
 
 #include <SPI.h>
-#include <SD.h>
+#include <SdFat.h>
+#include <binlog.h>
+#include <isp2_defs.h>
+#include <isp2_parser.h>
+#include <engine_validate.h>
 #include <NMEAGPS.h>
 #include <GPSport.h>
 
@@ -168,11 +188,15 @@ static void eraseCalibration() {
 
 //----------------------------------------------------------------
 // ISP2 Serial port
-// Mega: hardware Serial2 (RX=17, TX=16)
+// Mega: USART2 (RX=17, TX=16) with our own RX interrupt that frames
+//       packets into isp2Ring. Serial2 must not be referenced anywhere,
+//       or the core's USART2 interrupt gets linked in as well.
 // Uno:  AltSoftSerial (RX=8, TX=9, claims PWM on pin 10)
 //----------------------------------------------------------------
 #if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
-  #define isp2Serial Serial2
+  #define ISP2_RX_ISR      1
+  #define ISP2_RX_RING     512    // bytes, power of 2 — ~17 Nova packets / 1.4 s
+  #include <util/atomic.h>
 #else
   #include <AltSoftSerial.h>
   AltSoftSerial isp2Serial;
@@ -406,24 +430,14 @@ static bool liveDebug = LIVE_DEBUG_DEFAULT;
 // Sensor data struct — single source of truth for all readings
 //----------------------------------------------------------------
 struct SensorData {
-  // GPS
-  long lat, lon;
-  float speed, alt, dir;
-  uint8_t satellites;
-  bool gpsStale;
-  // IMU — accelerometer, gyroscope, magnetometer, temperature
-  float accx, accy, accz;
-  float rotx, roty, rotz;
-  float magx, magy, magz;
-  float imuTemp;
-  // ISP2 / Engine
-  float afr, afr1;
-  float vss, map, oilp, coolant;  // vss = vehicle speed (MPH) from VSS reluctor
+  AB_CHANNEL_FIELDS               // logged channels, channels.h
+  uint16_t afrDetail, afr1Detail; // LC-1 word when not lambda (O2, warm-up, error)
 };
 static SensorData data = {};
 
 // Logging
-static File logFile;
+static SdFat32 sd;
+static File32 logFile;
 static char logFilename[16] = "";       // current log filename for status display
 static unsigned long logRowCount = 0;   // rows written in current session
 static uint8_t sdErrorCount = 0;        // consecutive flush errors
@@ -443,45 +457,15 @@ static bool mpu9250Ready = false;
 //----------------------------------------------------------------
 // ISP2 Protocol (Innovate Motorsports serial)
 //----------------------------------------------------------------
-#define ISP2_H_SYNC_MASK  0xA2  // High sync byte: bits 7,5,1 set
-#define ISP2_L_SYNC_MASK  0x80  // Low sync byte: bit 7 set
-#define ISP2_LC1_FLAG     0x40  // Bit 14 in high byte: LC-1 sub-packet
-
-#define ISP2_MAX_WORDS    16
-static byte    isp2Header[2];
-static byte    isp2Data[ISP2_MAX_WORDS * 2];
-static int     isp2PacketLen   = 0;
-static bool    isp2IsData      = false;
+// Framing state machine, decode and Nova channel map: shared
+// isp2_parser.h (same parser as the ESP32 firmware and host tools)
+static ISP2Parser isp2 = {};           // state + link stats ('i' command)
 static uint8_t isp2AuxCount    = 0;
 static uint8_t isp2Lc1Count    = 0;
+static EngineValidator engineVal = {};  // range/rate/VSS-GPS checks per packet
 
-// ISP2 non-blocking state machine
-enum ISP2State { ISP2_SYNC_HIGH, ISP2_SYNC_LOW, ISP2_READING_PAYLOAD };
-static ISP2State isp2State      = ISP2_SYNC_HIGH;
-static int       isp2BytesRead    = 0;
-static int       isp2BytesExpected = 0;
-static unsigned long isp2LastByte = 0;     // timestamp of last byte received
-#define ISP2_TIMEOUT_MS  200               // resync if payload stalls this long
-
-// Aux channel voltage-to-unit conversions (tune for your sensors)
-// TODO: Replace with actual thermistor curve (Steinhart-Hart or lookup table)
-#define AUX_COOLANT_F(v)   ((v) * 100.0)
-// TODO: Verify sender range — assumes 0.5-4.5V = 0-100 PSI linear
-#define AUX_OILP_PSI(v)    (((v) - 0.5) * 25.0)
-// TODO: Verify MAP sensor model — assumes 1-bar (0-5V = -14.7 to +14.7)
-#define AUX_MAP_INHG(v)    ((v) * 5.858 - 14.696)
-
-// VSS (Vehicle Speed Sensor) calibration
-// Derived from: 235/70R15 tire, 3.73 final drive, 17-tooth reluctor
-//   Wheel circumference: 2.23 m (710 mm dia)
-//   Driveshaft revs/h @ 100 mph: 269,153
-//   VSS frequency @ 100 mph: 269,153 × 17 / 3600 = 1271 Hz
-//   Conversion factor: 12.71 Hz per MPH
-// SSI-4 frequency mode: 0-5V maps linearly to 0..SSI4_VSS_FREQ_MAX Hz
-// Adjust SSI4_VSS_FREQ_MAX to match your LM Programmer frequency range setting
-#define SSI4_VSS_FREQ_MAX  1500.0   // Hz — SSI-4 configured max (adjust to match)
-#define VSS_HZ_PER_MPH     12.71    // Hz per MPH for this drivetrain
-#define AUX_VSS_MPH(v)     (((v) / 5.0 * SSI4_VSS_FREQ_MAX) / VSS_HZ_PER_MPH)
+// Aux channel conversions: curves in shared isp2_defs.h, expanded at
+// build time into PROGMEM tables indexed by the raw 10-bit value
 
 //----------------------------------------------------------------
 // Configuration constants
@@ -494,6 +478,10 @@ static unsigned long isp2LastByte = 0;     // timestamp of last byte received
 #define KEYFRAME_HOLD_MS 1000   // hold button this long for keyframe (ms)
 #define NOFIX_MSG_MS     5000   // GPS no-fix message rate limit (ms)
 #define SAMPLE_INTERVAL  80     // main loop sample period (ms) = 12.5 Hz
+                                // (25 Hz on the Mega once a TIMING_DEBUG build
+                                // shows a recording sample well under 40 ms)
+#define LOG_BINARY_DEFAULT false                // binary log at each recording ('b' toggles)
+#define BINLOG_PREALLOC  (32UL * 1024 * 1024)   // .bin preallocation: ~8.7 h at 12.5 Hz
 
 //----------------------------------------------------------------
 // UI — button and LED pins
@@ -584,10 +572,66 @@ static void printDegE7(Print &outs, int32_t degE7) {
   outs.print(degE7);
 }
 
+//----------------------------------------------------------------
+//  Print a float with a fixed number of decimals (0-3), same text as
+//  Print::print(float, digits) without its per-call divisions: the
+//  rounding term comes from a table, the integer part from ultoa, and
+//  the whole field goes out in one write() instead of char by char.
+//  The fraction digits repeat print()'s multiply/truncate steps so
+//  half-way values round the same way.
+static const float printRounding[4] = {
+  0.5f, 0.5f / 10.0f, 0.5f / 10.0f / 10.0f, 0.5f / 10.0f / 10.0f / 10.0f
+};
+
+static void printFixed(Print &outs, float x, uint8_t digits = 2) {
+  if (isnan(x)) { outs.print(F("nan")); return; }
+  if (isinf(x)) { outs.print(F("inf")); return; }
+  if (x > 4294967040.0f || x < -4294967040.0f) { outs.print(F("ovf")); return; }
+
+  char buf[16];
+  char *p = buf;
+  if (x < 0.0f) {
+    *p++ = '-';
+    x = -x;
+  }
+  x += printRounding[digits];
+
+  uint32_t ip = (uint32_t)x;
+  float rem = x - (float)ip;
+  ultoa(ip, p, 10);
+  p += strlen(p);
+
+  if (digits > 0) {
+    *p++ = '.';
+    while (digits-- > 0) {
+      rem *= 10.0f;
+      uint8_t d = (uint8_t)rem;
+      *p++ = '0' + d;
+      rem -= d;
+    }
+  }
+  outs.write((const uint8_t *)buf, p - buf);
+}
+
+//  Print milliseconds as seconds with 3 decimals, no float involved
+static void printMillis(Print &outs, uint32_t ms) {
+  char buf[16];
+  ultoa(ms / 1000, buf, 10);
+  char *p = buf + strlen(buf);
+  uint16_t frac = ms % 1000;
+  *p++ = '.';
+  *p++ = '0' + frac / 100;
+  *p++ = '0' + (frac / 10) % 10;
+  *p++ = '0' + frac % 10;
+  outs.write((const uint8_t *)buf, p - buf);
+}
+
 //----------------------------------------------------------------
 // Recording control
 //----------------------------------------------------------------
-static void openLogFile();  // forward declaration
+static void openLogFile();  // forward declarations
+static void closeBinLog();
+static bool binActive = false;
 
 static void startRecording() {
   if (isRecording) {
@@ -617,7 +661,9 @@ static void stopRecording() {
   }
   unsigned long duration = millis() - startRecord;
   isRecording = false;
-  if (logFile) {
+  if (binActive) {
+    closeBinLog();
+  } else if (logFile) {
     logFile.flush();
     logFile.close();
   }
@@ -733,27 +779,34 @@ static void readMPU9250() {
   }
 
   // --- Raw readings in chip frame ---
+  // Scale factors as reciprocals: a multiply instead of a soft-float
+  // divide per axis. 1/16384 is exact; 1/131 and 1/333.87 print the same
+  // as the divisions at logged precision for every raw value.
+  const float ACC_SCALE  = 1.0f / 16384.0f;
+  const float GYRO_SCALE = 1.0f / 131.0f;
+  const float TEMP_SCALE = 1.0f / 333.87f;
+
   // Accelerometer (bytes 0-5) — 2g full scale: raw / 16384.0 = g
   int16_t rawAx = ((int16_t)buf[0]  << 8) | buf[1];
   int16_t rawAy = ((int16_t)buf[2]  << 8) | buf[3];
   int16_t rawAz = ((int16_t)buf[4]  << 8) | buf[5];
   float chipAcc[3];
-  chipAcc[0] = (float)rawAx / 16384.0 - cal.accelBias[0];
-  chipAcc[1] = (float)rawAy / 16384.0 - cal.accelBias[1];
-  chipAcc[2] = (float)rawAz / 16384.0 - cal.accelBias[2];
+  chipAcc[0] = (float)rawAx * ACC_SCALE - cal.accelBias[0];
+  chipAcc[1] = (float)rawAy * ACC_SCALE - cal.accelBias[1];
+  chipAcc[2] = (float)rawAz * ACC_SCALE - cal.accelBias[2];
 
   // Temperature (bytes 6-7) — degrees Celsius
   int16_t rawTemp = ((int16_t)buf[6] << 8) | buf[7];
-  data.imuTemp = (float)rawTemp / 333.87 + 21.0;
+  data.imuTemp = (float)rawTemp * TEMP_SCALE + 21.0;
 
   // Gyroscope (bytes 8-13) — 250dps full scale: raw / 131.0 = deg/s
   int16_t rawGx = ((int16_t)buf[8]  << 8) | buf[9];
   int16_t rawGy = ((int16_t)buf[10] << 8) | buf[11];
   int16_t rawGz = ((int16_t)buf[12] << 8) | buf[13];
   float chipGyro[3];
-  chipGyro[0] = (float)rawGx / 131.0 - cal.gyroBias[0];
-  chipGyro[1] = (float)rawGy / 131.0 - cal.gyroBias[1];
-  chipGyro[2] = (float)rawGz / 131.0 - cal.gyroBias[2];
+  chipGyro[0] = (float)rawGx * GYRO_SCALE - cal.gyroBias[0];
+  chipGyro[1] = (float)rawGy * GYRO_SCALE - cal.gyroBias[1];
+  chipGyro[2] = (float)rawGz * GYRO_SCALE - cal.gyroBias[2];
 
   // Magnetometer — separate AK8963 I2C device (0x0C)
   // Uses library call for data-ready check, overflow detection,
@@ -789,147 +842,249 @@ static void readMPU9250() {
 // ISP2 — Innovate Serial Protocol 2
 //----------------------------------------------------------------
 
-// Process a complete ISP2 data packet into the SensorData struct.
-// Walks word-by-word detecting LC-1 (bit 14 set) vs aux (bits 15-14 = 00).
-// LC-1 sub-packets are 2 words: header + lambda.
-// Aux sub-packets are 1 word: 10-bit sensor value.
-// Channel order follows the physical ISP2 daisy-chain:
-//   SSI-4#1: aux0=coolant, aux1=oilp
-//   LC-1#1:  AFR bank 1
-//   LC-1#2:  AFR bank 2
-//   SSI-4#2: aux2=MAP, aux3=VSS (vehicle speed, frequency mode)
-static void processISP2Data() {
-  uint8_t auxIdx = 0;
-  uint8_t lc1Idx = 0;
-  float auxV[8];
-  float afrVal[4];
-
-  int w = 0;
-  while (w < isp2PacketLen) {
-    byte hi = isp2Data[w * 2];
-    byte lo = isp2Data[w * 2 + 1];
-
-    if (hi & ISP2_LC1_FLAG) {
-      // LC-1 header word: func(bits 12-10), afrMult(bits 8,6-0)
-      int func    = (hi >> 2) & 0x07;
-      int afrMult = ((hi & 0x01) << 7) | (lo & 0x7F);
-
-      // Next word is lambda
-      w++;
-      if (w >= isp2PacketLen) break;
-      hi = isp2Data[w * 2];
-      lo = isp2Data[w * 2 + 1];
-
-      int lambda = ((hi & 0x3F) << 7) | (lo & 0x7F);
-
-      if (lc1Idx < 4) {
-        if (func <= 1) {
-          // func 0: lambda valid, func 1: O2 level
-          afrVal[lc1Idx] = ((float)(lambda + 500) * (float)afrMult) / 10000.0;
-        } else {
-          afrVal[lc1Idx] = 0.0; // calibrating/warming/error
-        }
+#ifdef ISP2_RX_ISR
+// USART2 RX interrupt: hunts for the header sync bits and collects each
+// packet byte by byte, so loop() only ever sees complete candidates:
+//   [header hi][header lo][payload len*2][rx µs, 4 bytes LE]
+// A packet is committed (isp2RingHead moved) when its last byte lands,
+// stamped with that byte's arrival time, so a late loop() no longer skews
+// the interval stats. A packet that would not fit is skipped whole and
+// counted as an overflow; nothing half-written is ever visible.
+// Same sync/length/timeout rules as ISP2Parser, counted the same way.
+#define ISP2_RING_MASK  (ISP2_RX_RING - 1)
+#define ISP2_RX_STAMP   4
+
+enum ISP2RxState : uint8_t { RX_HIGH, RX_LOW, RX_PAYLOAD, RX_SKIP };
+
+static uint8_t           isp2Ring[ISP2_RX_RING];
+static volatile uint16_t isp2RingHead = 0;   // end of committed packets (ISR)
+static volatile uint16_t isp2RingTail = 0;   // next byte to read (loop)
+
+// ISR-only framing state
+static uint8_t  isp2RxState = RX_HIGH;
+static uint8_t  isp2RxHigh;
+static uint8_t  isp2RxLeft;                  // payload bytes still to come
+static uint16_t isp2RxWr;                    // write position in the ring
+static uint32_t isp2RxLastUs;
+
+// ISR counters, moved into isp2.stats by isp2RxCollect()
+struct ISP2RxCounts {
+  uint16_t bytes;        // received but not part of a committed packet
+  uint16_t discarded;
+  uint16_t syncLosses;
+  uint16_t timeouts;
+  uint16_t badLengths;
+  uint16_t overflows;    // USART data overrun or ring full
+};
+static volatile ISP2RxCounts isp2Rx = {};
+
+static void isp2RxBegin() {
+  // 19200 8N1, double speed (same divisor as HardwareSerial::begin)
+  uint16_t ubrr = (F_CPU / 4 / ISP2_BAUD - 1) / 2;
+  UCSR2A = _BV(U2X2);
+  UBRR2H = ubrr >> 8;
+  UBRR2L = ubrr;
+  UCSR2C = _BV(UCSZ21) | _BV(UCSZ20);
+  UCSR2B = _BV(RXEN2) | _BV(RXCIE2);
+}
+
+// Drop the packet being collected; its bytes count as received
+static inline void isp2RxAbort() {
+  if (isp2RxState == RX_LOW) {
+    isp2Rx.bytes++;
+    isp2Rx.discarded++;
+  } else if (isp2RxState == RX_PAYLOAD) {
+    isp2Rx.bytes += (isp2RxWr - isp2RingHead) & ISP2_RING_MASK;
+  }
+  isp2RxState = RX_HIGH;
+}
+
+ISR(USART2_RX_vect) {
+  bool overrun = UCSR2A & _BV(DOR2);
+  uint8_t b = UDR2;
+  uint32_t nowUs = micros();
+
+  if (isp2RxState >= RX_PAYLOAD && nowUs - isp2RxLastUs > ISP2_TIMEOUT_MS * 1000UL) {
+    isp2Rx.timeouts++;
+    isp2RxAbort();
+  }
+  isp2RxLastUs = nowUs;
+  if (overrun) {
+    // A byte was lost in hardware: the packet in progress is short
+    isp2Rx.overflows++;
+    isp2RxAbort();
+  }
+
+  switch (isp2RxState) {
+    case RX_HIGH:
+      if ((b & ISP2_H_SYNC_MASK) == ISP2_H_SYNC_MASK) {
+        isp2RxHigh = b;
+        isp2RxState = RX_LOW;
+      } else {
+        isp2Rx.bytes++;
+        isp2Rx.discarded++;
       }
-      lc1Idx++;
-    } else {
-      // Aux sensor word: 10-bit value in bits 9-0
-      int raw = ((hi & 0x07) << 7) | (lo & 0x7F);
-      if (auxIdx < 8) {
-        auxV[auxIdx] = (float)raw / 1023.0 * 5.0;
+      break;
+
+    case RX_LOW: {
+      if ((b & ISP2_L_SYNC_MASK) != ISP2_L_SYNC_MASK) {
+        isp2Rx.bytes += 2;
+        isp2Rx.discarded += 2;
+        isp2Rx.syncLosses++;
+        isp2RxState = RX_HIGH;
+        break;
+      }
+      uint8_t len = ((isp2RxHigh & 0x01) << 7) | (b & 0x7F);
+      if (len == 0 || len > ISP2_MAX_WORDS) {
+        isp2Rx.bytes += 2;
+        isp2Rx.badLengths++;
+        isp2RxState = RX_HIGH;
+        break;
+      }
+      isp2RxLeft = len * 2;
+      uint16_t head = isp2RingHead;
+      uint16_t room = (isp2RingTail - head - 1) & ISP2_RING_MASK;
+      if (room < 2 + isp2RxLeft + ISP2_RX_STAMP) {
+        isp2Rx.bytes += 2;
+        isp2Rx.overflows++;
+        isp2RxState = RX_SKIP;
+        break;
       }
-      auxIdx++;
+      isp2Ring[head] = isp2RxHigh;
+      isp2Ring[(head + 1) & ISP2_RING_MASK] = b;
+      isp2RxWr = (head + 2) & ISP2_RING_MASK;
+      isp2RxState = RX_PAYLOAD;
+      break;
     }
-    w++;
+
+    case RX_PAYLOAD:
+      isp2Ring[isp2RxWr] = b;
+      isp2RxWr = (isp2RxWr + 1) & ISP2_RING_MASK;
+      if (--isp2RxLeft == 0) {
+        for (uint8_t i = 0; i < ISP2_RX_STAMP; i++) {
+          isp2Ring[isp2RxWr] = nowUs >> (8 * i);
+          isp2RxWr = (isp2RxWr + 1) & ISP2_RING_MASK;
+        }
+        isp2RingHead = isp2RxWr;
+        isp2RxState = RX_HIGH;
+      }
+      break;
+
+    default:  // RX_SKIP: payload of a packet that did not fit
+      isp2Rx.bytes++;
+      if (--isp2RxLeft == 0) isp2RxState = RX_HIGH;
+      break;
   }
+}
+
+// Move the ISR counters into the parser's stats ('i' command)
+static void isp2RxCollect(ISP2Stats &s) {
+  ISP2RxCounts c;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    c.bytes      = isp2Rx.bytes;
+    c.discarded  = isp2Rx.discarded;
+    c.syncLosses = isp2Rx.syncLosses;
+    c.timeouts   = isp2Rx.timeouts;
+    c.badLengths = isp2Rx.badLengths;
+    c.overflows  = isp2Rx.overflows;
+    memset((void *)&isp2Rx, 0, sizeof(isp2Rx));
+  }
+  s.bytes      += c.bytes;
+  s.discarded  += c.discarded;
+  s.syncLosses += c.syncLosses;
+  s.timeouts   += c.timeouts;
+  s.badLengths += c.badLengths;
+  s.overflows  += c.overflows;
+}
 
-  isp2AuxCount = auxIdx;
-  isp2Lc1Count = lc1Idx;
+// Copy the oldest committed packet (header + payload) out of the ring.
+// Returns its length in bytes, 0 if none is waiting.
+static uint8_t isp2RxPop(uint8_t *pkt, uint32_t &rxUs) {
+  uint16_t head;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { head = isp2RingHead; }
+  uint16_t tail = isp2RingTail;
+  if (tail == head) return 0;
+
+  uint8_t len = ((isp2Ring[tail] & 0x01) << 7) | (isp2Ring[(tail + 1) & ISP2_RING_MASK] & 0x7F);
+  uint8_t n = 2 + len * 2;
+  for (uint8_t i = 0; i < n; i++) pkt[i] = isp2Ring[(tail + i) & ISP2_RING_MASK];
+  tail = (tail + n) & ISP2_RING_MASK;
+
+  rxUs = 0;
+  for (uint8_t i = 0; i < ISP2_RX_STAMP; i++) {
+    rxUs |= (uint32_t)isp2Ring[tail] << (8 * i);
+    tail = (tail + 1) & ISP2_RING_MASK;
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { isp2RingTail = tail; }
+  return n;
+}
+#else
+// Byte source for the parser: only bytes already in the serial buffer,
+// so a read never blocks.
+struct ISP2SerialSource {
+  size_t read(uint8_t *buf, size_t max) {
+    size_t n = 0;
+    while (n < max && isp2Serial.available() > 0) buf[n++] = isp2Serial.read();
+    return n;
+  }
+};
+#endif
 
-  // Map aux channels to SensorData (daisy-chain order)
-  if (auxIdx >= 1) data.coolant = AUX_COOLANT_F(auxV[0]);
-  if (auxIdx >= 2) data.oilp    = AUX_OILP_PSI(auxV[1]);
-  if (auxIdx >= 3) data.map     = AUX_MAP_INHG(auxV[2]);
-  if (auxIdx >= 4) data.vss     = AUX_VSS_MPH(auxV[3]);
+// Packets go straight into SensorData through the compile-time map
+// for the physical daisy-chain (ISP2NovaSink):
+//   SSI-4#1: aux0=coolant, aux1=oilp
+//   LC-1#1:  AFR bank 1
+//   LC-1#2:  AFR bank 2
+//   SSI-4#2: aux2=MAP, aux3=VSS (vehicle speed, frequency mode)
+struct ISP2DataSink : ISP2NovaSink<SensorData> {
+  ISP2DataSink() : ISP2NovaSink<SensorData>(data) {}
 
-  // Map LC-1 devices to AFR
-  if (lc1Idx >= 1) data.afr  = afrVal[0];
-  if (lc1Idx >= 2) data.afr1 = afrVal[1];
+  void done(const ISP2Parser &p, ISP2Layout layout) {
+    isp2AuxCount = layout.auxCount;
+    isp2Lc1Count = layout.lc1Count;
+    engineValidate(engineVal, data, p.stats.lastPacketUs);
 
 #ifdef ISP2_DEBUG
-  DEBUG_PORT.print(F("ISP2: "));
-  DEBUG_PORT.print(lc1Idx); DEBUG_PORT.print(F("xLC1 "));
-  DEBUG_PORT.print(auxIdx); DEBUG_PORT.print(F("xAUX | "));
-  DEBUG_PORT.print(F("AFR=")); DEBUG_PORT.print(data.afr, 1);
-  DEBUG_PORT.print(F(" AFR1=")); DEBUG_PORT.print(data.afr1, 1);
-  DEBUG_PORT.print(F(" VSS=")); DEBUG_PORT.print(data.vss, 1);
-  DEBUG_PORT.print(F("mph MAP=")); DEBUG_PORT.print(data.map, 1);
-  DEBUG_PORT.print(F(" OIL=")); DEBUG_PORT.print(data.oilp, 0);
-  DEBUG_PORT.print(F(" CLT=")); DEBUG_PORT.println(data.coolant, 0);
+    DEBUG_PORT.print(F("ISP2: "));
+    DEBUG_PORT.print(layout.lc1Count); DEBUG_PORT.print(F("xLC1 "));
+    DEBUG_PORT.print(layout.auxCount); DEBUG_PORT.print(F("xAUX | "));
+    DEBUG_PORT.print(F("AFR=")); DEBUG_PORT.print(data.afr, 1);
+    DEBUG_PORT.print(F(" (")); DEBUG_PORT.print(lc1StatusName(data.afrStat));
+    DEBUG_PORT.print(F(") AFR1=")); DEBUG_PORT.print(data.afr1, 1);
+    DEBUG_PORT.print(F(" (")); DEBUG_PORT.print(lc1StatusName(data.afr1Stat));
+    DEBUG_PORT.print(')');
+    DEBUG_PORT.print(F(" VSS=")); DEBUG_PORT.print(data.vss, 1);
+    DEBUG_PORT.print(F("mph MAP=")); DEBUG_PORT.print(data.map, 1);
+    DEBUG_PORT.print(F(" OIL=")); DEBUG_PORT.print(data.oilp, 0);
+    DEBUG_PORT.print(F(" CLT=")); DEBUG_PORT.print(data.coolant, 0);
+    DEBUG_PORT.print(F(" Q=")); DEBUG_PORT.println(data.engQual, HEX);
 #endif
-}
+  }
+};
 
-// Non-blocking ISP2 serial read.
-// State machine: SYNC_HIGH → SYNC_LOW → READING_PAYLOAD → process.
-// Reads only bytes already in the hardware serial buffer — never blocks.
+// Non-blocking ISP2 read.
+// Mega: decode the packets the RX interrupt has framed, each at its own
+// arrival time. Uno: feed whatever AltSoftSerial holds; the parser
+// resyncs on its own if a payload stalls for ISP2_TIMEOUT_MS (cable
+// disconnect or corrupted stream).
 static void readISP2() {
 #ifdef TIMING_DEBUG
   long tm0 = millis();
 #endif
 
-  // Watchdog: if stuck mid-payload for too long, resync
-  // This catches ISP2 cable disconnects or corrupted streams
-  if (isp2State == ISP2_READING_PAYLOAD &&
-      (millis() - isp2LastByte > ISP2_TIMEOUT_MS)) {
-    isp2State = ISP2_SYNC_HIGH;
-  }
-
-  while (isp2Serial.available() > 0) {
-    byte b = isp2Serial.read();
-    isp2LastByte = millis();
-
-    switch (isp2State) {
-      case ISP2_SYNC_HIGH:
-        if ((b & ISP2_H_SYNC_MASK) == ISP2_H_SYNC_MASK) {
-          isp2Header[0] = b;
-          isp2State = ISP2_SYNC_LOW;
-        }
-        break;
-
-      case ISP2_SYNC_LOW:
-        if ((b & ISP2_L_SYNC_MASK) == ISP2_L_SYNC_MASK) {
-          // Header complete — extract packet info
-          isp2Header[1] = b;
-          isp2IsData = bitRead(isp2Header[0], 4);
-          isp2PacketLen = ((isp2Header[0] & 0x01) << 7) | (isp2Header[1] & 0x7F);
-
-          if (isp2PacketLen > 0 && isp2PacketLen <= ISP2_MAX_WORDS) {
-            isp2BytesExpected = isp2PacketLen * 2;
-            isp2BytesRead = 0;
-            isp2State = ISP2_READING_PAYLOAD;
-          } else {
-            isp2State = ISP2_SYNC_HIGH;  // invalid length, resync
-          }
-        } else if ((b & ISP2_H_SYNC_MASK) == ISP2_H_SYNC_MASK) {
-          // Not a valid low byte, but could be a new high sync
-          isp2Header[0] = b;
-          // stay in ISP2_SYNC_LOW
-        } else {
-          isp2State = ISP2_SYNC_HIGH;
-        }
-        break;
+  ISP2DataSink sink;
+#ifdef ISP2_RX_ISR
+  uint8_t pkt[2 + ISP2_MAX_WORDS * 2];
+  uint32_t rxUs;
+  uint8_t n;
+  while ((n = isp2RxPop(pkt, rxUs)) > 0) isp2.feed(pkt, n, rxUs, sink);
+  isp2RxCollect(isp2.stats);
+#else
+  if (isp2Serial.overflow()) isp2.stats.overflows++;  // AltSoftSerial only
 
-      case ISP2_READING_PAYLOAD:
-        isp2Data[isp2BytesRead++] = b;
-        if (isp2BytesRead >= isp2BytesExpected) {
-          // Packet complete — process and reset
-          if (isp2IsData) {
-            processISP2Data();
-          }
-          isp2State = ISP2_SYNC_HIGH;
-        }
-        break;
-    }
-  }
+  ISP2SerialSource src;
+  isp2.poll(src, micros(), sink);
+#endif
 
 #ifdef TIMING_DEBUG
   DEBUG_PORT.print(F("T readISP2 Start: "));
@@ -948,83 +1103,152 @@ static void setupSDCard() {
 
 static unsigned long lastFlush = 0;
 
+//----------------------------------------------------------------
+// Binary log: preallocated contiguous file written as raw sectors.
+// The record block is SdFat's own sector cache (free while no file
+// system call runs), so binary mode costs no extra 512 bytes of SRAM.
+//----------------------------------------------------------------
+static bool binEnabled = LOG_BINARY_DEFAULT;
+static uint8_t *binBlock = NULL;        // SdFat cache while recording
+static uint8_t binFill = 0;             // records in binBlock
+static uint32_t binSector = 0;          // next sector to write
+static uint32_t binEndSector = 0;       // last preallocated sector
+static uint32_t binFirstSector = 0;
+
+static bool openBinLog(const char *fname) {
+  if (!logFile.open(fname, O_RDWR | O_CREAT | O_EXCL)) return false;
+  if (!logFile.preAllocate(BINLOG_PREALLOC) ||
+      !logFile.contiguousRange(&binFirstSector, &binEndSector)) {
+    DEBUG_PORT.println(F("ERR: .bin preallocation failed (card full or fragmented)"));
+    logFile.close();
+    sd.remove(fname);
+    return false;
+  }
+  // Erase so stale sectors from old files never read as records
+  sd.card()->erase(binFirstSector, binEndSector);
+
+  binBlock = sd.vol()->cacheClear();
+  if (!binBlock) {
+    logFile.close();
+    sd.remove(fname);
+    return false;
+  }
+  memset(binBlock, 0, BINLOG_BLOCK);
+  binlogHeaderInit(*(BinlogHeader *)binBlock, BINLOG_SRC_AVR, SAMPLE_INTERVAL,
+                   datebuf, FW_VERSION);
+  if (!sd.card()->writeStart(binFirstSector) || !sd.card()->writeData(binBlock)) {
+    sd.card()->writeStop();
+    logFile.close();
+    sd.remove(fname);
+    return false;
+  }
+  binSector = binFirstSector + 1;
+  binFill = 0;
+  binActive = true;
+  return true;
+}
+
+// Queue one record; a full block goes straight to the next sector.
+// Returns false when the card rejects a write or the file is full.
+static bool writeBinRecord(uint32_t elapsedMs) {
+  BinlogRecord *r = (BinlogRecord *)binBlock + binFill;
+  binlogEncode(*r, data, elapsedMs, keyframePending ? keyframeCount : 0);
+  keyframePending = false;
+  if (++binFill < BINLOG_PER_BLOCK) return true;
+
+  binFill = 0;
+  if (binSector > binEndSector) {
+    DEBUG_PORT.println(F("ERR: .bin preallocation full"));
+    return false;
+  }
+  if (!sd.card()->writeData(binBlock)) return false;
+  binSector++;
+  return true;
+}
+
+// Write the partial block, end the multi-sector write and trim the
+// file to what was written
+static void closeBinLog() {
+  if (binFill > 0 && binSector <= binEndSector) {
+    memset(binBlock + binFill * sizeof(BinlogRecord), 0,
+           BINLOG_BLOCK - binFill * sizeof(BinlogRecord));
+    if (sd.card()->writeData(binBlock)) binSector++;
+  }
+  sd.card()->writeStop();
+  binActive = false;
+  binBlock = NULL;
+  logFile.truncate((binSector - binFirstSector) * (uint32_t)BINLOG_BLOCK);
+  logFile.close();
+}
+
 static void openLogFile() {
-  if (!SD.begin(SD_CS_PIN)) {
+  if (!sd.begin(SD_CS_PIN)) {
     DEBUG_PORT.println(F("ERR: SD card failed or not present"));
     return;
   }
 
   // Build filename using char buffer instead of String
+  const char *ext = binEnabled ? "bin" : "csv";
   char fname[24];
   int index = 0;
-  snprintf(fname, sizeof(fname), "%s_%d.csv", filenameBuf, index);
+  snprintf(fname, sizeof(fname), "%s_%d.%s", filenameBuf, index, ext);
 
-  while (SD.exists(fname)) {
+  while (sd.exists(fname)) {
     index++;
-    snprintf(fname, sizeof(fname), "%s_%d.csv", filenameBuf, index);
+    snprintf(fname, sizeof(fname), "%s_%d.%s", filenameBuf, index, ext);
   }
 
   DEBUG_PORT.print(F("INF: Opening log "));
   DEBUG_PORT.println(fname);
-  logFile = SD.open(fname, FILE_WRITE);
+  if (binEnabled) {
+    if (openBinLog(fname)) {
+      strncpy(logFilename, fname, sizeof(logFilename) - 1);
+      logFilename[sizeof(logFilename) - 1] = '\0';
+    }
+    return;
+  }
+  logFile = sd.open(fname, FILE_WRITE);
   if (logFile) {
     strncpy(logFilename, fname, sizeof(logFilename) - 1);
     logFilename[sizeof(logFilename) - 1] = '\0';
     logFile.println(datebuf);
-    logFile.println(F("time,lat,lon,speed,alt,dir,sats,accx,accy,accz,rotx,roty,rotz,magx,magy,magz,imuTemp,afr,afr1,vss,map,oilp,coolant,gpsStale,keyframe"));
-    logFile.println(F("(s),(deg),(deg),(mph),(ft),(deg),(#),(g),(g),(g),(dps),(dps),(dps),(uT),(uT),(uT),(C),(afr),(afr),(mph),(inHgVac),(psig),(F),(flag),(#)"));
+    logFile.println(F(AB_CSV_HEADER));
+    logFile.println(F(AB_CSV_UNITS));
     logFile.flush();
     lastFlush = millis();
   }
 }
 
-// Write a single data row to a Print target (Serial or File)
-static void printRow(Print &out, float now) {
-  out.print(now, 3);          out.print(',');
-  printDegE7(out, data.lat);      out.print(',');
-  printDegE7(out, data.lon);      out.print(',');
-  out.print(data.speed);      out.print(',');
-  out.print(data.alt);        out.print(',');
-  out.print(data.dir);        out.print(',');
-  out.print(data.satellites);  out.print(',');
-  out.print(data.accx);       out.print(',');
-  out.print(data.accy);       out.print(',');
-  out.print(data.accz);       out.print(',');
-  out.print(data.rotx);       out.print(',');
-  out.print(data.roty);       out.print(',');
-  out.print(data.rotz);       out.print(',');
-  out.print(data.magx);       out.print(',');
-  out.print(data.magy);       out.print(',');
-  out.print(data.magz);       out.print(',');
-  out.print(data.imuTemp, 1); out.print(',');
-  out.print(data.afr);        out.print(',');
-  out.print(data.afr1);       out.print(',');
-  out.print(data.vss);        out.print(',');
-  out.print(data.map);        out.print(',');
-  out.print(data.oilp);       out.print(',');
-  out.print(data.coolant);    out.print(',');
-  out.print(data.gpsStale ? 1 : 0);
-  out.print(',');
+// Write a single data row to a Print target (Serial or File), one
+// field per channels.h row. Floats go through printFixed: same text as
+// print(float), no divides.
+#define CSV_TIME(m, dg)  printMillis(out, elapsedMs)
+#define CSV_KEY(m, dg)   out.print(keyframe)
+#define CSV_DEG(m, dg)   printDegE7(out, data.m)
+#define CSV_F(m, dg)     printFixed(out, data.m, dg)
+#define CSV_U8(m, dg)    out.print(data.m)
+#define CSV_BOOL(m, dg)  out.print(data.m ? 1 : 0)
+#define CSV_FIELD(name, unit, m, type, store, dg, group, json)  CSV_##type(m, dg);
+
+static void printRow(Print &out, uint32_t elapsedMs) {
   // Keyframe column: 0 = normal row, N = keyframe marker number
-  if (keyframePending) {
-    out.println(keyframeCount);
-    keyframePending = false;
-  } else {
-    out.println(0);
-  }
+  uint16_t keyframe = keyframePending ? keyframeCount : 0;
+  keyframePending = false;
+  AB_CHANNELS(CSV_FIELD, out.print(',');)
+  out.println();
 }
 
 // Compact human-readable live debug output, rate-limited to 2Hz.
 // Format: single line with fixed-width fields so terminal doesn't jump.
 // Shows the most important values at a glance while tuning.
 static unsigned long lastLiveDebug = 0;
-static void printLiveDebug(float now) {
+static void printLiveDebug(uint32_t elapsedMs) {
   // 2Hz update rate — fast enough to see changes, slow enough to read
   if (millis() - lastLiveDebug < 500) return;
   lastLiveDebug = millis();
 
   // Time and recording indicator
-  DEBUG_PORT.print(now, 1);
+  printFixed(DEBUG_PORT, (float)elapsedMs / 1000.0, 1);
   DEBUG_PORT.print(isRecording ? F("s [REC] ") : F("s       "));
 
   // Speed and GPS quality
@@ -1073,7 +1297,7 @@ static void writeToLog() {
 #ifdef TIMING_DEBUG
   long tm0 = millis();
 #endif
-  float now = (float)(millis() - startRecord) / 1000.0;
+  uint32_t elapsedMs = millis() - startRecord;
 
   // GPS staleness check
   if (lastGPS == 0 || (millis() - lastGPS > GPS_STALE_MS)) {
@@ -1086,9 +1310,9 @@ static void writeToLog() {
 
   // Serial debug output (compile-time or runtime toggle)
 #ifdef SERIAL_DEBUG
-  printRow(DEBUG_PORT, now);
+  printRow(DEBUG_PORT, elapsedMs);
 #else
-  if (liveDebug) printLiveDebug(now);
+  if (liveDebug) printLiveDebug(elapsedMs);
 #endif
 
   if (isRecording) {
@@ -1096,12 +1320,22 @@ static void writeToLog() {
       // No file open — skip this sample (file is opened in startRecording)
       return;
     }
-    printRow(logFile, now);
-    logRowCount++;
+    if (binActive) {
+      // Raw sectors: nothing to flush, no FAT update until stop
+      if (!writeBinRecord(elapsedMs)) {
+        DEBUG_PORT.println(F("ERR: SD write fail, stopping recording"));
+        stopRecording();
+        return;
+      }
+      logRowCount++;
+    } else {
+      printRow(logFile, elapsedMs);
+      logRowCount++;
+    }
     // Flush every 1 second instead of every row
-    if (millis() - lastFlush > FLUSH_INTERVAL) {
+    if (!binActive && millis() - lastFlush > FLUSH_INTERVAL) {
       logFile.flush();
-      // SD library sets write error flag on failure
+      // SdFat sets write error flag on failure
       if (logFile.getWriteError()) {
         sdErrorCount++;
         logFile.clearWriteError();
@@ -1191,6 +1425,7 @@ static void handleSerial() {
         DEBUG_PORT.println(F("  r  Start recording to SD card"));
         DEBUG_PORT.println(F("  s  Stop recording (prints session summary)"));
         DEBUG_PORT.println(F("  k  Insert keyframe marker into log"));
+        DEBUG_PORT.println(F("  b  Toggle binary log (.bin, next recording)"));
         DEBUG_PORT.println(F(" Display:"));
         DEBUG_PORT.println(F("  d  Toggle live debug stream (2Hz)"));
         DEBUG_PORT.println(F("  p  Sensor snapshot (all values once)"));
@@ -1211,6 +1446,12 @@ static void handleSerial() {
       case 's':  // Stop recording
         stopRecording();
         break;
+      case 'b':  // Toggle binary log format
+        binEnabled = !binEnabled;
+        DEBUG_PORT.print(F("INF: Log format "));
+        DEBUG_PORT.print(binEnabled ? F("binary (.bin)") : F("CSV"));
+        DEBUG_PORT.println(isRecording ? F(" (from next recording)") : F(""));
+        break;
       case 'p':  // Print current sensor snapshot
         DEBUG_PORT.println(F("--- Sensor Snapshot ---"));
         DEBUG_PORT.print(F("GPS: "));
@@ -1265,17 +1506,41 @@ static void handleSerial() {
         break;
       case 'i':  // Print ISP2 diagnostics
         DEBUG_PORT.print(F("ISP2 state: "));
-        DEBUG_PORT.println(isp2State);
+        DEBUG_PORT.println(isp2.state);
         DEBUG_PORT.print(F("LC1 devices: "));
         DEBUG_PORT.println(isp2Lc1Count);
         DEBUG_PORT.print(F("Aux channels: "));
         DEBUG_PORT.println(isp2AuxCount);
         DEBUG_PORT.print(F("AFR: ")); DEBUG_PORT.print(data.afr, 1);
-        DEBUG_PORT.print(F(" AFR1: ")); DEBUG_PORT.println(data.afr1, 1);
+        DEBUG_PORT.print(F(" (")); DEBUG_PORT.print(lc1StatusName(data.afrStat));
+        DEBUG_PORT.print(' '); DEBUG_PORT.print(data.afrDetail);
+        DEBUG_PORT.print(F(")  AFR1: ")); DEBUG_PORT.print(data.afr1, 1);
+        DEBUG_PORT.print(F(" (")); DEBUG_PORT.print(lc1StatusName(data.afr1Stat));
+        DEBUG_PORT.print(' '); DEBUG_PORT.print(data.afr1Detail);
+        DEBUG_PORT.println(')');
         DEBUG_PORT.print(F("VSS: ")); DEBUG_PORT.print(data.vss, 1); DEBUG_PORT.print(F("mph"));
         DEBUG_PORT.print(F(" MAP: ")); DEBUG_PORT.print(data.map, 1);
         DEBUG_PORT.print(F(" OIL: ")); DEBUG_PORT.print(data.oilp, 0);
         DEBUG_PORT.print(F(" CLT: ")); DEBUG_PORT.println(data.coolant, 0);
+        DEBUG_PORT.print(F("Bytes: ")); DEBUG_PORT.print(isp2.stats.bytes);
+        DEBUG_PORT.print(F(" Packets: ")); DEBUG_PORT.print(isp2.stats.packets);
+        DEBUG_PORT.print(F(" (+")); DEBUG_PORT.print(isp2.stats.otherPackets);
+        DEBUG_PORT.print(F(" non-data) Discarded: ")); DEBUG_PORT.println(isp2.stats.discarded);
+        DEBUG_PORT.print(F("Sync losses: ")); DEBUG_PORT.print(isp2.stats.syncLosses);
+        DEBUG_PORT.print(F(" Timeouts: ")); DEBUG_PORT.print(isp2.stats.timeouts);
+        DEBUG_PORT.print(F(" Bad lengths: ")); DEBUG_PORT.print(isp2.stats.badLengths);
+        DEBUG_PORT.print(F(" Overflows: ")); DEBUG_PORT.println(isp2.stats.overflows);
+        DEBUG_PORT.print(F("Interval ms: min ")); DEBUG_PORT.print(isp2.stats.intervalMinUs / 1000.0, 1);
+        DEBUG_PORT.print(F(" avg ")); DEBUG_PORT.print(isp2StatsMeanUs(isp2.stats) / 1000.0, 1);
+        DEBUG_PORT.print(F(" max ")); DEBUG_PORT.println(isp2.stats.intervalMaxUs / 1000.0, 1);
+        DEBUG_PORT.print(F("Missed frames: ")); DEBUG_PORT.print(isp2.stats.missedFrames);
+        DEBUG_PORT.print(F(" Outages: ")); DEBUG_PORT.print(isp2.stats.outages);
+        DEBUG_PORT.print(F(" Capture: ")); DEBUG_PORT.print(isp2StatsCapturePct(isp2.stats), 2);
+        DEBUG_PORT.println('%');
+        DEBUG_PORT.print(F("Rejected: ")); DEBUG_PORT.print(engineVal.rangeRejects);
+        DEBUG_PORT.print(F(" range ")); DEBUG_PORT.print(engineVal.rateRejects);
+        DEBUG_PORT.print(F(" rate ")); DEBUG_PORT.print(engineVal.crossRejects);
+        DEBUG_PORT.println(F(" VSS/GPS"));
         break;
       case 'c':  // Calibrate accelerometer (place sensor level, hold still)
         if (isRecording) {
@@ -1422,7 +1687,11 @@ void setup() {
   // u-blox resets to 9600 on every power cycle, so we always reconfigure.
   configureGPS();
 
-  isp2Serial.begin(19200);
+#ifdef ISP2_RX_ISR
+  isp2RxBegin();
+#else
+  isp2Serial.begin(ISP2_BAUD);
+#endif
   DEBUG_PORT.println(F("INF: ISP2 @ 19200"));
 
   setupSDCard();
@@ -1463,9 +1732,9 @@ void loop() {
   processLed();
   processButtons();
 
-  // Drain ISP2 serial buffer every iteration to prevent overflow.
-  // At 19200 baud the 64-byte hardware buffer fills in ~267ms;
-  // calling only at 80ms intervals risks drops during busy loops.
+  // Decode ISP2 every iteration. On the Mega the RX interrupt buffers
+  // ~1.4 s of packets, so SD flushes no longer drop any; on the Uno the
+  // 80-byte AltSoftSerial buffer still needs frequent draining.
   readISP2();
 
   if ((long)(millis() - nextSample) >= 0) {
@@ -37,10 +37,30 @@
 #define GPS_BAUD_INIT    9600
 #define GPS_BAUD_FAST    115200
 
-// ISP2 (Innovate Motorsports) on UART2
-#define ISP2_UART_NUM    2
-#define ISP2_TX_PIN      15    // Assigned but unused (ISP2 is receive-only)
-#define ISP2_RX_PIN      16
+// ISP2 (Innovate Motorsports) chains, one UART each, chain 0 = main
+//   chain 0 on UART2: Nova chain (LC-1 ×2, SSI-4 ×2)
+//   chain 1 on UART0: SSI-4 #3 (EGT, fuel pressure) — opt-in, build
+//                     with -DISP2_CHAINS=2
+// Chain 1 borrows UART0, the S3's ROM/IDF console UART (GPIO43 TX,
+// GPIO44 RX; Serial is USB-CDC, so nothing of ours uses it). Only RX is
+// claimed: the ROM boot banner and any ESP-IDF log output still leave
+// on GPIO43, which must stay unconnected. Bytes the SSI-4 sends during
+// reset are ignored by the ROM on a normal boot; in download mode (BOOT
+// held) unplug the chain so they don't disturb flashing.
+#ifndef ISP2_CHAINS
+#define ISP2_CHAINS      1
+#endif
+#if ISP2_CHAINS > 1
+#define ISP2_UART_NUMS   { 2, 0 }
+#define ISP2_RX_PINS     { 16, 44 }
+#define ISP2_TX_PINS     { 15, -1 }  // Chain 0 TX used only by pass-through (host → chain IN)
+#else
+#define ISP2_UART_NUMS   { 2 }
+#define ISP2_RX_PINS     { 16 }
+#define ISP2_TX_PINS     { 15 }      // Used only by pass-through (host → chain IN)
+#endif
+#define ISP2_READ_CHUNK  128   // Bytes per UART read in the ISP2 task
+#define ISP2_STALE_MS    500   // No packet for this long: the chain's channels are not live
 
 //----------------------------------------------------------------
 // I2C Pin Assignments (MPU9250)
@@ -49,6 +69,27 @@
 #define I2C_SCL_PIN      9
 #define I2C_CLOCK_HZ     400000   // 400kHz fast mode
 
+//----------------------------------------------------------------
+// Gyro bias — temperature model learned at stops (tuning in gyro_bias.h)
+//----------------------------------------------------------------
+#define GYRO_MODEL_SAVE_DPS  0.05f   // Rewrite NVS only when the offset moved more than this
+#define GYRO_MODEL_SAVE_MS   600000  // ...and at most every 10 min (flash wear)
+#define GYRO_MODEL_AGREE_DPS 0.1f    // First model: two still windows this close before NVS
+
+//----------------------------------------------------------------
+// Accel/mag calibration — fed by the sensor task ('c' / 'm')
+//----------------------------------------------------------------
+#define IMU_CAL_ACCEL_SAMPLES 32       // Averaged (~2.5s at SAMPLE_INTERVAL)
+#define IMU_CAL_ACCEL_VAR     0.0004f  // g² per axis: over 0.02 g rms = moved, not saved
+#define IMU_CAL_MAG_MS        15000UL  // Tumble time
+
+//----------------------------------------------------------------
+// Engine RPM from vibration — 1 kHz accel FIFO (tuning in vib_rpm.h)
+//----------------------------------------------------------------
+#define ENGINE_CYLINDERS  8        // 454 BBC V8 (docs/car/engine-spec.md): 4 firing pulses per turn
+#define IMU_FIFO_CHUNK    120      // Bytes per FIFO burst: 20 samples, under Wire's 128-byte buffer
+#define VIB_RPM_STALE_MS  1000     // No new window for this long (FIFO stopped) → rpm 0
+
 //----------------------------------------------------------------
 // SPI Pin Assignments (SD Card) — using VSPI / SPI2
 //----------------------------------------------------------------
@@ -77,6 +118,29 @@
 #define SAMPLE_INTERVAL  80      // Main loop sample period (ms) = 12.5 Hz
 #define SD_MAX_ERRORS    3       // Auto-stop recording after this many consecutive SD errors
 #define WS_BROADCAST_MS  200     // WebSocket broadcast interval (ms) = 5 Hz
+#define HISTORY_SECONDS  120     // Telemetry kept for newly connected dashboards (s)
+#define HISTORY_BLOCK_FRAMES 25  // Frames per delta block (one keyframe + deltas)
+#define WS_CMD_QUEUE_LEN 8       // Pending remote commands before "busy" acks
+#define WS_MAX_CLIENTS   8       // Dashboards served at once; more are refused
+
+//----------------------------------------------------------------
+// Binary log (.bin instead of .csv, serial 'b' toggles; binlog.h)
+//----------------------------------------------------------------
+#define LOG_BINARY_DEFAULT   false  // Binary records by default at each recording
+
+//----------------------------------------------------------------
+// Raw ISP2 capture (.isp side file, serial 'R' toggles)
+//----------------------------------------------------------------
+#define ISP2_CAPTURE_DEFAULT false  // Capture on by default at each recording
+#define ISP2_CAPTURE_BUF     8192   // ISP2 → SD task buffer (~4s at full line rate)
+
+//----------------------------------------------------------------
+// ISP2 pass-through to USB (serial 'P', exit with +++)
+//----------------------------------------------------------------
+#define PASSTHRU_BUF         2048   // ISP2 → serial task buffer (~1s at full line rate)
+#define PASSTHRU_CHUNK       256    // Bytes per USB write
+#define PASSTHRU_POLL_MS     10     // Serial task wait for chain data while active
+#define PASSTHRU_GUARD_MS    1000   // Silence around "+++" to exit
 
 //----------------------------------------------------------------
 // FreeRTOS Task Configuration
@@ -97,6 +161,10 @@
 #define TASK_WS_PRIORITY     2
 #define TASK_WS_CORE         0
 
+#define TASK_WSCMD_STACK     4096   // Remote commands (may open SD file)
+#define TASK_WSCMD_PRIORITY  3      // Above broadcast: keyframes land fast
+#define TASK_WSCMD_CORE      0
+
 #define TASK_SERIAL_STACK    4096
 #define TASK_SERIAL_PRIORITY 1
 #define TASK_SERIAL_CORE     0
@@ -105,13 +173,23 @@
 #define TASK_LED_PRIORITY    1
 #define TASK_LED_CORE        1
 
+// One-shot boot tasks (GPS reconfigure, WiFi AP + web server), run
+// while the sensor and logging tasks already work
+#define TASK_BOOT_STACK      6144
+#define TASK_BOOT_PRIORITY   1
+#define TASK_BOOT_CORE       0
+#define BOOT_SERIAL_WAIT_MS  100     // Wait this long at most for a USB host before the banner
+
 //----------------------------------------------------------------
 // Debug flags (uncomment to enable at compile time)
 //----------------------------------------------------------------
-//#define TIMING_DEBUG 1
+//#define TIMING_DEBUG 1     // Print task timing table every TIMING_DEBUG_MS
+#define TIMING_DEBUG_MS  5000
 //#define GPS_DEBUG 1
 //#define ISP2_DEBUG 1
 //#define SERIAL_DEBUG 1    // Print every data row to Serial (high bandwidth)
+//#define TRACE_ENABLE 1    // Event tracer for Perfetto (serial T/J, /api/trace)
+#define TRACE_EVENTS     4096    // Trace capture size (12 bytes each), ~20s of pipeline
 
 // Runtime debug toggle (controlled by 'd' serial command)
 #define LIVE_DEBUG_DEFAULT  true
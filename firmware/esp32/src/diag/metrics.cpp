@@ -0,0 +1,154 @@
+/**
+ *  Analog Bridge — Pipeline Metrics Implementation
+ *
+ *  Counter and histogram names follow Prometheus conventions:
+ *  ab_<subsystem>_<what>_total for counters, _us suffix for latency.
+ *  Scrape with e.g.:  curl http://analogbridge.local/api/metrics
+ */
+#include "metrics.h"
+#include "task_timing.h"
+#include "sensors/isp2.h"
+#include "web/web_server.h"
+#include "config.h"
+
+std::atomic<uint32_t> metricCounters[MC_COUNT];
+MetricHist metricHists[MH_COUNT];
+
+#define METRICS_MAX_TASKS 12
+static TaskHandle_t tasks[METRICS_MAX_TASKS];
+static uint8_t taskCount = 0;
+
+struct MetricInfo {
+  const char* family;   // metric name
+  const char* labels;   // label set without braces, or "" for none
+  const char* help;
+};
+
+// Same order as MetricCounter. Consecutive entries sharing a family
+// get one HELP/TYPE header.
+static const MetricInfo counterInfo[MC_COUNT] = {
+  {"ab_gps_bytes_total",           "", "Bytes received on the GPS UART"},
+  {"ab_gps_sentences_total",       "", "NMEA sentences with a valid checksum"},
+  {"ab_gps_checksum_fails_total",  "", "NMEA sentences with a bad checksum"},
+  {"ab_gps_epochs_total",          "", "GPS location updates"},
+  {"ab_sd_rows_total",             "", "CSV rows written to SD"},
+  {"ab_sd_errors_total",           "", "SD flush write errors"},
+  {"ab_ws_frames_sent_total",      "", "WebSocket frames queued to clients"},
+  {"ab_ws_frames_dropped_total",   "", "WebSocket frames skipped, summed over clients (send queue full)"},
+  {"ab_imu_fifo_overflows_total",  "", "IMU accel FIFO overflows (RPM window restarted)"},
+};
+
+static const MetricInfo histInfo[MH_COUNT] = {
+  {"ab_imu_read_us", "", "IMU burst read + magnetometer time"},
+  {"ab_sd_write_us", "", "SD row format + write time (excluding flush)"},
+  {"ab_sd_flush_us", "", "SD flush time"},
+  {"ab_imu_fifo_us", "", "IMU FIFO drain + RPM estimator time"},
+};
+
+static void writeHeader(Print &out, const char* family, const char* help,
+                        const char* type) {
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", family, help, family, type);
+}
+
+//----------------------------------------------------------------
+// Public API
+//----------------------------------------------------------------
+
+void metricsWriteHistHeader(Print &out, const char* family, const char* help) {
+  writeHeader(out, family, help, "histogram");
+}
+
+// Buckets are stored non-cumulative, exported cumulative
+void metricsWriteHist(Print &out, const char* family, const char* labels,
+                      const MetricHist &hist) {
+  const char* sep = labels[0] ? "," : "";
+  uint32_t cum = 0;
+  for (uint8_t b = 0; b <= METRIC_BUCKETS; b++) {
+    cum += hist.bucket[b].load(std::memory_order_relaxed);
+    if (b < METRIC_BUCKETS) {
+      out.printf("%s_bucket{%s%sle=\"%lu\"} %lu\n", family, labels, sep,
+        (unsigned long)METRIC_BUCKET_US[b], (unsigned long)cum);
+    } else {
+      out.printf("%s_bucket{%s%sle=\"+Inf\"} %lu\n", family, labels, sep,
+        (unsigned long)cum);
+    }
+  }
+  if (labels[0]) {
+    out.printf("%s_sum{%s} %lu\n%s_count{%s} %lu\n",
+      family, labels, (unsigned long)hist.sumUs.load(std::memory_order_relaxed),
+      family, labels, (unsigned long)cum);
+  } else {
+    out.printf("%s_sum %lu\n%s_count %lu\n",
+      family, (unsigned long)hist.sumUs.load(std::memory_order_relaxed),
+      family, (unsigned long)cum);
+  }
+}
+
+void metricsRegisterTask(TaskHandle_t task) {
+  if (task && taskCount < METRICS_MAX_TASKS) {
+    tasks[taskCount++] = task;
+  }
+}
+
+void metricsWrite(Print &out) {
+  // Counters
+  const char* prevFamily = "";
+  for (uint8_t i = 0; i < MC_COUNT; i++) {
+    const MetricInfo &m = counterInfo[i];
+    if (strcmp(m.family, prevFamily) != 0) {
+      writeHeader(out, m.family, m.help, "counter");
+      prevFamily = m.family;
+    }
+    uint32_t v = metricCounters[i].load(std::memory_order_relaxed);
+    if (m.labels[0]) out.printf("%s{%s} %lu\n", m.family, m.labels, (unsigned long)v);
+    else             out.printf("%s %lu\n", m.family, (unsigned long)v);
+  }
+
+  // ISP2 link quality (owned by each chain's parser), labelled by chain
+  static const struct { const char* family; const char* help; uint32_t ISP2Stats::*v; } isp2Counters[] = {
+    {"ab_isp2_bytes_total",         "Bytes received on the ISP2 UART",                &ISP2Stats::bytes},
+    {"ab_isp2_packets_total",       "ISP2 data packets decoded",                      &ISP2Stats::packets},
+    {"ab_isp2_discarded_bytes_total", "Bytes skipped while hunting for a header",     &ISP2Stats::discarded},
+    {"ab_isp2_sync_losses_total",   "Header high byte without a valid low byte",      &ISP2Stats::syncLosses},
+    {"ab_isp2_timeouts_total",      "Payloads abandoned after ISP2_TIMEOUT_MS",       &ISP2Stats::timeouts},
+    {"ab_isp2_bad_lengths_total",   "Headers with an out-of-range packet length",     &ISP2Stats::badLengths},
+    {"ab_isp2_overflows_total",     "ISP2 UART receive buffer overflows",             &ISP2Stats::overflows},
+    {"ab_isp2_missed_frames_total", "Chain frames implied by gaps between packets",   &ISP2Stats::missedFrames},
+    {"ab_isp2_interval_max_us",     "Longest gap between ISP2 data packets",          &ISP2Stats::intervalMaxUs},
+  };
+  for (const auto &c : isp2Counters) {
+    bool gauge = c.v == &ISP2Stats::intervalMaxUs;
+    writeHeader(out, c.family, c.help, gauge ? "gauge" : "counter");
+    for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+      out.printf("%s{chain=\"%d\"} %lu\n", c.family, ch,
+        (unsigned long)(isp2GetStats(ch).*c.v));
+    }
+  }
+
+  // Histograms
+  for (uint8_t h = 0; h < MH_COUNT; h++) {
+    writeHeader(out, histInfo[h].family, histInfo[h].help, "histogram");
+    metricsWriteHist(out, histInfo[h].family, "", metricHists[h]);
+  }
+
+  // Per-task loop timing
+  taskTimingWriteMetrics(out);
+
+  // Per-client WebSocket drops
+  webWriteMetrics(out);
+
+  // Gauges
+  writeHeader(out, "ab_heap_free_bytes", "Current free heap", "gauge");
+  out.printf("ab_heap_free_bytes %lu\n", (unsigned long)ESP.getFreeHeap());
+  writeHeader(out, "ab_heap_min_free_bytes", "Lowest free heap since boot", "gauge");
+  out.printf("ab_heap_min_free_bytes %lu\n", (unsigned long)ESP.getMinFreeHeap());
+  writeHeader(out, "ab_uptime_seconds", "Seconds since boot", "gauge");
+  out.printf("ab_uptime_seconds %lu\n", millis() / 1000);
+
+  writeHeader(out, "ab_task_stack_free_bytes",
+              "Lowest free stack seen per task (high-water mark)", "gauge");
+  for (uint8_t i = 0; i < taskCount; i++) {
+    out.printf("ab_task_stack_free_bytes{task=\"%s\"} %u\n",
+      pcTaskGetName(tasks[i]), (unsigned)uxTaskGetStackHighWaterMark(tasks[i]));
+  }
+}
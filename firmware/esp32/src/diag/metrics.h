@@ -0,0 +1,82 @@
+/**
+ *  Analog Bridge — Pipeline Metrics
+ *
+ *  Counters and fixed-bucket latency histograms for the whole sensor
+ *  pipeline, exposed in Prometheus text format at GET /api/metrics.
+ *
+ *  Hot-path updates are single relaxed atomic adds (lock-free on both
+ *  S3 cores). Cumulative bucket counts, gauges (heap, stack high-water
+ *  marks) and formatting are only computed when scraped.
+ */
+#ifndef AB_METRICS_H
+#define AB_METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+enum MetricCounter {
+  MC_GPS_BYTES,
+  MC_GPS_SENTENCES,
+  MC_GPS_CHECKSUM_FAILS,
+  MC_GPS_EPOCHS,
+  MC_SD_ROWS,
+  MC_SD_ERRORS,
+  MC_WS_FRAMES_SENT,
+  MC_WS_FRAMES_DROPPED,
+  MC_IMU_FIFO_OVERFLOWS,
+  MC_COUNT
+};
+
+enum MetricHistogram {
+  MH_IMU_READ_US,
+  MH_SD_WRITE_US,
+  MH_SD_FLUSH_US,
+  MH_IMU_FIFO_US,
+  MH_COUNT
+};
+
+// Upper bounds (µs) of the histogram buckets; a final +Inf bucket is implicit
+#define METRIC_BUCKETS 10
+static const uint32_t METRIC_BUCKET_US[METRIC_BUCKETS] = {
+  100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000
+};
+
+struct MetricHist {
+  std::atomic<uint32_t> bucket[METRIC_BUCKETS + 1];  // non-cumulative
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> sumUs;
+};
+
+extern std::atomic<uint32_t> metricCounters[MC_COUNT];
+extern MetricHist metricHists[MH_COUNT];
+
+// Increment a counter. Safe from any task on either core.
+inline void metricsInc(MetricCounter c, uint32_t n = 1) {
+  metricCounters[c].fetch_add(n, std::memory_order_relaxed);
+}
+
+// Record one latency sample in microseconds.
+inline void metricsObserve(MetricHist &m, uint32_t us) {
+  uint8_t b = 0;
+  while (b < METRIC_BUCKETS && us > METRIC_BUCKET_US[b]) b++;
+  m.bucket[b].fetch_add(1, std::memory_order_relaxed);
+  m.count.fetch_add(1, std::memory_order_relaxed);
+  m.sumUs.fetch_add(us, std::memory_order_relaxed);
+}
+
+inline void metricsObserve(MetricHistogram h, uint32_t us) {
+  metricsObserve(metricHists[h], us);
+}
+
+// Register a task so its stack high-water mark is exported.
+void metricsRegisterTask(TaskHandle_t task);
+
+// Write all metrics in Prometheus text exposition format.
+void metricsWrite(Print &out);
+
+// Helpers for modules that export their own histograms.
+void metricsWriteHistHeader(Print &out, const char* family, const char* help);
+void metricsWriteHist(Print &out, const char* family, const char* labels,
+                      const MetricHist &hist);
+
+#endif // AB_METRICS_H
@@ -0,0 +1,76 @@
+/**
+ *  Analog Bridge — Per-Task Loop Timing Implementation
+ *
+ *  Each TaskTiming has a single writer (its own task); readers on the
+ *  other core see 32-bit aligned fields, so a summary may mix two
+ *  adjacent iterations but never a torn value.
+ */
+#include "task_timing.h"
+#include "config.h"
+
+#define TASK_TIMING_MAX 8
+
+uint32_t taskTimingCpuMHz = 240;
+static TaskTiming* timings[TASK_TIMING_MAX];
+static uint8_t timingCount = 0;
+
+static uint32_t histMeanUs(const MetricHist &h) {
+  uint32_t n = h.count.load(std::memory_order_relaxed);
+  return n ? h.sumUs.load(std::memory_order_relaxed) / n : 0;
+}
+
+//----------------------------------------------------------------
+// Public API
+//----------------------------------------------------------------
+
+void taskTimingInit(TaskTiming &t, const char* name, uint32_t periodMs,
+                    uint32_t deadlineMs) {
+  taskTimingCpuMHz = ESP.getCpuFreqMHz();
+  t.name = name;
+  t.periodUs = periodMs * 1000UL;
+  t.deadlineTicks = pdMS_TO_TICKS(deadlineMs ? deadlineMs : periodMs);
+  if (timingCount < TASK_TIMING_MAX) {
+    timings[timingCount++] = &t;
+  }
+}
+
+void taskTimingPrint(Print &out) {
+  out.println("--- Task Timing ---");
+  out.println("Task      Period  Dline   Iter  Exec avg/max us   Jitter avg/max us  Miss  Stack");
+  for (uint8_t i = 0; i < timingCount; i++) {
+    const TaskTiming &t = *timings[i];
+    out.printf("%-8s %5lums %4lums %7lu   %6lu/%-7lu    %6lu/%-7lu   %5lu  %5u\n",
+      t.name, (unsigned long)t.periodUs / 1000,
+      t.periodUs ? (unsigned long)(t.deadlineTicks * portTICK_PERIOD_MS) : 0UL,
+      (unsigned long)t.iterations,
+      (unsigned long)histMeanUs(t.exec), (unsigned long)t.execMaxUs,
+      (unsigned long)histMeanUs(t.jitter), (unsigned long)t.jitterMaxUs,
+      (unsigned long)t.deadlineMisses,
+      t.handle ? (unsigned)uxTaskGetStackHighWaterMark(t.handle) : 0);
+  }
+}
+
+void taskTimingWriteMetrics(Print &out) {
+  char labels[32];
+
+  out.print("# HELP ab_task_deadline_misses_total Loop iterations that ended past the next wake\n"
+            "# TYPE ab_task_deadline_misses_total counter\n");
+  for (uint8_t i = 0; i < timingCount; i++) {
+    if (!timings[i]->periodUs) continue;
+    out.printf("ab_task_deadline_misses_total{task=\"%s\"} %lu\n",
+      timings[i]->name, (unsigned long)timings[i]->deadlineMisses);
+  }
+
+  metricsWriteHistHeader(out, "ab_task_exec_us", "Task loop body execution time");
+  for (uint8_t i = 0; i < timingCount; i++) {
+    snprintf(labels, sizeof(labels), "task=\"%s\"", timings[i]->name);
+    metricsWriteHist(out, "ab_task_exec_us", labels, timings[i]->exec);
+  }
+
+  metricsWriteHistHeader(out, "ab_task_jitter_us", "Task period jitter (start-to-start)");
+  for (uint8_t i = 0; i < timingCount; i++) {
+    if (!timings[i]->periodUs) continue;
+    snprintf(labels, sizeof(labels), "task=\"%s\"", timings[i]->name);
+    metricsWriteHist(out, "ab_task_jitter_us", labels, timings[i]->jitter);
+  }
+}
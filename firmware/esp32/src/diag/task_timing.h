@@ -0,0 +1,80 @@
+/**
+ *  Analog Bridge — Per-Task Loop Timing
+ *
+ *  Cycle-counter timestamps at the start and end of each task loop
+ *  iteration feed execution-time and period-jitter histograms plus a
+ *  deadline-miss counter. Shown by the 't' serial command and exported
+ *  through /api/metrics alongside each task's stack high-water mark.
+ *
+ *  Cost per iteration: two CCOUNT reads and a handful of relaxed adds
+ *  (well under 1 µs), i.e. < 0.01% of an 80 ms loop.
+ *
+ *  Usage inside a vTaskDelayUntil() loop:
+ *    vTaskDelayUntil(&lastWake, period);
+ *    taskTimingStart(tim);
+ *    ... work ...
+ *    taskTimingEnd(tim, lastWake);
+ *
+ *  A loop that wakes more than once per period (the sensor task drains
+ *  the IMU FIFO half-way) passes the time to its next wake as deadline.
+ */
+#ifndef AB_TASK_TIMING_H
+#define AB_TASK_TIMING_H
+
+#include <Arduino.h>
+#include "metrics.h"
+
+struct TaskTiming {
+  const char*  name;
+  uint32_t     periodUs;        // nominal period, 0 = free-running loop
+  TickType_t   deadlineTicks;   // must end this long after lastWake
+  TaskHandle_t handle;          // captured on first start
+  uint32_t     startCycles;     // CCOUNT at current iteration start
+  uint32_t     lastStartCycles;
+  uint32_t     iterations;
+  uint32_t     deadlineMisses;  // iterations that ended past the next wake
+  uint32_t     execMaxUs;
+  uint32_t     jitterMaxUs;
+  MetricHist   exec;            // loop body execution time
+  MetricHist   jitter;          // |actual start-to-start − period|
+};
+
+extern uint32_t taskTimingCpuMHz;
+
+// Register a timing block. Call once before the task starts.
+// deadlineMs: time from the wake to the loop's next wake, 0 = the period.
+void taskTimingInit(TaskTiming &t, const char* name, uint32_t periodMs,
+                    uint32_t deadlineMs = 0);
+
+inline void taskTimingStart(TaskTiming &t) {
+  uint32_t now = ESP.getCycleCount();  // per-core; tasks are pinned
+  if (t.iterations == 0) {
+    t.handle = xTaskGetCurrentTaskHandle();
+  } else if (t.periodUs) {
+    uint32_t actualUs = (now - t.lastStartCycles) / taskTimingCpuMHz;
+    uint32_t j = actualUs > t.periodUs ? actualUs - t.periodUs : t.periodUs - actualUs;
+    if (j > t.jitterMaxUs) t.jitterMaxUs = j;
+    metricsObserve(t.jitter, j);
+  }
+  t.lastStartCycles = now;
+  t.startCycles = now;
+}
+
+// lastWake: the vTaskDelayUntil() reference (ignored for free-running loops)
+inline void taskTimingEnd(TaskTiming &t, TickType_t lastWake) {
+  uint32_t us = (ESP.getCycleCount() - t.startCycles) / taskTimingCpuMHz;
+  if (us > t.execMaxUs) t.execMaxUs = us;
+  metricsObserve(t.exec, us);
+  if (t.periodUs && xTaskGetTickCount() - lastWake >= t.deadlineTicks) {
+    t.deadlineMisses++;
+  }
+  t.iterations++;
+}
+
+// Print a per-task summary table (serial 't' command).
+void taskTimingPrint(Print &out);
+
+// Append per-task metrics in Prometheus text format.
+void taskTimingWriteMetrics(Print &out);
+
+#endif // AB_TASK_TIMING_H
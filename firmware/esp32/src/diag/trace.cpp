@@ -0,0 +1,220 @@
+/**
+ *  Analog Bridge — Pipeline Event Tracer Implementation
+ *
+ *  CCOUNT is per-core and wraps every ~18 s at 240 MHz, so each core
+ *  anchors its cycle counter to esp_timer on its first event and the
+ *  dump unwraps cycles per core as signed deltas in buffer order. Both
+ *  counters run from the CPU clock, so the two cores line up to within
+ *  the anchor read (~1 µs).
+ *
+ *  The JSON dump is produced line by line by a resumable generator so
+ *  /api/trace can stream ~300 KB without buffering it.
+ */
+#include "trace.h"
+#include "ui/console.h"
+
+#ifdef TRACE_ENABLE
+
+#include "esp_timer.h"
+
+#define TRACE_MAX_TASKS 16
+
+TraceRecord           traceBuf[TRACE_EVENTS];
+std::atomic<uint32_t> traceHead(TRACE_EVENTS);   // full = not armed
+volatile bool         traceArmed = false;
+volatile bool         traceAnchored[2] = {false, false};
+
+static uint32_t anchorCycles[2];
+static int64_t  anchorUs[2];
+
+static const char* const traceNames[TR_COUNT] = {
+  "Sensors", "SDLog", "WS", "ISP2 RX", "IMU read", "GPS read",
+  "SD write", "SD flush", "WS send", "ISP2 packet", "Publish",
+  "IMU FIFO"
+};
+
+// JSON generator state (one dump at a time)
+enum GenStage { GEN_HEADER, GEN_EVENTS, GEN_PROCESSES, GEN_THREADS, GEN_FOOTER, GEN_DONE };
+static struct {
+  uint8_t      stage;
+  uint32_t     cursor;
+  uint32_t     count;
+  uint32_t     mhz;
+  uint32_t     prev[2];
+  int64_t      acc[2];
+  TaskHandle_t tasks[TRACE_MAX_TASKS];
+  uint8_t      taskCore[TRACE_MAX_TASKS];
+  uint8_t      taskCount;
+  char         line[160];
+  uint16_t     lineLen;
+  uint16_t     linePos;
+} gen;
+
+void traceAnchor(uint8_t core, uint32_t cycles) {
+  anchorCycles[core] = cycles;
+  anchorUs[core] = esp_timer_get_time();
+  traceAnchored[core] = true;
+}
+
+//----------------------------------------------------------------
+// JSON generation
+//----------------------------------------------------------------
+
+static uint8_t taskTid(TaskHandle_t task, uint8_t core) {
+  for (uint8_t i = 0; i < gen.taskCount; i++) {
+    if (gen.tasks[i] == task) return i + 1;
+  }
+  if (gen.taskCount >= TRACE_MAX_TASKS) return 0;
+  gen.tasks[gen.taskCount] = task;
+  gen.taskCore[gen.taskCount] = core;
+  return ++gen.taskCount;
+}
+
+static void genReset() {
+  traceStop();
+  gen.stage = GEN_HEADER;
+  gen.cursor = 0;
+  gen.count = traceCount();
+  gen.mhz = ESP.getCpuFreqMHz();
+  for (uint8_t c = 0; c < 2; c++) {
+    gen.prev[c] = anchorCycles[c];
+    gen.acc[c] = 0;
+  }
+  gen.taskCount = 0;
+  gen.lineLen = gen.linePos = 0;
+}
+
+// Produce the next line into gen.line; false when the dump is complete
+static bool genNextLine() {
+  int n = 0;
+  char *l = gen.line;
+  const size_t sz = sizeof(gen.line);
+
+  switch (gen.stage) {
+    case GEN_HEADER:
+      n = snprintf(l, sz, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Core 0\"}}");
+      gen.stage = GEN_EVENTS;
+      break;
+
+    case GEN_EVENTS: {
+      // Skip slots a writer had not finished when capture stopped
+      while (gen.cursor < gen.count && traceBuf[gen.cursor].flags == TRACE_PH_EMPTY) {
+        gen.cursor++;
+      }
+      if (gen.cursor >= gen.count) {
+        gen.stage = GEN_PROCESSES;
+        return genNextLine();
+      }
+      const TraceRecord &r = traceBuf[gen.cursor++];
+      uint8_t core  = r.flags >> 7;
+      uint8_t phase = r.flags & 0x7F;
+      gen.acc[core] += (int32_t)(r.cycles - gen.prev[core]);
+      gen.prev[core] = r.cycles;
+      int64_t ns = anchorUs[core] * 1000 + gen.acc[core] * 1000 / gen.mhz;
+      if (ns < 0) ns = 0;
+      const char* name = r.id < TR_COUNT ? traceNames[r.id] : "?";
+      uint8_t tid = taskTid(r.task, core);
+
+      if (phase == TRACE_PH_BEGIN) {
+        n = snprintf(l, sz, ",\n{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%llu.%03u,\"pid\":%u,\"tid\":%u}",
+          name, (unsigned long long)(ns / 1000), (unsigned)(ns % 1000), core, tid);
+      } else if (phase == TRACE_PH_END) {
+        n = snprintf(l, sz, ",\n{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%llu.%03u,\"pid\":%u,\"tid\":%u,"
+          "\"args\":{\"n\":%u}}",
+          name, (unsigned long long)(ns / 1000), (unsigned)(ns % 1000), core, tid, r.arg);
+      } else {
+        n = snprintf(l, sz, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu.%03u,"
+          "\"pid\":%u,\"tid\":%u,\"args\":{\"n\":%u}}",
+          name, (unsigned long long)(ns / 1000), (unsigned)(ns % 1000), core, tid, r.arg);
+      }
+      break;
+    }
+
+    case GEN_PROCESSES:
+      n = snprintf(l, sz, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+        "\"args\":{\"name\":\"Core 1\"}}");
+      gen.cursor = 0;
+      gen.stage = GEN_THREADS;
+      break;
+
+    case GEN_THREADS:
+      if (gen.cursor >= gen.taskCount) {
+        gen.stage = GEN_FOOTER;
+        return genNextLine();
+      }
+      n = snprintf(l, sz, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+        "\"args\":{\"name\":\"%s\"}}",
+        gen.taskCore[gen.cursor], (unsigned)(gen.cursor + 1),
+        pcTaskGetName(gen.tasks[gen.cursor]));
+      gen.cursor++;
+      break;
+
+    case GEN_FOOTER:
+      n = snprintf(l, sz, "\n]}\n");
+      gen.stage = GEN_DONE;
+      break;
+
+    default:
+      return false;
+  }
+
+  gen.lineLen = (n > 0 && (size_t)n < sz) ? n : 0;
+  gen.linePos = 0;
+  return true;
+}
+
+//----------------------------------------------------------------
+// Public API
+//----------------------------------------------------------------
+
+void traceStart() {
+  traceArmed = false;
+  for (uint32_t i = 0; i < TRACE_EVENTS; i++) {
+    traceBuf[i].flags = TRACE_PH_EMPTY;
+  }
+  traceAnchored[0] = traceAnchored[1] = false;
+  traceHead.store(0, std::memory_order_relaxed);
+  traceArmed = true;
+  Console.printf("INF: Trace armed (%d events)\n", TRACE_EVENTS);
+}
+
+void traceStop() {
+  traceArmed = false;
+}
+
+bool traceActive() {
+  return traceArmed;
+}
+
+uint32_t traceCount() {
+  uint32_t n = traceHead.load(std::memory_order_relaxed);
+  return n < TRACE_EVENTS ? n : TRACE_EVENTS;
+}
+
+size_t traceFillJson(uint8_t *buf, size_t maxLen, size_t index) {
+  if (index == 0) genReset();
+
+  size_t written = 0;
+  while (written < maxLen) {
+    if (gen.linePos >= gen.lineLen && !genNextLine()) break;
+    size_t n = gen.lineLen - gen.linePos;
+    if (n > maxLen - written) n = maxLen - written;
+    memcpy(buf + written, gen.line + gen.linePos, n);
+    gen.linePos += n;
+    written += n;
+  }
+  return written;
+}
+
+void traceWriteJson(Print &out) {
+  uint8_t buf[256];
+  size_t index = 0;
+  size_t n;
+  while ((n = traceFillJson(buf, sizeof(buf), index)) > 0) {
+    out.write(buf, n);
+    index += n;
+  }
+}
+
+#endif // TRACE_ENABLE
@@ -0,0 +1,116 @@
+/**
+ *  Analog Bridge — Pipeline Event Tracer
+ *
+ *  Fixed-size capture buffer of timestamped begin/end/instant events,
+ *  dumped as Chrome Trace Event JSON for chrome://tracing or
+ *  ui.perfetto.dev. One process per core, one thread track per task.
+ *
+ *  Compile-time removable: without TRACE_ENABLE (config.h) every
+ *  TRACE_* macro expands to nothing and no buffer is allocated.
+ *
+ *  Capture is one-shot: traceStart() arms an empty buffer, which stops
+ *  itself once TRACE_EVENTS records are in. Arm with serial 'T' or
+ *  GET /api/trace?start; download with GET /api/trace or serial 'J'.
+ *
+ *  Cost per event: a CCOUNT read, one atomic add, and a 12-byte store
+ *  (~0.2 µs at 240 MHz).
+ */
+#ifndef AB_TRACE_H
+#define AB_TRACE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Event names. Slices use begin/end pairs, the rest are instants.
+enum TraceId : uint8_t {
+  TR_SENSORS,       // taskSensors loop body
+  TR_SDLOG,         // taskSDLog loop body
+  TR_WS,            // taskWebSocket loop body
+  TR_ISP2_RX,       // ISP2 UART burst drain (arg = bytes)
+  TR_IMU_READ,
+  TR_GPS_READ,      // GPS UART drain + parse (arg = bytes)
+  TR_SD_WRITE,
+  TR_SD_FLUSH,
+  TR_WS_SEND,       // arg = clients
+  TR_ISP2_PACKET,   // instant, arg = payload words
+  TR_PUBLISH,       // instant, back buffer swapped to Core 0
+  TR_IMU_FIFO,      // accel FIFO drain + RPM estimator (arg = samples)
+  TR_COUNT
+};
+
+#ifdef TRACE_ENABLE
+
+#include <atomic>
+
+enum TracePhase : uint8_t {
+  TRACE_PH_EMPTY = 0,   // slot not written yet
+  TRACE_PH_BEGIN,
+  TRACE_PH_END,
+  TRACE_PH_INSTANT
+};
+
+struct TraceRecord {
+  uint32_t     cycles;   // CCOUNT of the emitting core
+  TaskHandle_t task;
+  uint16_t     arg;
+  uint8_t      id;       // TraceId
+  uint8_t      flags;    // phase | core << 7 (written last)
+};
+
+extern TraceRecord           traceBuf[TRACE_EVENTS];
+extern std::atomic<uint32_t> traceHead;
+extern volatile bool         traceArmed;
+
+// Record the CCOUNT/esp_timer pair for this core on its first event
+void traceAnchor(uint8_t core, uint32_t cycles);
+extern volatile bool traceAnchored[2];
+
+inline void traceEmit(uint8_t phase, uint8_t id, uint16_t arg) {
+  if (!traceArmed) return;
+  uint32_t cc = ESP.getCycleCount();
+  uint32_t i = traceHead.fetch_add(1, std::memory_order_relaxed);
+  if (i >= TRACE_EVENTS) {
+    traceArmed = false;
+    return;
+  }
+  uint8_t core = xPortGetCoreID();
+  if (!traceAnchored[core]) traceAnchor(core, cc);
+  TraceRecord &r = traceBuf[i];
+  r.cycles = cc;
+  r.task   = xTaskGetCurrentTaskHandle();
+  r.arg    = arg;
+  r.id     = id;
+  std::atomic_thread_fence(std::memory_order_release);
+  r.flags  = phase | (core << 7);
+}
+
+#define TRACE_BEGIN(id)         traceEmit(TRACE_PH_BEGIN, (id), 0)
+#define TRACE_END(id, arg)      traceEmit(TRACE_PH_END, (id), (uint16_t)(arg))
+#define TRACE_INSTANT(id, arg)  traceEmit(TRACE_PH_INSTANT, (id), (uint16_t)(arg))
+
+// Clear the buffer and start a new capture.
+void traceStart();
+
+// Stop capturing early (the buffer keeps what it has).
+void traceStop();
+
+bool     traceActive();
+uint32_t traceCount();
+
+// Fill buf with the next chunk of the JSON dump starting at byte
+// offset index (0 restarts). Returns 0 when done. Stops any running
+// capture. Suits AsyncWebServer chunked responses directly.
+size_t traceFillJson(uint8_t *buf, size_t maxLen, size_t index);
+
+// Write the whole JSON dump (serial 'J').
+void traceWriteJson(Print &out);
+
+#else
+
+#define TRACE_BEGIN(id)         ((void)0)
+#define TRACE_END(id, arg)      ((void)0)
+#define TRACE_INSTANT(id, arg)  ((void)0)
+
+#endif // TRACE_ENABLE
+
+#endif // AB_TRACE_H
@@ -0,0 +1,162 @@
+/**
+ *  Analog Bridge — Raw ISP2 Capture Implementation
+ */
+#include "raw_capture.h"
+#include "config.h"
+#include "isp2_capture.h"
+#include "ui/console.h"
+#include <SD.h>
+#include <freertos/stream_buffer.h>
+
+static StreamBufferHandle_t capBuf = nullptr;
+static File capFile;
+static char capName[24] = "";
+static volatile bool capEnabled = ISP2_CAPTURE_DEFAULT;
+static volatile bool capActive = false;
+static volatile bool capCloseRequest = false;  // set by stop, acted on by the SD logger task
+
+// Writer side (ISP2 task)
+static uint32_t capLastUs = 0;
+static bool     capGap = false;
+static volatile uint32_t capDropped = 0;   // bytes lost to a full buffer
+
+// Reader side (SD logger task)
+static uint32_t capWritten = 0;
+static unsigned long capLastFlush = 0;
+
+static void drain() {
+  uint8_t buf[512];
+  size_t n;
+  while ((n = xStreamBufferReceive(capBuf, buf, sizeof(buf), 0)) > 0) {
+    capWritten += capFile.write(buf, n);
+  }
+}
+
+// SD logger task only: the file has a single user
+static void finish() {
+  drain();
+  capFile.flush();
+  capFile.close();
+  capActive = false;
+  capCloseRequest = false;
+  Console.printf("INF: Raw capture %lu bytes", (unsigned long)capWritten);
+  if (capDropped > 0) {
+    Console.printf(", %lu dropped", (unsigned long)capDropped);
+  }
+  Console.printf(" -> %s\n", capName);
+}
+
+//----------------------------------------------------------------
+// Public API
+//----------------------------------------------------------------
+
+void rawCaptureInit() {
+  capBuf = xStreamBufferCreate(ISP2_CAPTURE_BUF, 1);
+  if (!capBuf) Console.println("ERR: Raw capture buffer alloc failed");
+}
+
+void rawCaptureSetEnabled(bool on) {
+  capEnabled = on;
+}
+
+bool rawCaptureEnabled() {
+  return capEnabled;
+}
+
+bool rawCaptureOpen(const char* csvName) {
+  if (!capEnabled || !capBuf) return true;
+
+  // The last recording's file is closed by the SD logger task; wait for it
+  for (uint8_t i = 0; capActive && i < 4; i++) {
+    vTaskDelay(pdMS_TO_TICKS(SAMPLE_INTERVAL));
+  }
+  if (capActive) {
+    Console.println("ERR: Raw capture still closing, not captured");
+    return false;
+  }
+
+  strncpy(capName, csvName, sizeof(capName) - 5);
+  capName[sizeof(capName) - 5] = '\0';
+  char *dot = strrchr(capName, '.');
+  strcpy(dot ? dot : capName + strlen(capName), ".isp");
+
+  capFile = SD.open(capName, FILE_WRITE);
+  if (!capFile) {
+    Console.printf("ERR: Raw capture open failed (%s)\n", capName);
+    return false;
+  }
+
+  uint32_t now = micros();
+  Isp2CaptureHeader h;
+  isp2CapHeaderInit(h, ISP2_BAUD, now);
+  capWritten = capFile.write((const uint8_t*)&h, sizeof(h));
+  capLastFlush = millis();
+
+  xStreamBufferReset(capBuf);
+  capLastUs = now;
+  capGap = false;
+  capDropped = 0;
+  capActive = true;
+
+  Console.printf("INF: Raw ISP2 capture -> %s\n", capName);
+  return true;
+}
+
+void rawCaptureRecord(const uint8_t* bytes, size_t n, uint32_t nowUs) {
+  if (!capActive || capCloseRequest) return;
+
+  uint8_t hdr[ISP2_CAP_MAX_REC * 2];
+  uint8_t len = 0;
+  int32_t dt = (int32_t)(nowUs - capLastUs);
+  if (dt < 0) dt = 0;  // read timestamped just before the capture opened
+
+  if (capGap) {
+    len += isp2CapPutVarint(hdr + len, dt);
+    len += isp2CapPutVarint(hdr + len, 0);
+    dt = 0;
+  }
+  len += isp2CapPutVarint(hdr + len, dt);
+  len += isp2CapPutVarint(hdr + len, n);
+
+  if (xStreamBufferSpacesAvailable(capBuf) < len + n) {
+    capGap = true;
+    capDropped += n;
+    return;
+  }
+  xStreamBufferSend(capBuf, hdr, len, 0);
+  xStreamBufferSend(capBuf, bytes, n, 0);
+  capLastUs = nowUs;
+  capGap = false;
+}
+
+void rawCaptureDrain() {
+  if (!capActive) return;
+  if (capCloseRequest) {
+    finish();
+    return;
+  }
+  drain();
+
+  if (millis() - capLastFlush > FLUSH_INTERVAL) {
+    capFile.flush();
+    capLastFlush = millis();
+    if (capFile.getWriteError()) {
+      capActive = false;
+      capFile.close();
+      Console.println("ERR: Raw capture write failed, capture stopped");
+    }
+  }
+}
+
+void rawCaptureClose() {
+  if (capActive) capCloseRequest = true;
+}
+
+void rawCapturePrint(Print &out) {
+  out.printf("Raw capture: %s", capEnabled ? "enabled" : "disabled");
+  if (capActive) {
+    out.printf(", writing %s (%lu bytes, %lu dropped)", capName,
+      (unsigned long)capWritten, (unsigned long)capDropped);
+  }
+  out.println();
+}
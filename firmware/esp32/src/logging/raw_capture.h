@@ -0,0 +1,44 @@
+/**
+ *  Analog Bridge — Raw ISP2 Capture
+ *
+ *  Optional sink that mirrors every ISP2 UART read, with the timestamp
+ *  the parser used, into a side file next to the CSV (LOG_0.csv →
+ *  LOG_0.isp). Format in shared isp2_capture.h; replay on a host with
+ *  tools/host/isp2_replay.cpp.
+ *
+ *  The ISP2 task only copies into a stream buffer; the SD logger task
+ *  drains it to the card between CSV rows.
+ *
+ *  Toggled with serial 'R'; takes effect at the next recording start.
+ */
+#ifndef AB_RAW_CAPTURE_H
+#define AB_RAW_CAPTURE_H
+
+#include <Arduino.h>
+
+// Create the capture buffer. Call once from setup().
+void rawCaptureInit();
+
+void rawCaptureSetEnabled(bool on);
+bool rawCaptureEnabled();
+
+// Open the side file for a CSV log. No-op if capture is disabled.
+// Returns false if the file could not be created or the last one is
+// still closing (recording goes on).
+bool rawCaptureOpen(const char* csvName);
+
+// Queue one UART read (ISP2 task). Never blocks; bytes that do not fit
+// are dropped and a gap record is written in their place.
+void rawCaptureRecord(const uint8_t* bytes, size_t n, uint32_t nowUs);
+
+// Move queued records to the card (SD logger task). Call every period,
+// recording or not: a requested close is carried out here.
+void rawCaptureDrain();
+
+// Stop capturing. Safe from any task: the SD logger task's next
+// rawCaptureDrain() drains, closes and prints a summary.
+void rawCaptureClose();
+
+void rawCapturePrint(Print &out);
+
+#endif // AB_RAW_CAPTURE_H
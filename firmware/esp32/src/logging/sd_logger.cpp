@@ -6,11 +6,19 @@
  *    - SPI.begin() with explicit pin assignment
  *    - No F() macros
  *    - printDegE7() for lat/lon formatting preserved for CSV compat
+ *    - Header, units and row generated from the channel table
+ *      (channels.h)
+ *    - Optional binary records (binlog.h), buffered into whole 512-byte
+ *      blocks so each card write is one aligned sector
  */
 #include "sd_logger.h"
 #include "config.h"
 #include <SPI.h>
 #include <SD.h>
+#include "binlog.h"
+#include "diag/metrics.h"
+#include "diag/trace.h"
+#include "ui/console.h"
 
 static File logFile;
 static char logFilename[16] = "";
@@ -18,6 +26,12 @@ static unsigned long logRowCount = 0;
 static uint8_t sdErrorCount = 0;
 static unsigned long lastFlush = 0;
 
+// Binary mode
+static volatile bool binEnabled = LOG_BINARY_DEFAULT;
+static bool binActive = false;                  // current file is .bin
+static uint8_t binBlock[BINLOG_BLOCK];
+static uint8_t binFill = 0;                     // records in binBlock
+
 //----------------------------------------------------------------
 // Helper: print degE7 as decimal degrees (same as AVR for CSV compat)
 //----------------------------------------------------------------
@@ -39,35 +53,41 @@ static void printDegE7(Print &out, int32_t degE7) {
 }
 
 //----------------------------------------------------------------
-// Write a single CSV row
+// Write a single CSV row, one field per channels.h row
 //----------------------------------------------------------------
-static void printRow(Print &out, const SensorData &data, float now,
+#define CSV_TIME(m, dg)  out.print((float)elapsedMs / 1000.0f, dg)
+#define CSV_KEY(m, dg)   out.print(keyframePending ? keyframeCount : 0)
+#define CSV_DEG(m, dg)   printDegE7(out, data.m)
+#define CSV_F(m, dg)     out.print(data.m, dg)
+#define CSV_U8(m, dg)    out.print(data.m)
+#define CSV_BOOL(m, dg)  out.print(data.m ? 1 : 0)
+#define CSV_FIELD(name, unit, m, type, store, dg, group, json)  CSV_##type(m, dg);
+
+static void printRow(Print &out, const SensorData &data, uint32_t elapsedMs,
                      bool keyframePending, uint16_t keyframeCount) {
-  out.print(now, 3);               out.print(',');
-  printDegE7(out, data.lat);       out.print(',');
-  printDegE7(out, data.lon);       out.print(',');
-  out.print(data.speed);           out.print(',');
-  out.print(data.alt);             out.print(',');
-  out.print(data.dir);             out.print(',');
-  out.print(data.satellites);      out.print(',');
-  out.print(data.accx);            out.print(',');
-  out.print(data.accy);            out.print(',');
-  out.print(data.accz);            out.print(',');
-  out.print(data.rotx);            out.print(',');
-  out.print(data.roty);            out.print(',');
-  out.print(data.rotz);            out.print(',');
-  out.print(data.magx);            out.print(',');
-  out.print(data.magy);            out.print(',');
-  out.print(data.magz);            out.print(',');
-  out.print(data.imuTemp, 1);      out.print(',');
-  out.print(data.afr);             out.print(',');
-  out.print(data.afr1);            out.print(',');
-  out.print(data.vss);             out.print(',');
-  out.print(data.map);             out.print(',');
-  out.print(data.oilp);            out.print(',');
-  out.print(data.coolant);         out.print(',');
-  out.print(data.gpsStale ? 1 : 0); out.print(',');
-  out.println(keyframePending ? keyframeCount : 0);
+  AB_CHANNELS(CSV_FIELD, out.print(',');)
+  out.println();
+}
+
+//----------------------------------------------------------------
+// Binary records: whole blocks only, the last one zero padded on close
+//----------------------------------------------------------------
+static void writeBinRecord(const SensorData &data, uint32_t elapsedMs,
+                           bool keyframePending, uint16_t keyframeCount) {
+  BinlogRecord *r = (BinlogRecord *)binBlock + binFill;
+  binlogEncode(*r, data, elapsedMs, keyframePending ? keyframeCount : 0);
+  if (++binFill == BINLOG_PER_BLOCK) {
+    logFile.write(binBlock, sizeof(binBlock));
+    binFill = 0;
+  }
+}
+
+static void flushBinBlock() {
+  if (binFill == 0) return;
+  memset(binBlock + binFill * sizeof(BinlogRecord), 0,
+         sizeof(binBlock) - binFill * sizeof(BinlogRecord));
+  logFile.write(binBlock, sizeof(binBlock));
+  binFill = 0;
 }
 
 //----------------------------------------------------------------
@@ -77,25 +97,35 @@ static void printRow(Print &out, const SensorData &data, float now,
 void sdInit() {
   SPI.begin(SD_CLK_PIN, SD_MISO_PIN, SD_MOSI_PIN, SD_CS_PIN);
   pinMode(SD_CS_PIN, OUTPUT);
-  Serial.println("INF: SD SPI initialized");
+  Console.println("INF: SD SPI initialized");
+}
+
+void sdSetBinary(bool on) {
+  binEnabled = on;
+}
+
+bool sdBinary() {
+  return binEnabled;
 }
 
 bool sdOpenLogFile(const char* filenameBase, const char* dateStr) {
   if (!SD.begin(SD_CS_PIN)) {
-    Serial.println("ERR: SD card failed or not present");
+    Console.println("ERR: SD card failed or not present");
     return false;
   }
 
+  bool binary = binEnabled;
+  const char *ext = binary ? "bin" : "csv";
   char fname[24];
   int index = 0;
-  snprintf(fname, sizeof(fname), "%s_%d.csv", filenameBase, index);
+  snprintf(fname, sizeof(fname), "%s_%d.%s", filenameBase, index, ext);
 
   while (SD.exists(fname)) {
     index++;
-    snprintf(fname, sizeof(fname), "%s_%d.csv", filenameBase, index);
+    snprintf(fname, sizeof(fname), "%s_%d.%s", filenameBase, index, ext);
   }
 
-  Serial.printf("INF: Opening log %s\n", fname);
+  Console.printf("INF: Opening log %s\n", fname);
   logFile = SD.open(fname, FILE_WRITE);
   if (!logFile) return false;
 
@@ -103,35 +133,62 @@ bool sdOpenLogFile(const char* filenameBase, const char* dateStr) {
   logFilename[sizeof(logFilename) - 1] = '\0';
   logRowCount = 0;
   sdErrorCount = 0;
+  binActive = binary;
+  binFill = 0;
+
+  if (binary) {
+    // Header block, then records from the second sector on
+    memset(binBlock, 0, sizeof(binBlock));
+    binlogHeaderInit(*(BinlogHeader *)binBlock, BINLOG_SRC_ESP32, SAMPLE_INTERVAL,
+                     dateStr, FW_VERSION);
+    logFile.write(binBlock, sizeof(binBlock));
+    logFile.flush();
+    lastFlush = millis();
+    return true;
+  }
 
   // Write header
   if (dateStr && dateStr[0]) {
     logFile.println(dateStr);
   }
-  logFile.println("time,lat,lon,speed,alt,dir,sats,accx,accy,accz,rotx,roty,rotz,magx,magy,magz,imuTemp,afr,afr1,vss,map,oilp,coolant,gpsStale,keyframe");
-  logFile.println("(s),(deg),(deg),(mph),(ft),(deg),(#),(g),(g),(g),(dps),(dps),(dps),(uT),(uT),(uT),(C),(afr),(afr),(mph),(inHgVac),(psig),(F),(flag),(#)");
+  logFile.println(AB_CSV_HEADER);
+  logFile.println(AB_CSV_UNITS);
   logFile.flush();
   lastFlush = millis();
 
   return true;
 }
 
-bool sdWriteRow(const SensorData &data, float elapsedSec,
+bool sdWriteRow(const SensorData &data, uint32_t elapsedMs,
                 bool keyframePending, uint16_t keyframeCount) {
   if (!logFile) return true;  // no file = nothing to write, not an error
 
-  printRow(logFile, data, elapsedSec, keyframePending, keyframeCount);
+  TRACE_BEGIN(TR_SD_WRITE);
+  uint32_t t0 = micros();
+  if (binActive) {
+    writeBinRecord(data, elapsedMs, keyframePending, keyframeCount);
+  } else {
+    printRow(logFile, data, elapsedMs, keyframePending, keyframeCount);
+  }
+  metricsObserve(MH_SD_WRITE_US, micros() - t0);
+  TRACE_END(TR_SD_WRITE, 0);
   logRowCount++;
+  metricsInc(MC_SD_ROWS);
 
   // Flush every 1 second
   if (millis() - lastFlush > FLUSH_INTERVAL) {
+    TRACE_BEGIN(TR_SD_FLUSH);
+    t0 = micros();
     logFile.flush();
+    metricsObserve(MH_SD_FLUSH_US, micros() - t0);
+    TRACE_END(TR_SD_FLUSH, 0);
     if (logFile.getWriteError()) {
       sdErrorCount++;
+      metricsInc(MC_SD_ERRORS);
       logFile.clearWriteError();
-      Serial.printf("ERR: SD write fail #%d\n", sdErrorCount);
+      Console.printf("ERR: SD write fail #%d\n", sdErrorCount);
       if (sdErrorCount >= SD_MAX_ERRORS) {
-        Serial.println("ERR: SD card failed, stopping recording");
+        Console.println("ERR: SD card failed, stopping recording");
         return false;  // caller should stop recording
       }
     } else {
@@ -145,6 +202,7 @@ bool sdWriteRow(const SensorData &data, float elapsedSec,
 
 void sdCloseLogFile() {
   if (logFile) {
+    if (binActive) flushBinBlock();
     logFile.flush();
     logFile.close();
   }
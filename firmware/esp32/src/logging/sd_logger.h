@@ -2,7 +2,12 @@
  *  Analog Bridge — SD Card Logger Module
  *
  *  CSV logging to SD card with periodic flush and error recovery.
- *  Same 25-column format as AVR for analysis tool compatibility.
+ *  Same columns as AVR for analysis tool compatibility (shared
+ *  channels.h).
+ *
+ *  Binary mode (serial 'b') writes fixed records, six to a 512-byte
+ *  block, instead (shared binlog.h, same format as the AVR sketch);
+ *  tools/host/bin2csv.cpp turns a .bin back into the CSV.
  */
 #ifndef AB_SD_LOGGER_H
 #define AB_SD_LOGGER_H
@@ -12,12 +17,17 @@
 // Initialize SPI and SD card hardware.
 void sdInit();
 
+// Log format for the next sdOpenLogFile(): binary records or CSV.
+void sdSetBinary(bool on);
+bool sdBinary();
+
 // Open a new log file. Returns true if successful.
 bool sdOpenLogFile(const char* filenameBase, const char* dateStr);
 
-// Write one CSV row. Handles flush timing and error recovery.
+// Write one row (CSV line or binary record). Handles flush timing and
+// error recovery.
 // Returns false if recording should be stopped (SD_MAX_ERRORS exceeded).
-bool sdWriteRow(const SensorData &data, float elapsedSec,
+bool sdWriteRow(const SensorData &data, uint32_t elapsedMs,
                 bool keyframePending, uint16_t keyframeCount);
 
 // Close the current log file and flush.
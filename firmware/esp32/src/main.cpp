@@ -5,15 +5,21 @@
  *  Firmware v2.0.0 — ESP32-S3 with WiFi live monitoring
  *
  *  FreeRTOS dual-core architecture:
- *    Core 0: WiFi stack, WebSocket broadcast, serial commands
+ *    Core 0: WiFi stack, WebSocket broadcast + commands, serial commands
  *    Core 1: ISP2 drain, sensor reads (IMU+GPS), SD logging, LED/button
  *
  *  Data flow:
  *    Sensor tasks → SensorData (double-buffered) → WebSocket JSON + SD CSV
  *
+ *  Boot: GPS reconfigure and WiFi/web start run in one-shot tasks while
+ *  setup() brings up ISP2, SD and the IMU (gyro bias warm-started from
+ *  NVS) and launches the sensor and logging tasks, so the first sample
+ *  is taken a few hundred ms after power-on.
+ *
  *  Repository: github.com/mangeb/analog-bridge
  */
 #include <Arduino.h>
+#include <freertos/event_groups.h>
 #include "config.h"
 #include "sensor_data.h"
 
@@ -22,9 +28,16 @@
 #include "sensors/isp2.h"
 #include "sensors/gps.h"
 #include "logging/sd_logger.h"
+#include "logging/raw_capture.h"
 #include "ui/serial_cmd.h"
+#include "ui/passthrough.h"
+#include "ui/console.h"
 #include "ui/led.h"
 #include "web/web_server.h"
+#include "web/history.h"
+#include "diag/metrics.h"
+#include "diag/task_timing.h"
+#include "diag/trace.h"
 
 //----------------------------------------------------------------
 // Double-buffered SensorData for cross-core sharing
@@ -55,6 +68,39 @@ static SensorData getSnapshot() {
   return snap;
 }
 
+// Loop timing per task (exec time, jitter, deadline misses); the sensor
+// task's half-way FIFO drain is timed on its own
+static TaskTiming timISP2, timSensors, timIMUFifo, timSDLog, timWS;
+
+//----------------------------------------------------------------
+// Boot: slow subsystems start in one-shot tasks; their users check or
+// wait for the matching bit
+//----------------------------------------------------------------
+#define BOOT_GPS  (1 << 0)   // GPS UART at 115200/5Hz
+#define BOOT_WEB  (1 << 1)   // WiFi AP, web server, command queue
+
+static EventGroupHandle_t bootEvents;
+
+static bool bootDone(EventBits_t bit) {
+  return (xEventGroupGetBits(bootEvents) & bit) != 0;
+}
+
+static void bootWait(EventBits_t bit) {
+  xEventGroupWaitBits(bootEvents, bit, pdFALSE, pdTRUE, portMAX_DELAY);
+}
+
+static void taskBootGPS(void *pvParameters) {
+  gpsInit();
+  xEventGroupSetBits(bootEvents, BOOT_GPS);
+  vTaskDelete(NULL);
+}
+
+static void taskBootWeb(void *pvParameters) {
+  webInit();
+  xEventGroupSetBits(bootEvents, BOOT_WEB);
+  vTaskDelete(NULL);
+}
+
 //----------------------------------------------------------------
 // Recording state (shared between cores via atomic/mutex)
 //----------------------------------------------------------------
@@ -68,7 +114,7 @@ static volatile bool keyframePending = false;
 //----------------------------------------------------------------
 static void startRecording() {
   if (isRecording) {
-    Serial.println("INF: Already recording");
+    Console.println("INF: Already recording");
     return;
   }
 
@@ -76,42 +122,45 @@ static void startRecording() {
   const char* date = gpsGetDateString();
 
   if (!sdOpenLogFile(base, date)) {
-    Serial.println("ERR: SD open failed, recording aborted");
+    Console.println("ERR: SD open failed, recording aborted");
     return;
   }
 
+  rawCaptureOpen(sdGetFilename());
+
   isRecording = true;
   startRecord = millis();
   keyframeCount = 0;
   keyframePending = false;
 
-  Serial.printf("INF: Recording -> %s\n", sdGetFilename());
+  Console.printf("INF: Recording -> %s\n", sdGetFilename());
 }
 
 static void stopRecording() {
   if (!isRecording) {
-    Serial.println("INF: Not recording");
+    Console.println("INF: Not recording");
     return;
   }
 
   unsigned long duration = millis() - startRecord;
   isRecording = false;
   sdCloseLogFile();
+  rawCaptureClose();
 
   unsigned long sec = duration / 1000;
-  Serial.printf("INF: Stopped — %lum %lus, %lu rows",
+  Console.printf("INF: Stopped — %lum %lus, %lu rows",
     sec / 60, sec % 60, sdGetRowCount());
   if (keyframeCount > 0) {
-    Serial.printf(", %d keyframes", keyframeCount);
+    Console.printf(", %d keyframes", keyframeCount);
   }
-  Serial.printf(" -> %s\n", sdGetFilename());
+  Console.printf(" -> %s\n", sdGetFilename());
 }
 
 static void insertKeyframe() {
   if (!isRecording) return;
   keyframeCount++;
   keyframePending = true;
-  Serial.printf("INF: Keyframe #%d\n", keyframeCount);
+  Console.printf("INF: Keyframe #%d\n", keyframeCount);
 }
 
 //----------------------------------------------------------------
@@ -119,27 +168,38 @@ static void insertKeyframe() {
 // Drains ISP2 UART buffer. Runs in tight loop with 1ms yield.
 //----------------------------------------------------------------
 static void taskISP2(void *pvParameters) {
-  Serial.println("INF: taskISP2 started on core " + String(xPortGetCoreID()));
+  Console.println("INF: taskISP2 started on core " + String(xPortGetCoreID()));
   for (;;) {
+    taskTimingStart(timISP2);
     isp2Read(*backBuf);
+    taskTimingEnd(timISP2, 0);
     vTaskDelay(pdMS_TO_TICKS(1));  // Yield briefly
   }
 }
 
 //----------------------------------------------------------------
 // FreeRTOS Task: Sensor Read + GPS (Core 1, 12.5Hz)
-// Reads IMU, processes GPS, updates backBuf, then swaps.
+// Reads IMU (accel FIFO drained twice per period), processes GPS,
+// updates backBuf, then swaps.
 //----------------------------------------------------------------
 static void taskSensors(void *pvParameters) {
-  Serial.println("INF: taskSensors started on core " + String(xPortGetCoreID()));
+  Console.println("INF: taskSensors started on core " + String(xPortGetCoreID()));
   TickType_t lastWake = xTaskGetTickCount();
+  bool firstSample = false;
 
   for (;;) {
-    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SAMPLE_INTERVAL));
-
-    // Read sensors into back buffer
+    // Half-way: empty the IMU's accel FIFO, which fills in ~85 ms
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SAMPLE_INTERVAL / 2));
+    taskTimingStart(timIMUFifo);
+    imuDrainFifo();
+    taskTimingEnd(timIMUFifo, lastWake);
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SAMPLE_INTERVAL - SAMPLE_INTERVAL / 2));
+    taskTimingStart(timSensors);
+    TRACE_BEGIN(TR_SENSORS);
+
+    // Read sensors into back buffer (GPS once its UART is configured)
     imuRead(*backBuf);
-    gpsRead(*backBuf);
+    if (bootDone(BOOT_GPS)) gpsRead(*backBuf);
 
     // GPS staleness check
     unsigned long lastFix = gpsGetLastFixTime();
@@ -157,6 +217,14 @@ static void taskSensors(void *pvParameters) {
 
     // Swap to make data available to Core 0
     swapBuffers();
+    TRACE_INSTANT(TR_PUBLISH, 0);
+    if (!firstSample) {
+      firstSample = true;
+      Console.printf("INF: First sample at %lu ms\n", millis());
+    }
+
+    TRACE_END(TR_SENSORS, 0);
+    taskTimingEnd(timSensors, lastWake);
   }
 }
 
@@ -165,15 +233,17 @@ static void taskSensors(void *pvParameters) {
 // Writes CSV rows from the front buffer.
 //----------------------------------------------------------------
 static void taskSDLog(void *pvParameters) {
-  Serial.println("INF: taskSDLog started on core " + String(xPortGetCoreID()));
+  Console.println("INF: taskSDLog started on core " + String(xPortGetCoreID()));
   TickType_t lastWake = xTaskGetTickCount();
 
   for (;;) {
     vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SAMPLE_INTERVAL));
+    taskTimingStart(timSDLog);
+    TRACE_BEGIN(TR_SDLOG);
 
     if (isRecording) {
       SensorData snap = getSnapshot();
-      float elapsed = (float)(millis() - startRecord) / 1000.0f;
+      uint32_t elapsed = millis() - startRecord;
       bool kfPending = keyframePending;
       if (kfPending) keyframePending = false;
 
@@ -182,35 +252,78 @@ static void taskSDLog(void *pvParameters) {
         stopRecording();
       }
     }
+    rawCaptureDrain();  // also closes the capture after a stop
+
+    TRACE_END(TR_SDLOG, 0);
+    taskTimingEnd(timSDLog, lastWake);
   }
 }
 
 //----------------------------------------------------------------
 // FreeRTOS Task: WebSocket Broadcast (Core 0, 5Hz)
+// Also feeds the history ring, even with no clients connected.
 //----------------------------------------------------------------
 static void taskWebSocket(void *pvParameters) {
-  Serial.println("INF: taskWebSocket started on core " + String(xPortGetCoreID()));
+  Console.println("INF: taskWebSocket started on core " + String(xPortGetCoreID()));
+  bootWait(BOOT_WEB);
   TickType_t lastWake = xTaskGetTickCount();
 
   for (;;) {
     vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(WS_BROADCAST_MS));
+    taskTimingStart(timWS);
+    TRACE_BEGIN(TR_WS);
 
     SensorData snap = getSnapshot();
+    historyPush(snap, millis());
+
     float duration = isRecording ? (float)(millis() - startRecord) / 1000.0f : 0.0f;
     webBroadcast(snap, isRecording, sdGetFilename(), sdGetRowCount(),
                  duration, keyframeCount);
     webCleanup();
+
+    TRACE_END(TR_WS, 0);
+    taskTimingEnd(timWS, lastWake);
+  }
+}
+
+//----------------------------------------------------------------
+// FreeRTOS Task: WebSocket Commands (Core 0, event-driven)
+// Blocks on the command queue filled by the async TCP callback.
+//----------------------------------------------------------------
+static bool recordingActive() {
+  return isRecording;
+}
+
+static void taskWebCmd(void *pvParameters) {
+  Console.println("INF: taskWebCmd started on core " + String(xPortGetCoreID()));
+  bootWait(BOOT_WEB);
+  for (;;) {
+    webProcessCommand(portMAX_DELAY);
   }
 }
 
 //----------------------------------------------------------------
 // FreeRTOS Task: Serial Commands (Core 0, 100ms poll)
+// Hands the port over to the ISP2 pass-through while it is active.
 //----------------------------------------------------------------
 static void taskSerialCmd(void *pvParameters) {
-  Serial.println("INF: taskSerialCmd started on core " + String(xPortGetCoreID()));
+  Console.println("INF: taskSerialCmd started on core " + String(xPortGetCoreID()));
+#ifdef TIMING_DEBUG
+  unsigned long lastTimingPrint = millis();
+#endif
   for (;;) {
+    if (passthruActive()) {
+      passthruService();
+      continue;
+    }
     SensorData snap = getSnapshot();
     serialCmdProcess(snap, isRecording);
+#ifdef TIMING_DEBUG
+    if (millis() - lastTimingPrint >= TIMING_DEBUG_MS) {
+      lastTimingPrint = millis();
+      taskTimingPrint(Console);
+    }
+#endif
     vTaskDelay(pdMS_TO_TICKS(100));
   }
 }
@@ -219,7 +332,7 @@ static void taskSerialCmd(void *pvParameters) {
 // FreeRTOS Task: LED + Button (Core 1, 100ms poll)
 //----------------------------------------------------------------
 static void taskLED(void *pvParameters) {
-  Serial.println("INF: taskLED started on core " + String(xPortGetCoreID()));
+  Console.println("INF: taskLED started on core " + String(xPortGetCoreID()));
   for (;;) {
     ledProcess(isRecording, gpsHasFix());
     ledProcessButtons(isRecording);
@@ -232,54 +345,78 @@ static void taskLED(void *pvParameters) {
 //----------------------------------------------------------------
 void setup() {
   Serial.begin(115200);
-  delay(500);  // Let USB-CDC enumerate
+  consoleInit();
+  // Give an attached USB host a moment for the banner; the car has none
+  while (!Serial && millis() < BOOT_SERIAL_WAIT_MS) delay(10);
 
   // Boot banner
-  Serial.println();
-  Serial.println("=========================================");
-  Serial.println("  Analog Bridge  v" FW_VERSION);
-  Serial.println("  1969 Nova 454 BBC Datalogger");
-  Serial.println("  ESP32-S3 — Dual Core + WiFi");
-  Serial.printf("  Built: %s %s\n", __DATE__, __TIME__);
-  Serial.printf("  Free heap: %d bytes\n", ESP.getFreeHeap());
-  Serial.println("=========================================");
-  Serial.println("  Type '?' for commands");
-  Serial.println();
-
-  // Initialize subsystems
-  gpsInit();
+  Console.println();
+  Console.println("=========================================");
+  Console.println("  Analog Bridge  v" FW_VERSION);
+  Console.println("  1969 Nova 454 BBC Datalogger");
+  Console.println("  ESP32-S3 — Dual Core + WiFi");
+  Console.printf("  Built: %s %s\n", __DATE__, __TIME__);
+  Console.printf("  Free heap: %d bytes\n", ESP.getFreeHeap());
+  Console.println("=========================================");
+  Console.println("  Type '?' for commands");
+  Console.println();
+
+  // Slow subsystems first, in parallel with everything below:
+  // GPS reconfigure (~200ms of UBX delays), WiFi AP + web server
+  bootEvents = xEventGroupCreate();
+  xTaskCreatePinnedToCore(taskBootGPS, "BootGPS", TASK_BOOT_STACK,
+    NULL, TASK_BOOT_PRIORITY, NULL, TASK_BOOT_CORE);
+  xTaskCreatePinnedToCore(taskBootWeb, "BootWeb", TASK_BOOT_STACK,
+    NULL, TASK_BOOT_PRIORITY, NULL, TASK_BOOT_CORE);
+
+  // What logging needs
   isp2Init();
   sdInit();
-  imuInit();    // Includes NVS cal load + gyro auto-zero (~2.5s)
+  rawCaptureInit();
+  passthruInit();
+  imuInit();    // NVS cal + last gyro bias; re-zeroes in the background
   ledInit();
-  webInit();
 
   // Set up callbacks
   serialCmdInit(startRecording, stopRecording, insertKeyframe);
   ledSetCallbacks(startRecording, stopRecording, insertKeyframe);
-
-  Serial.println("INF: Boot complete");
-  Serial.printf("INF: Free heap after init: %d bytes\n", ESP.getFreeHeap());
-  Serial.println();
-
-  // Launch FreeRTOS tasks
+  webCmdInit(startRecording, stopRecording, insertKeyframe, recordingActive);
+
+  Console.printf("INF: Boot complete at %lu ms (GPS and WiFi finish in the background)\n", millis());
+  Console.printf("INF: Free heap after init: %d bytes\n", ESP.getFreeHeap());
+  Console.println();
+
+  taskTimingInit(timISP2,    "ISP2",    0);
+  // The sensor task wakes twice per period: each half has to finish
+  // before the other one's wake
+  taskTimingInit(timSensors, "Sensors", SAMPLE_INTERVAL, SAMPLE_INTERVAL / 2);
+  taskTimingInit(timIMUFifo, "IMUFIFO", SAMPLE_INTERVAL, SAMPLE_INTERVAL - SAMPLE_INTERVAL / 2);
+  taskTimingInit(timSDLog,   "SDLog",   SAMPLE_INTERVAL);
+  taskTimingInit(timWS,      "WS",      WS_BROADCAST_MS);
+
+  // Launch FreeRTOS tasks (handles kept for stack high-water metrics)
+  TaskHandle_t h[7] = {};
   // Core 1: time-critical sensor tasks
   xTaskCreatePinnedToCore(taskISP2,      "ISP2",    TASK_ISP2_STACK,
-    NULL, TASK_ISP2_PRIORITY,    NULL, TASK_ISP2_CORE);
+    NULL, TASK_ISP2_PRIORITY,    &h[0], TASK_ISP2_CORE);
   xTaskCreatePinnedToCore(taskSensors,   "Sensors", TASK_SENSORS_STACK,
-    NULL, TASK_SENSORS_PRIORITY, NULL, TASK_SENSORS_CORE);
+    NULL, TASK_SENSORS_PRIORITY, &h[1], TASK_SENSORS_CORE);
   xTaskCreatePinnedToCore(taskSDLog,     "SDLog",   TASK_SDLOG_STACK,
-    NULL, TASK_SDLOG_PRIORITY,   NULL, TASK_SDLOG_CORE);
+    NULL, TASK_SDLOG_PRIORITY,   &h[2], TASK_SDLOG_CORE);
   xTaskCreatePinnedToCore(taskLED,       "LED",     TASK_LED_STACK,
-    NULL, TASK_LED_PRIORITY,     NULL, TASK_LED_CORE);
+    NULL, TASK_LED_PRIORITY,     &h[3], TASK_LED_CORE);
 
   // Core 0: WiFi + UI tasks
   xTaskCreatePinnedToCore(taskWebSocket, "WS",      TASK_WS_STACK,
-    NULL, TASK_WS_PRIORITY,      NULL, TASK_WS_CORE);
+    NULL, TASK_WS_PRIORITY,      &h[4], TASK_WS_CORE);
+  xTaskCreatePinnedToCore(taskWebCmd,    "WSCmd",   TASK_WSCMD_STACK,
+    NULL, TASK_WSCMD_PRIORITY,   &h[5], TASK_WSCMD_CORE);
   xTaskCreatePinnedToCore(taskSerialCmd, "Serial",  TASK_SERIAL_STACK,
-    NULL, TASK_SERIAL_PRIORITY,  NULL, TASK_SERIAL_CORE);
+    NULL, TASK_SERIAL_PRIORITY,  &h[6], TASK_SERIAL_CORE);
+
+  for (uint8_t i = 0; i < 7; i++) metricsRegisterTask(h[i]);
 
-  Serial.println("INF: All tasks launched");
+  Console.println("INF: All tasks launched");
 }
 
 //----------------------------------------------------------------
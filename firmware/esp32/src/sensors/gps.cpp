@@ -13,6 +13,9 @@
 #include "config.h"
 #include <TinyGPSPlus.h>
 #include <HardwareSerial.h>
+#include "diag/metrics.h"
+#include "diag/trace.h"
+#include "ui/console.h"
 
 static HardwareSerial gpsSerial(GPS_UART_NUM);
 static TinyGPSPlus gps;
@@ -20,6 +23,8 @@ static bool firstFix = false;
 static unsigned long lastFixMs = 0;
 static char filenameBuf[16] = "CLOG";
 static char dateBuf[24] = "";
+static uint32_t lastPassed = 0;   // TinyGPS++ sentence counters at last read
+static uint32_t lastFailed = 0;
 
 //----------------------------------------------------------------
 // UBX GPS configuration commands (no PROGMEM needed on ESP32)
@@ -82,17 +87,31 @@ void gpsReconfigure() {
   sendUBX(UBX_CFG_RATE_5HZ, sizeof(UBX_CFG_RATE_5HZ));
   delay(50);
 
-  Serial.println("INF: GPS configured — 115200 baud, 5Hz");
+  Console.println("INF: GPS configured — 115200 baud, 5Hz");
 }
 
 void gpsRead(SensorData &data) {
+  TRACE_BEGIN(TR_GPS_READ);
+  uint32_t bytes = 0;
   while (gpsSerial.available() > 0) {
     gps.encode(gpsSerial.read());
+    bytes++;
+  }
+  TRACE_END(TR_GPS_READ, bytes);
+  if (bytes) {
+    metricsInc(MC_GPS_BYTES, bytes);
+    uint32_t passed = gps.passedChecksum();
+    uint32_t failed = gps.failedChecksum();
+    metricsInc(MC_GPS_SENTENCES, passed - lastPassed);
+    metricsInc(MC_GPS_CHECKSUM_FAILS, failed - lastFailed);
+    lastPassed = passed;
+    lastFailed = failed;
   }
 
   if (gps.location.isUpdated() && gps.location.isValid()) {
     firstFix = true;
     lastFixMs = millis();
+    metricsInc(MC_GPS_EPOCHS);
 
     // Store as degE7 for CSV compatibility with AVR logs
     data.lat = (long)(gps.location.lat() * 1e7);
@@ -113,7 +132,7 @@ void gpsRead(SensorData &data) {
     }
 
 #ifdef GPS_DEBUG
-    Serial.printf("GPS: %.7f, %.7f  %.1f mph  %d sats\n",
+    Console.printf("GPS: %.7f, %.7f  %.1f mph  %d sats\n",
       gps.location.lat(), gps.location.lng(),
       gps.speed.mph(), gps.satellites.value());
 #endif
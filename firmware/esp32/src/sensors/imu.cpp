@@ -13,6 +13,15 @@
 #include <Wire.h>
 #include <FaBo9Axis_MPU9250.h>
 #include <Preferences.h>
+#include "diag/metrics.h"
+#include "diag/trace.h"
+#include "ui/console.h"
+#include "gyro_bias.h"
+#include "mag_fit.h"
+#include "ahrs.h"
+#include "engine_validate.h"
+#include "vib_rpm.h"
+#include "isp2.h"
 
 // MPU9250 register addresses (from FaBo library header)
 #ifndef MPU9250_SLAVE_ADDRESS
@@ -21,46 +30,365 @@
 #ifndef MPU9250_ACCEL_XOUT_H
 #define MPU9250_ACCEL_XOUT_H  0x3B
 #endif
+// FIFO (register map rev 1.6)
+#define MPU9250_SMPLRT_DIV     0x19
+#define MPU9250_CONFIG         0x1A
+#define MPU9250_ACCEL_CONFIG2  0x1D
+#define MPU9250_FIFO_EN        0x23
+#define MPU9250_USER_CTRL      0x6A
+#define MPU9250_FIFO_COUNTH    0x72
+#define MPU9250_FIFO_R_W       0x74
+#define MPU9250_FIFO_SIZE      512
 
 static FaBo9Axis mpu9250;
 static IMUCalibration cal = {};
 static bool ready = false;
 static Preferences prefs;
 
+// Gyro bias: temperature model learned at every stop (sensor task only)
+static GyroBiasTracker gyroTrk;
+static volatile bool gyroResetRequest = false;  // set by imuResetGyroModel(), any task
+static bool gyroModelSaved = false;
+static float gyroSavedOffset[3];                // model offset as last written to NVS
+static float gyroPrevWindow[3];                 // unsaved model: the window before the last
+static uint32_t gyroSaveMs = 0;
+
+// Accel/mag calibration: requested from any task, run by imuRead() on the
+// sensor task's samples, so the I2C bus keeps a single owner
+enum CalMode : uint8_t { CAL_NONE, CAL_ACCEL, CAL_MAG };
+static volatile CalMode calRequest = CAL_NONE;
+static volatile CalMode calMode = CAL_NONE;     // written by the sensor task only
+static volatile bool eraseRequest = false;      // set by imuEraseCalibration(), any task
+static uint16_t calCount;
+static uint32_t calStartMs;
+static float calSum[3], calSq[3];               // accel: g, g²
+static MagFit calMag;                           // mag: ellipsoid sums
+
+// Attitude filter (sensor task only)
+static Ahrs ahrs;
+static uint32_t ahrsUs = 0;                     // micros() of the last update
+
+// Engine RPM from the 1 kHz accel FIFO (sensor task only)
+static VibRpm vib;
+static uint32_t vibMs = 0;                      // millis() of the last window
+static uint32_t fifoOverflows = 0;
+static uint32_t fifoSamples = 0;                 // accel samples fed to the estimator
+static uint32_t fifoMaxUs = 0;                   // slowest drain
+static bool fifoRunning = false;                // enabled by the first drain
+static float fifoAccSum[3];                     // g, FIFO samples since the last imuRead()
+static uint16_t fifoAccCount = 0;
+
+//----------------------------------------------------------------
+// Accel FIFO
+//----------------------------------------------------------------
+
+static void writeReg(uint8_t reg, uint8_t val) {
+  Wire.beginTransmission(MPU9250_SLAVE_ADDRESS);
+  Wire.write(reg);
+  Wire.write(val);
+  Wire.endTransmission();
+}
+
+static void fifoReset() {
+  writeReg(MPU9250_USER_CTRL, 0x04);   // FIFO_RST (I2C master stays off: mag bypass)
+  writeReg(MPU9250_USER_CTRL, 0x40);   // FIFO_EN
+}
+
+// Accel only into the FIFO at 1 kHz: 6 bytes per sample, so the 512-byte
+// FIFO holds 85 ms and the sensor task drains it twice per SAMPLE_INTERVAL.
+// The 14-byte register read sees the same, wider-band accel, so imuRead()
+// logs the mean of the FIFO samples instead.
+static void fifoStart() {
+  writeReg(MPU9250_SMPLRT_DIV, 0);       // 1 kHz / (1 + 0)
+  writeReg(MPU9250_CONFIG, 0x41);        // FIFO_MODE: stop when full; gyro DLPF 184 Hz
+  writeReg(MPU9250_ACCEL_CONFIG2, 0x07); // accel DLPF 420 Hz at 1 kHz
+  writeReg(MPU9250_FIFO_EN, 0x08);       // ACCEL
+  vibRpmInit(vib, ENGINE_CYLINDERS);
+}
+
+// Feed every complete sample in the FIFO to the RPM estimator
+static void fifoDrain() {
+  if (!fifoRunning) {                    // not at imuInit(): tasks start much later
+    fifoReset();
+    fifoRunning = true;
+    return;
+  }
+  TRACE_BEGIN(TR_IMU_FIFO);
+  uint32_t t0 = micros();
+  Wire.beginTransmission(MPU9250_SLAVE_ADDRESS);
+  Wire.write(MPU9250_FIFO_COUNTH);
+  Wire.endTransmission(false);
+  Wire.requestFrom((uint8_t)MPU9250_SLAVE_ADDRESS, (uint8_t)2);
+  uint16_t count = 0;
+  if (Wire.available() >= 2) {
+    count = ((uint16_t)Wire.read() << 8) & 0x1F00;
+    count |= Wire.read();
+  }
+
+  // Full: samples were dropped, so the window has a gap. Start over.
+  if (count > MPU9250_FIFO_SIZE - 6) {
+    fifoReset();
+    vibRpmRestart(vib);
+    fifoOverflows++;
+    metricsInc(MC_IMU_FIFO_OVERFLOWS);
+    TRACE_END(TR_IMU_FIFO, 0);
+    return;
+  }
+
+  uint16_t samples = count / 6;
+  uint16_t left = samples * 6;
+  uint8_t buf[IMU_FIFO_CHUNK];
+  while (left > 0) {
+    uint8_t n = left > IMU_FIFO_CHUNK ? IMU_FIFO_CHUNK : left;
+    Wire.beginTransmission(MPU9250_SLAVE_ADDRESS);
+    Wire.write(MPU9250_FIFO_R_W);
+    Wire.endTransmission(false);
+    Wire.requestFrom((uint8_t)MPU9250_SLAVE_ADDRESS, n);
+    uint8_t got = 0;
+    while (got < n && Wire.available()) buf[got++] = Wire.read();
+    if (got < n) {                      // bus error: alignment lost
+      fifoReset();
+      vibRpmRestart(vib);
+      break;
+    }
+    for (uint8_t i = 0; i < n; i += 6) {
+      float acc[3];
+      for (uint8_t a = 0; a < 3; a++) {
+        acc[a] = (float)(int16_t)((buf[i + 2 * a] << 8) | buf[i + 2 * a + 1]) / 16384.0f;
+      }
+      if (vibRpmAdd(vib, acc)) vibMs = millis();
+      fifoAccSum[0] += acc[0];
+      fifoAccSum[1] += acc[1];
+      fifoAccSum[2] += acc[2];
+      fifoAccCount++;
+    }
+    left -= n;
+  }
+  uint32_t us = micros() - t0;
+  metricsObserve(MH_IMU_FIFO_US, us);
+  if (us > fifoMaxUs) fifoMaxUs = us;
+  fifoSamples += samples;
+  TRACE_END(TR_IMU_FIFO, samples);
+}
+
 //----------------------------------------------------------------
 // NVS Calibration Storage
 //----------------------------------------------------------------
 
+static void setMagSoftDiag(float x, float y, float z) {
+  memset(cal.magSoft, 0, sizeof(cal.magSoft));
+  cal.magSoft[0][0] = x;
+  cal.magSoft[1][1] = y;
+  cal.magSoft[2][2] = z;
+}
+
 static bool loadCalibration() {
   prefs.begin("imu-cal", true);  // read-only
   uint16_t magic = prefs.getUShort("magic", 0);
   if (magic != CAL_MAGIC) {
     prefs.end();
     memset(&cal, 0, sizeof(cal));
-    cal.magScale[0] = cal.magScale[1] = cal.magScale[2] = 1.0f;
+    setMagSoftDiag(1.0f, 1.0f, 1.0f);
     return false;
   }
   prefs.getBytes("accelBias", cal.accelBias, sizeof(cal.accelBias));
   prefs.getBytes("magBias", cal.magBias, sizeof(cal.magBias));
-  prefs.getBytes("magScale", cal.magScale, sizeof(cal.magScale));
+  if (prefs.getBytes("magSoft", cal.magSoft, sizeof(cal.magSoft)) != sizeof(cal.magSoft)) {
+    // Saved by the min/max calibration: per-axis scale on the diagonal
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+    prefs.getBytes("magScale", scale, sizeof(scale));
+    setMagSoftDiag(scale[0], scale[1], scale[2]);
+  }
   prefs.end();
-
-  // Gyro bias is always re-zeroed at boot
-  cal.gyroBias[0] = cal.gyroBias[1] = cal.gyroBias[2] = 0.0f;
   cal.magic = CAL_MAGIC;
   return true;
 }
 
-static void saveCalibration() {
-  prefs.begin("imu-cal", false);  // read-write
-  prefs.putUShort("magic", CAL_MAGIC);
-  prefs.putBytes("accelBias", cal.accelBias, sizeof(cal.accelBias));
-  prefs.putBytes("magBias", cal.magBias, sizeof(cal.magBias));
-  prefs.putBytes("magScale", cal.magScale, sizeof(cal.magScale));
+// The gyro model has its own key: valid without accel/mag cal, and
+// rewritten on its own as still periods refine it
+static bool loadGyroModel(GyroBiasModel &m) {
+  prefs.begin("imu-cal", true);
+  bool ok = prefs.getBytes("gyroModel", &m, sizeof(m)) == sizeof(m);
   prefs.end();
+  return ok && m.w > 0.0f;
+}
+
+static void saveGyroModel() {
+  Preferences p;   // sensor task: not the serial task's prefs instance
+  p.begin("imu-cal", false);
+  p.putBytes("gyroModel", &gyroTrk.model, sizeof(gyroTrk.model));
+  p.end();
+  memcpy(gyroSavedOffset, gyroTrk.offset, sizeof(gyroSavedOffset));
+  gyroModelSaved = true;
+  gyroSaveMs = millis();
+}
+
+// After a still window moved the model: persist it when the offset moved
+// more than GYRO_MODEL_SAVE_DPS, at most once per GYRO_MODEL_SAVE_MS.
+// A model not in NVS yet is written once two consecutive windows agree
+// within GYRO_MODEL_AGREE_DPS: one window alone may be a smooth cruise.
+static void gyroModelUpdated(float tempC) {
+  float change = 0.0f, disagree = 0.0f;
+  for (uint8_t i = 0; i < 3; i++) {
+    change = fmaxf(change, fabsf(gyroTrk.offset[i] - gyroSavedOffset[i]));
+    disagree = fmaxf(disagree, fabsf(gyroTrk.last[i] - gyroPrevWindow[i]));
+  }
+  memcpy(gyroPrevWindow, gyroTrk.last, sizeof(gyroPrevWindow));
+  bool save = gyroModelSaved
+    ? change > GYRO_MODEL_SAVE_DPS && millis() - gyroSaveMs >= GYRO_MODEL_SAVE_MS
+    : gyroTrk.windows >= 2 && disagree <= GYRO_MODEL_AGREE_DPS;
+  if (save) saveGyroModel();
+  if (save || gyroTrk.windows == 1) {
+    float bias[3];
+    gyroBiasAt(gyroTrk, tempC, bias);
+    Console.printf("INF: Gyro bias %.3f, %.3f, %.3f dps at %.1f C (%lu still windows)%s\n",
+      bias[0], bias[1], bias[2], tempC, (unsigned long)gyroTrk.windows,
+      save ? ", model saved to NVS" : "");
+  }
+}
+
+static void saveCalibration() {
+  Preferences p;   // sensor task: not the serial task's prefs instance
+  p.begin("imu-cal", false);  // read-write
+  p.putUShort("magic", CAL_MAGIC);
+  p.putBytes("accelBias", cal.accelBias, sizeof(cal.accelBias));
+  p.putBytes("magBias", cal.magBias, sizeof(cal.magBias));
+  p.putBytes("magSoft", cal.magSoft, sizeof(cal.magSoft));
+  p.remove("magScale");   // superseded by magSoft
+  p.end();
   cal.magic = CAL_MAGIC;
 }
 
+// Back to defaults and an empty NVS namespace: on the sensor task, or
+// on the caller's when there is no IMU and nothing reads cal
+static void calErase() {
+  memset(&cal, 0, sizeof(cal));
+  setMagSoftDiag(1.0f, 1.0f, 1.0f);
+
+  Preferences p;   // not the serial task's prefs instance
+  p.begin("imu-cal", false);
+  p.clear();
+  p.end();
+  gyroBiasInit(gyroTrk, nullptr);
+  gyroModelSaved = false;
+
+  Console.println("INF: Calibration erased from NVS");
+}
+
+//----------------------------------------------------------------
+// Calibration state machine (sensor task)
+//----------------------------------------------------------------
+
+static void calBegin(CalMode mode) {
+  calCount = 0;
+  calStartMs = millis();
+  for (uint8_t i = 0; i < 3; i++) {
+    calSum[i] = calSq[i] = 0.0f;
+  }
+  magFitReset(calMag);
+  calMode = mode;
+  if (mode == CAL_ACCEL) {
+    Console.printf("INF: Accel cal — place level, hold still (%d samples)...", IMU_CAL_ACCEL_SAMPLES);
+  } else {
+    Console.println("INF: Mag cal — slowly tumble sensor through all orientations");
+    Console.printf("INF: You have %lu seconds. Rotate in all axes...", IMU_CAL_MAG_MS / 1000UL);
+  }
+}
+
+static void calAccelDone() {
+  float mean[3];
+  float maxVar = 0.0f;
+  for (uint8_t i = 0; i < 3; i++) {
+    mean[i] = calSum[i] / IMU_CAL_ACCEL_SAMPLES;
+    maxVar = fmaxf(maxVar, calSq[i] / IMU_CAL_ACCEL_SAMPLES - mean[i] * mean[i]);
+  }
+  if (maxVar > IMU_CAL_ACCEL_VAR) {
+    Console.println(" moved");
+    Console.printf("ERR: Accel cal — sensor not still (%.3f g rms), not saved\n", sqrtf(maxVar));
+    return;
+  }
+
+  cal.accelBias[0] = mean[0];
+  cal.accelBias[1] = mean[1];
+  cal.accelBias[2] = mean[2] - 1.0f;  // expect +1g (chip Z-up at rest)
+
+  saveCalibration();
+  Console.println(" done, saved to NVS");
+  Console.printf("INF: Accel bias: %.4f, %.4f, %.4f g\n",
+    cal.accelBias[0], cal.accelBias[1], cal.accelBias[2]);
+}
+
+static void calMagDone() {
+  Console.println();
+  Console.printf("INF: %d samples collected\n", calCount);
+
+  float bias[3], soft[3][3];
+  MagFitQuality q;
+  MagFitResult r = magFitSolve(calMag, bias, soft, &q);
+  if (r == MAG_FIT_FEW) {
+    Console.printf("ERR: Mag cal needs at least %d samples\n", MAG_FIT_MIN_SAMPLES);
+    return;
+  }
+  if (r == MAG_FIT_SPREAD) {
+    Console.printf("ERR: Mag fit spread %.1f%% (max %.1f%%) — keep away from steel and tumble slowly, not saved\n",
+      q.spread * 100.0f, MAG_FIT_MAX_SPREAD * 100.0f);
+    return;
+  }
+  if (r == MAG_FIT_FLAT) {
+    Console.printf("ERR: Mag tumble covered %.0f%% on its thinnest axis (min %.0f%%) — rotate through all axes, not saved\n",
+      q.cover * 100.0f, MAG_FIT_MIN_COVER * 100.0f);
+    return;
+  }
+  if (r != MAG_FIT_OK) {
+    Console.println("ERR: Mag ellipsoid fit failed — did you rotate the sensor through all axes?");
+    return;
+  }
+
+  memcpy(cal.magBias, bias, sizeof(cal.magBias));
+  memcpy(cal.magSoft, soft, sizeof(cal.magSoft));
+
+  saveCalibration();
+  Console.println("INF: Mag cal saved to NVS");
+  Console.printf("INF: Field: %.1f uT, spread %.1f%%, coverage %.0f%%\n",
+    q.radius, q.spread * 100.0f, q.cover * 100.0f);
+  Console.printf("INF: Hard-iron: %.1f, %.1f, %.1f uT\n",
+    cal.magBias[0], cal.magBias[1], cal.magBias[2]);
+  for (uint8_t i = 0; i < 3; i++) {
+    Console.printf("INF: Soft-iron row %d: %.3f, %.3f, %.3f\n", i,
+      cal.magSoft[i][0], cal.magSoft[i][1], cal.magSoft[i][2]);
+  }
+}
+
+// One sample before any correction: accel in g, mag in uT (chip frame).
+// Progress dots roughly once a second; the result applies from the next
+// sample.
+static void calFeed(const float acc[3], const float mag[3]) {
+  if (calRequest != CAL_NONE) {
+    CalMode mode = calRequest;
+    calRequest = CAL_NONE;
+    calBegin(mode);
+  }
+  if (calMode == CAL_NONE) return;
+
+  calCount++;
+  if (calMode == CAL_ACCEL) {
+    for (uint8_t i = 0; i < 3; i++) {
+      calSum[i] += acc[i];
+      calSq[i] += acc[i] * acc[i];
+    }
+    if (calCount % 12 == 0) Console.print('.');
+    if (calCount < IMU_CAL_ACCEL_SAMPLES) return;
+    calMode = CAL_NONE;
+    calAccelDone();
+  } else {
+    magFitAdd(calMag, mag);
+    if (calCount % 12 == 0) Console.print('.');
+    if (millis() - calStartMs < IMU_CAL_MAG_MS) return;
+    calMode = CAL_NONE;
+    calMagDone();
+  }
+}
+
 //----------------------------------------------------------------
 // Public API
 //----------------------------------------------------------------
@@ -71,20 +399,33 @@ bool imuInit() {
 
   if (mpu9250.begin()) {
     ready = true;
-    Serial.println("INF: MPU9250 OK");
+    Console.println("INF: MPU9250 OK");
 
+    ahrsReset(ahrs);
+    fifoStart();
     if (loadCalibration()) {
-      Serial.println("INF: NVS calibration loaded");
+      Console.println("INF: NVS calibration loaded");
     } else {
-      Serial.println("INF: No NVS calibration (use 'c'/'m' to calibrate)");
+      Console.println("INF: No NVS calibration (use 'c'/'m' to calibrate)");
     }
 
-    imuCalibrateGyro();
+    // Start from the learned model; logging does not wait for stillness
+    GyroBiasModel m;
+    bool haveModel = loadGyroModel(m);
+    gyroBiasInit(gyroTrk, haveModel ? &m : nullptr);
+    gyroModelSaved = haveModel;
+    memcpy(gyroSavedOffset, gyroTrk.offset, sizeof(gyroSavedOffset));
+    if (haveModel) {
+      Console.printf("INF: Gyro model from NVS (offset %.3f, %.3f, %.3f dps @ %.0f C), refined at stops\n",
+        gyroTrk.offset[0], gyroTrk.offset[1], gyroTrk.offset[2], GB_TEMP_REF);
+    } else {
+      Console.println("INF: No stored gyro model, learning at the first stop");
+    }
     return true;
   }
 
   ready = false;
-  Serial.println("ERR: MPU9250 not found, continuing without IMU");
+  Console.println("ERR: MPU9250 not found, continuing without IMU");
   return false;
 }
 
@@ -96,8 +437,23 @@ const IMUCalibration& imuGetCalibration() {
   return cal;
 }
 
+void imuDrainFifo() {
+  if (ready) fifoDrain();
+}
+
 void imuRead(SensorData &data) {
   if (!ready) return;
+  if (eraseRequest) {
+    eraseRequest = false;
+    calErase();
+  }
+  fifoDrain();
+  bool vibFresh = vibMs && millis() - vibMs < VIB_RPM_STALE_MS;
+  data.rpm = vibFresh ? vib.rpm : 0.0f;
+  data.rpmConf = vibFresh ? vib.conf : 0;
+
+  TRACE_BEGIN(TR_IMU_READ);
+  uint32_t t0 = micros();
 
   // Burst read: accel(6) + temp(2) + gyro(6) = 14 bytes from 0x3B
   uint8_t buf[14];
@@ -114,10 +470,25 @@ void imuRead(SensorData &data) {
   int16_t rawAx = ((int16_t)buf[0]  << 8) | buf[1];
   int16_t rawAy = ((int16_t)buf[2]  << 8) | buf[3];
   int16_t rawAz = ((int16_t)buf[4]  << 8) | buf[5];
-  float chipAcc[3];
-  chipAcc[0] = (float)rawAx / 16384.0f - cal.accelBias[0];
-  chipAcc[1] = (float)rawAy / 16384.0f - cal.accelBias[1];
-  chipAcc[2] = (float)rawAz / 16384.0f - cal.accelBias[2];
+  float rawAcc[3], chipAcc[3];
+  rawAcc[0] = (float)rawAx / 16384.0f;
+  rawAcc[1] = (float)rawAy / 16384.0f;
+  rawAcc[2] = (float)rawAz / 16384.0f;
+  // Decimate 1 kHz to SAMPLE_INTERVAL: the mean of the FIFO samples since
+  // the last read is a boxcar low-pass with nulls at every multiple of the
+  // log rate, where the single register sample would alias engine
+  // vibration through the 420 Hz DLPF. The register value stays the
+  // fallback when the FIFO gave nothing (first read, overflow).
+  if (fifoAccCount > 0) {
+    rawAcc[0] = fifoAccSum[0] / fifoAccCount;
+    rawAcc[1] = fifoAccSum[1] / fifoAccCount;
+    rawAcc[2] = fifoAccSum[2] / fifoAccCount;
+    fifoAccSum[0] = fifoAccSum[1] = fifoAccSum[2] = 0.0f;
+    fifoAccCount = 0;
+  }
+  chipAcc[0] = rawAcc[0] - cal.accelBias[0];
+  chipAcc[1] = rawAcc[1] - cal.accelBias[1];
+  chipAcc[2] = rawAcc[2] - cal.accelBias[2];
 
   // Temperature (bytes 6-7)
   int16_t rawTemp = ((int16_t)buf[6] << 8) | buf[7];
@@ -128,16 +499,42 @@ void imuRead(SensorData &data) {
   int16_t rawGy = ((int16_t)buf[10] << 8) | buf[11];
   int16_t rawGz = ((int16_t)buf[12] << 8) | buf[13];
   float chipGyro[3];
-  chipGyro[0] = (float)rawGx / 131.0f - cal.gyroBias[0];
-  chipGyro[1] = (float)rawGy / 131.0f - cal.gyroBias[1];
-  chipGyro[2] = (float)rawGz / 131.0f - cal.gyroBias[2];
+  chipGyro[0] = (float)rawGx / 131.0f;
+  chipGyro[1] = (float)rawGy / 131.0f;
+  chipGyro[2] = (float)rawGz / 131.0f;
+  if (gyroResetRequest) {
+    gyroResetRequest = false;
+    gyroBiasInit(gyroTrk, nullptr);
+    gyroModelSaved = false;
+  }
+  // Wheel speed when a chain delivers VSS and it passes its plausibility
+  // check; otherwise GPS speed while it has a fix
+  bool vssOk = isp2Live(data, EQ_VSS) && !(data.engQual & EQ_VSS);
+  bool speedOk = vssOk || !data.gpsStale;
+
+  // Stopped: a speed source is valid, and every valid one reads below
+  // GB_STOP_MPH. With neither, a smooth cruise could pass for a stop.
+  // The tracker checks the window's accel/gyro variance itself.
+  bool stopped = speedOk && (!vssOk || data.vss < GB_STOP_MPH) &&
+                 (data.gpsStale || data.speed < GB_STOP_MPH);
+  if (gyroBiasFeed(gyroTrk, chipGyro, chipAcc, data.imuTemp, stopped)) {
+    gyroModelUpdated(data.imuTemp);
+  }
+  gyroBiasAt(gyroTrk, data.imuTemp, cal.gyroBias);
+  chipGyro[0] -= cal.gyroBias[0];
+  chipGyro[1] -= cal.gyroBias[1];
+  chipGyro[2] -= cal.gyroBias[2];
 
   // Magnetometer — separate AK8963 I2C device
   float chipMag[3];
   mpu9250.readMagnetXYZ(&chipMag[0], &chipMag[1], &chipMag[2]);
-  chipMag[0] = (chipMag[0] - cal.magBias[0]) * cal.magScale[0];
-  chipMag[1] = (chipMag[1] - cal.magBias[1]) * cal.magScale[1];
-  chipMag[2] = (chipMag[2] - cal.magBias[2]) * cal.magScale[2];
+  calFeed(rawAcc, chipMag);
+  float mx = chipMag[0] - cal.magBias[0];
+  float my = chipMag[1] - cal.magBias[1];
+  float mz = chipMag[2] - cal.magBias[2];
+  chipMag[0] = cal.magSoft[0][0] * mx + cal.magSoft[0][1] * my + cal.magSoft[0][2] * mz;
+  chipMag[1] = cal.magSoft[1][0] * mx + cal.magSoft[1][1] * my + cal.magSoft[1][2] * mz;
+  chipMag[2] = cal.magSoft[2][0] * mx + cal.magSoft[2][1] * my + cal.magSoft[2][2] * mz;
 
   // --- Axis remap: chip frame → car frame (SAE: X=fwd, Y=right, Z=down) ---
   data.accx = chipAcc[AXIS_FWD_IDX]    * AXIS_FWD_SIGN;
@@ -149,159 +546,96 @@ void imuRead(SensorData &data) {
   data.magx = chipMag[AXIS_FWD_IDX]    * AXIS_FWD_SIGN;
   data.magy = chipMag[AXIS_RIGHT_IDX]  * AXIS_RIGHT_SIGN;
   data.magz = chipMag[AXIS_DOWN_IDX]   * AXIS_DOWN_SIGN;
-}
-
-void imuCalibrateGyro() {
-  float sum[3] = {0, 0, 0};
-
-  Serial.print("INF: Gyro zero — hold still (");
-  Serial.print(GYRO_CAL_SAMPLES);
-  Serial.print(" samples)...");
-
-  for (int i = 0; i < GYRO_CAL_SAMPLES; i++) {
-    uint8_t buf[6];
-    Wire.beginTransmission(MPU9250_SLAVE_ADDRESS);
-    Wire.write(0x43);  // GYRO_XOUT_H
-    Wire.endTransmission(false);
-    Wire.requestFrom((uint8_t)MPU9250_SLAVE_ADDRESS, (uint8_t)6);
-    for (uint8_t j = 0; j < 6 && Wire.available(); j++) {
-      buf[j] = Wire.read();
-    }
-    int16_t gx = ((int16_t)buf[0] << 8) | buf[1];
-    int16_t gy = ((int16_t)buf[2] << 8) | buf[3];
-    int16_t gz = ((int16_t)buf[4] << 8) | buf[5];
-    sum[0] += (float)gx / 131.0f;
-    sum[1] += (float)gy / 131.0f;
-    sum[2] += (float)gz / 131.0f;
-    delay(10);
-  }
-
-  cal.gyroBias[0] = sum[0] / GYRO_CAL_SAMPLES;
-  cal.gyroBias[1] = sum[1] / GYRO_CAL_SAMPLES;
-  cal.gyroBias[2] = sum[2] / GYRO_CAL_SAMPLES;
 
-  Serial.println(" done");
-  Serial.printf("INF: Gyro bias: %.3f, %.3f, %.3f dps\n",
-    cal.gyroBias[0], cal.gyroBias[1], cal.gyroBias[2]);
+  // --- Attitude and gravity-free accel (car frame) ---
+  // Without a speed the filter cannot take the car's own motion out, so
+  // lin* is flagged (linOk) and readers fall back to accx/accy
+  float mph = vssOk ? data.vss : speedOk ? data.speed : 0.0f;
+  // Mag only once tumble-calibrated: raw, it is mostly the car's steel
+  bool magCal = cal.magBias[0] != 0.0f || cal.magBias[1] != 0.0f || cal.magBias[2] != 0.0f;
+  float gyro[3] = { data.rotx, data.roty, data.rotz };
+  float acc[3]  = { data.accx, data.accy, data.accz };
+  float mag[3]  = { data.magx, data.magy, data.magz };
+  uint32_t now = micros();
+  ahrsUpdate(ahrs, gyro, acc, magCal ? mag : nullptr, mph * 0.44704f, speedOk,
+             ahrsUs ? (now - ahrsUs) * 1e-6f : 0.0f);
+  ahrsUs = now;
+  ahrsEuler(ahrs, data.roll, data.pitch, data.yaw);
+  float lin[3];
+  ahrsLinear(ahrs, acc, lin);
+  data.linx = lin[0];
+  data.liny = lin[1];
+  data.linz = lin[2];
+  data.linOk = speedOk;
+
+  metricsObserve(MH_IMU_READ_US, micros() - t0);
+  TRACE_END(TR_IMU_READ, 0);
 }
 
-void imuCalibrateAccel() {
-  const int N = 256;
-  float sum[3] = {0, 0, 0};
-
-  Serial.printf("INF: Accel cal — place level, hold still (%d samples)...", N);
-
-  for (int i = 0; i < N; i++) {
-    uint8_t buf[6];
-    Wire.beginTransmission(MPU9250_SLAVE_ADDRESS);
-    Wire.write(MPU9250_ACCEL_XOUT_H);
-    Wire.endTransmission(false);
-    Wire.requestFrom((uint8_t)MPU9250_SLAVE_ADDRESS, (uint8_t)6);
-    for (uint8_t j = 0; j < 6 && Wire.available(); j++) {
-      buf[j] = Wire.read();
-    }
-    int16_t ax = ((int16_t)buf[0] << 8) | buf[1];
-    int16_t ay = ((int16_t)buf[2] << 8) | buf[3];
-    int16_t az = ((int16_t)buf[4] << 8) | buf[5];
-    sum[0] += (float)ax / 16384.0f;
-    sum[1] += (float)ay / 16384.0f;
-    sum[2] += (float)az / 16384.0f;
-    delay(10);
-  }
-
-  cal.accelBias[0] = sum[0] / N;
-  cal.accelBias[1] = sum[1] / N;
-  cal.accelBias[2] = sum[2] / N - 1.0f;  // expect +1g (chip Z-up at rest)
-
-  saveCalibration();
-  Serial.println(" done, saved to NVS");
-  Serial.printf("INF: Accel bias: %.4f, %.4f, %.4f g\n",
-    cal.accelBias[0], cal.accelBias[1], cal.accelBias[2]);
+void imuResetGyroModel() {
+  gyroResetRequest = true;
 }
 
-void imuCalibrateMag() {
-  float minV[3] = { 9999,  9999,  9999};
-  float maxV[3] = {-9999, -9999, -9999};
-  const unsigned long duration = 15000;
-  unsigned long start = millis();
-  int samples = 0;
-
-  Serial.println("INF: Mag cal — slowly tumble sensor through all orientations");
-  Serial.println("INF: You have 15 seconds. Rotate in all axes...");
-
-  while (millis() - start < duration) {
-    float mx, my, mz;
-    mpu9250.readMagnetXYZ(&mx, &my, &mz);
-
-    if (mx < minV[0]) minV[0] = mx;
-    if (mx > maxV[0]) maxV[0] = mx;
-    if (my < minV[1]) minV[1] = my;
-    if (my > maxV[1]) maxV[1] = my;
-    if (mz < minV[2]) minV[2] = mz;
-    if (mz > maxV[2]) maxV[2] = mz;
-    samples++;
-
-    if (samples % 200 == 0) Serial.print('.');
-    delay(10);
-  }
-
-  Serial.println();
-  Serial.printf("INF: %d samples collected\n", samples);
-
-  cal.magBias[0] = (maxV[0] + minV[0]) / 2.0f;
-  cal.magBias[1] = (maxV[1] + minV[1]) / 2.0f;
-  cal.magBias[2] = (maxV[2] + minV[2]) / 2.0f;
-
-  float range[3];
-  range[0] = (maxV[0] - minV[0]) / 2.0f;
-  range[1] = (maxV[1] - minV[1]) / 2.0f;
-  range[2] = (maxV[2] - minV[2]) / 2.0f;
-  float avgRange = (range[0] + range[1] + range[2]) / 3.0f;
-
-  if (avgRange < 1.0f) {
-    Serial.println("ERR: Mag range too small — did you rotate the sensor?");
-    return;
-  }
+bool imuCalibrating() {
+  return calMode != CAL_NONE || calRequest != CAL_NONE || eraseRequest;
+}
 
-  cal.magScale[0] = avgRange / range[0];
-  cal.magScale[1] = avgRange / range[1];
-  cal.magScale[2] = avgRange / range[2];
+bool imuStartAccelCal() {
+  if (imuCalibrating()) return false;
+  calRequest = CAL_ACCEL;
+  return true;
+}
 
-  saveCalibration();
-  Serial.println("INF: Mag cal saved to NVS");
-  Serial.printf("INF: Hard-iron: %.1f, %.1f, %.1f uT\n",
-    cal.magBias[0], cal.magBias[1], cal.magBias[2]);
-  Serial.printf("INF: Soft-iron: %.3f, %.3f, %.3f\n",
-    cal.magScale[0], cal.magScale[1], cal.magScale[2]);
+bool imuStartMagCal() {
+  if (imuCalibrating()) return false;
+  calRequest = CAL_MAG;
+  return true;
 }
 
 void imuPrintCalibration() {
-  Serial.println("--- IMU Calibration ---");
+  Console.println("--- IMU Calibration ---");
   bool valid = (cal.magic == CAL_MAGIC);
-  Serial.printf("NVS:        %s\n", valid ? "VALID" : "EMPTY (using defaults)");
-  Serial.printf("Gyro bias:  %.3f, %.3f, %.3f dps (auto-zeroed at boot)\n",
+  Console.printf("NVS:        %s%s\n", valid ? "VALID" : "EMPTY (using defaults)",
+    calMode == CAL_ACCEL ? ", accel cal running" : calMode == CAL_MAG ? ", mag cal running" : "");
+  Console.printf("Gyro bias:  %.3f, %.3f, %.3f dps (now)\n",
     cal.gyroBias[0], cal.gyroBias[1], cal.gyroBias[2]);
-  Serial.printf("Accel bias: %.4f, %.4f, %.4f g\n",
+  Console.printf("Gyro model: %.3f, %.3f, %.3f dps @ %.0f C, slope %.4f, %.4f, %.4f dps/C\n",
+    gyroTrk.offset[0], gyroTrk.offset[1], gyroTrk.offset[2], GB_TEMP_REF,
+    gyroTrk.slope[0], gyroTrk.slope[1], gyroTrk.slope[2]);
+  Console.printf("            weight %.1f, %lu still windows, %lu rejected (motion)%s\n",
+    gyroTrk.model.w, (unsigned long)gyroTrk.windows, (unsigned long)gyroTrk.rejects,
+    gyroModelSaved ? "" : ", not in NVS");
+  Console.printf("Accel bias: %.4f, %.4f, %.4f g\n",
     cal.accelBias[0], cal.accelBias[1], cal.accelBias[2]);
-  Serial.printf("Mag bias:   %.1f, %.1f, %.1f uT\n",
+  Console.printf("Mag bias:   %.1f, %.1f, %.1f uT\n",
     cal.magBias[0], cal.magBias[1], cal.magBias[2]);
-  Serial.printf("Mag scale:  %.3f, %.3f, %.3f\n",
-    cal.magScale[0], cal.magScale[1], cal.magScale[2]);
+  for (uint8_t i = 0; i < 3; i++) {
+    Console.printf("%s %.3f, %.3f, %.3f\n", i == 0 ? "Mag soft:  " : "           ",
+      cal.magSoft[i][0], cal.magSoft[i][1], cal.magSoft[i][2]);
+  }
+  Console.printf("Vib RPM:    %.0f rpm, %u%% (%d cyl), %lu windows, %lu FIFO overflows\n",
+    vib.rpm, vib.conf, ENGINE_CYLINDERS, (unsigned long)vib.windows, (unsigned long)fifoOverflows);
+  // Drain cost, I2C burst included; the ns per sample compare with vib_rpm_bench
+  const MetricHist &fh = metricHists[MH_IMU_FIFO_US];
+  uint32_t drains = fh.count.load(std::memory_order_relaxed);
+  uint32_t drainUs = fh.sumUs.load(std::memory_order_relaxed);
+  Console.printf("FIFO drain: %lu/%lu us avg/max, %lu ns per sample\n",
+    (unsigned long)(drains ? drainUs / drains : 0), (unsigned long)fifoMaxUs,
+    (unsigned long)(fifoSamples ? (uint64_t)drainUs * 1000 / fifoSamples : 0));
 
   const char* axisName[] = {"X", "Y", "Z"};
-  Serial.printf("Axis remap: fwd=%s%s right=%s%s down=%s%s\n",
+  Console.printf("Axis remap: fwd=%s%s right=%s%s down=%s%s\n",
     axisName[AXIS_FWD_IDX], AXIS_FWD_SIGN > 0 ? "+" : "-",
     axisName[AXIS_RIGHT_IDX], AXIS_RIGHT_SIGN > 0 ? "+" : "-",
     axisName[AXIS_DOWN_IDX], AXIS_DOWN_SIGN > 0 ? "+" : "-");
 }
 
-void imuEraseCalibration() {
-  memset(&cal, 0, sizeof(cal));
-  cal.magScale[0] = cal.magScale[1] = cal.magScale[2] = 1.0f;
-
-  prefs.begin("imu-cal", false);
-  prefs.clear();
-  prefs.end();
-
-  Serial.println("INF: Calibration erased from NVS");
+bool imuEraseCalibration() {
+  if (imuCalibrating()) return false;
+  if (ready) {
+    eraseRequest = true;
+  } else {
+    calErase();
+  }
+  return true;
 }
@@ -3,6 +3,7 @@
  *
  *  Burst I2C read for accel+temp+gyro (14 bytes from 0x3B),
  *  magnetometer via FaBo9Axis library, calibration + axis remap.
+ *  Accel also streams at 1 kHz through the chip FIFO for engine RPM.
  */
 #ifndef AB_IMU_H
 #define AB_IMU_H
@@ -14,26 +15,47 @@
 bool imuInit();
 
 // Read all 9 axes + temperature into SensorData.
-// Applies calibration biases and axis remapping.
+// Applies calibration biases and axis remapping, then runs the attitude
+// filter (ahrs.h) for roll/pitch/yaw and gravity-free linx/liny/linz.
+// Reads data.vss, data.speed, data.gpsStale, data.engQual and whether a
+// chain delivers VSS (isp2Live): stops are where the gyro bias model
+// (gyro_bias.h) learns, and speed takes the car's own acceleration out
+// of the filter's gravity reference. With no speed, data.linOk is false.
+// Also drains the accel FIFO and reports the vibration RPM estimate
+// (vib_rpm.h) in data.rpm / data.rpmConf.
 void imuRead(SensorData &data);
 
-// Auto-zero gyroscope: average GYRO_CAL_SAMPLES readings.
-// Must be called while car is stationary. Takes ~2.5s.
-void imuCalibrateGyro();
+// Feed the 1 kHz accel FIFO to the RPM estimator. The FIFO overflows in
+// ~85 ms, so the sensor task calls this between imuRead()s.
+void imuDrainFifo();
 
-// Calibrate accelerometer: average 256 samples on level surface.
-// Saves to NVS.
-void imuCalibrateAccel();
+// Forget the learned gyro bias model (e.g. after moving the board);
+// imuRead() relearns it from the next stop. Safe from any task.
+void imuResetGyroModel();
 
-// Calibrate magnetometer: tumble sensor through all orientations for 15s.
-// Saves hard-iron and soft-iron correction to NVS.
-void imuCalibrateMag();
+// Calibration runs inside imuRead() on the sensor task's own samples
+// (no second I2C user, logging and streaming carry on), prints progress
+// dots and its result, and saves to NVS when done. The start calls only
+// queue it, from any task, and return false if one is already running.
 
-// Print current calibration values to Serial.
+// Accelerometer: average IMU_CAL_ACCEL_SAMPLES on a level surface;
+// rejected if the sensor moved.
+bool imuStartAccelCal();
+
+// Magnetometer: tumble sensor through all orientations for IMU_CAL_MAG_MS.
+// Hard-iron and soft-iron correction.
+bool imuStartMagCal();
+
+// Accel or mag calibration (or an erase) queued or running?
+bool imuCalibrating();
+
+// Print current calibration values to Console.
 void imuPrintCalibration();
 
-// Erase NVS calibration, revert to defaults.
-void imuEraseCalibration();
+// Erase NVS calibration, revert to defaults. Queued like the gyro reset:
+// the sensor task applies it at its next sample. Refused (false) while a
+// calibration runs.
+bool imuEraseCalibration();
 
 // Get reference to calibration struct (for status display)
 const IMUCalibration& imuGetCalibration();
@@ -2,165 +2,188 @@
  *  Analog Bridge — ISP2 Implementation
  *
  *  Ported from AVR analog-bridge.ino lines 446-939.
- *  Nearly verbatim — the ISP2 state machine is platform-agnostic.
  *
  *  Changes from AVR:
- *    - HardwareSerial(2) with explicit pin assignment
- *    - Uses shared isp2_defs.h for protocol constants
+ *    - One HardwareSerial per chain (ISP2_CHAINS) with explicit pins
+ *    - Framing and decode come from shared isp2_parser.h (same parser as
+ *      the AVR sketch and host tools), words routed through the runtime
+ *      channel map instead of the compile-time Nova map
+ *    - Bulk UART reads; the main chain's optionally mirrored to the raw
+ *      capture and the USB pass-through
+ *    - Engine channels checked after every packet (engine_validate.h),
+ *      per chain
  *    - No F() macros
  */
 #include "isp2.h"
 #include "config.h"
 #include <Arduino.h>
 #include "isp2_defs.h"
-
-static HardwareSerial isp2Serial(ISP2_UART_NUM);
-
-// ISP2 state machine
-enum ISP2State { ISP2_SYNC_HIGH, ISP2_SYNC_LOW, ISP2_READING_PAYLOAD };
-static ISP2State isp2State       = ISP2_SYNC_HIGH;
-static byte      isp2Header[2];
-static byte      isp2Data[ISP2_MAX_WORDS * 2];
-static int       isp2PacketLen   = 0;
-static bool      isp2IsData      = false;
-static int       isp2BytesRead   = 0;
-static int       isp2BytesExpected = 0;
-static unsigned long isp2LastByte = 0;
-
-static uint8_t   isp2AuxCount   = 0;
-static uint8_t   isp2Lc1Count   = 0;
+#include "isp2_map.h"
+#include "isp2_parser.h"
+#include "engine_validate.h"
+#include "logging/raw_capture.h"
+#include "ui/passthrough.h"
+#include "ui/console.h"
+#include "diag/trace.h"
+
+static const uint8_t isp2UartNums[ISP2_CHAINS] = ISP2_UART_NUMS;
+static const int8_t  isp2RxPins[ISP2_CHAINS]   = ISP2_RX_PINS;
+static const int8_t  isp2TxPins[ISP2_CHAINS]   = ISP2_TX_PINS;
+
+static_assert(ISP2_CHAINS <= ISP2_MAX_CHAINS, "SensorData::isp2Us has too few slots");
+
+struct Isp2Chain {
+  HardwareSerial *serial;
+  ISP2Parser      parser;
+  EngineValidator val;
+  uint8_t         auxCount;
+  uint8_t         lc1Count;
+};
+
+static Isp2Chain chains[ISP2_CHAINS] = {};
 
 //----------------------------------------------------------------
-// Process a complete ISP2 data packet
+// Byte source: bulk UART reads. On the main chain each read is mirrored
+// to the raw capture with the timestamp the parser uses, so a replay of
+// the capture is bit-exact, and teed to the USB pass-through when it is on
 //----------------------------------------------------------------
-static void processISP2Data(SensorData &data) {
-  uint8_t auxIdx = 0;
-  uint8_t lc1Idx = 0;
-  float auxV[8];
-  float afrVal[4];
-
-  int w = 0;
-  while (w < isp2PacketLen) {
-    byte hi = isp2Data[w * 2];
-    byte lo = isp2Data[w * 2 + 1];
-
-    if (hi & ISP2_LC1_FLAG) {
-      // LC-1 header word
-      int func    = (hi >> 2) & 0x07;
-      int afrMult = ((hi & 0x01) << 7) | (lo & 0x7F);
-
-      // Next word is lambda
-      w++;
-      if (w >= isp2PacketLen) break;
-      hi = isp2Data[w * 2];
-      lo = isp2Data[w * 2 + 1];
-
-      int lambda = ((hi & 0x3F) << 7) | (lo & 0x7F);
-
-      if (lc1Idx < 4) {
-        if (func <= 1) {
-          afrVal[lc1Idx] = ((float)(lambda + 500) * (float)afrMult) / 10000.0f;
-        } else {
-          afrVal[lc1Idx] = 0.0f;
-        }
-      }
-      lc1Idx++;
-    } else {
-      // Aux sensor word: 10-bit value
-      int raw = ((hi & 0x07) << 7) | (lo & 0x7F);
-      if (auxIdx < 8) {
-        auxV[auxIdx] = (float)raw / 1023.0f * 5.0f;
-      }
-      auxIdx++;
+struct UartSource {
+  HardwareSerial &serial;
+  bool main;
+  uint32_t nowUs;
+
+  size_t read(uint8_t *buf, size_t max) {
+    int avail = serial.available();
+    if (avail <= 0) return 0;
+    size_t n = serial.read(buf, (size_t)avail < max ? (size_t)avail : max);
+    if (main) {
+      rawCaptureRecord(buf, n, nowUs);
+      passthruRecord(buf, n);
     }
-    w++;
+    return n;
   }
+};
 
-  isp2AuxCount = auxIdx;
-  isp2Lc1Count = lc1Idx;
+//----------------------------------------------------------------
+// Packet sink: routes each word by its chain position through the
+// chain's dispatch table (isp2_map.h): one LUT load and one store per
+// word. Each packet then checks the channels this chain writes and
+// stamps the chain's merge time.
+//----------------------------------------------------------------
+struct MapSink {
+  uint8_t chain;
+  const Isp2Dispatch &map;
+  SensorData &data;
+
+  void lc1(uint8_t idx, uint8_t status, float afr, uint16_t detail) {
+    if (idx >= ISP2_LC1_SLOTS) return;
+    const Isp2Lc1Slot &slot = map.lc1[idx];
+    if (slot.field)  data.*slot.field = afr;
+    if (slot.status) data.*slot.status = status;
+    if (slot.detail) data.*slot.detail = detail;
+  }
 
-  // Map aux channels (daisy-chain order)
-  if (auxIdx >= 1) data.coolant = AUX_COOLANT_F(auxV[0]);
-  if (auxIdx >= 2) data.oilp    = AUX_OILP_PSI(auxV[1]);
-  if (auxIdx >= 3) data.map     = AUX_MAP_INHG(auxV[2]);
-  if (auxIdx >= 4) data.vss     = AUX_VSS_MPH(auxV[3]);
+  void aux(uint8_t idx, uint16_t raw) {
+    if (idx >= ISP2_AUX_SLOTS) return;
+    const Isp2AuxSlot &slot = map.aux[idx];
+    if (slot.field) data.*slot.field = CAL_LUT_READ(&slot.lut[raw >> CAL_LUT_SHIFT]);
+  }
 
-  // Map LC-1 devices to AFR
-  if (lc1Idx >= 1) data.afr  = afrVal[0];
-  if (lc1Idx >= 2) data.afr1 = afrVal[1];
+  void done(const ISP2Parser &p, ISP2Layout layout) {
+    Isp2Chain &c = chains[chain];
+    c.auxCount = layout.auxCount;
+    c.lc1Count = layout.lc1Count;
+    isp2MapCheckLayout(chain, layout.auxCount, layout.lc1Count);
+    engineValidate(c.val, data, p.stats.lastPacketUs, map.channels);
+    data.isp2Us[chain] = p.stats.lastPacketUs;
+    TRACE_INSTANT(TR_ISP2_PACKET, p.packetLen);
 
 #ifdef ISP2_DEBUG
-  Serial.printf("ISP2: %dxLC1 %dxAUX | AFR=%.1f AFR1=%.1f VSS=%.1fmph MAP=%.1f OIL=%.0f CLT=%.0f\n",
-    lc1Idx, auxIdx, data.afr, data.afr1, data.vss, data.map, data.oilp, data.coolant);
+    Console.printf("ISP2[%d]: %dxLC1 %dxAUX | AFR=%.1f (%s) AFR1=%.1f (%s) VSS=%.1fmph MAP=%.1f OIL=%.0f CLT=%.0f EGT=%.0f FUEL=%.1f Q=%02X\n",
+      chain, layout.lc1Count, layout.auxCount, data.afr, lc1StatusName(data.afrStat),
+      data.afr1, lc1StatusName(data.afr1Stat), data.vss, data.map, data.oilp, data.coolant,
+      data.egt, data.fuelp, data.engQual);
 #endif
-}
+  }
+};
 
 //----------------------------------------------------------------
 // Public API
 //----------------------------------------------------------------
 
 void isp2Init() {
-  isp2Serial.begin(ISP2_BAUD, SERIAL_8N1, ISP2_RX_PIN, ISP2_TX_PIN);
-  Serial.println("INF: ISP2 @ 19200");
+  isp2MapInit();
+  for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+    Isp2Chain &c = chains[ch];
+    c.serial = new HardwareSerial(isp2UartNums[ch]);
+    c.serial->begin(ISP2_BAUD, SERIAL_8N1, isp2RxPins[ch], isp2TxPins[ch]);
+    c.serial->onReceiveError([&c](hardwareSerial_error_t err) {
+      if (err == UART_BUFFER_FULL_ERROR || err == UART_FIFO_OVF_ERROR) {
+        c.parser.stats.overflows++;
+      }
+    });
+    Console.printf("INF: ISP2 chain %d @ 19200 (UART%d RX%d)\n",
+      ch, isp2UartNums[ch], isp2RxPins[ch]);
+  }
 }
 
-HardwareSerial& isp2GetSerial() {
-  return isp2Serial;
+HardwareSerial& isp2GetSerial(uint8_t chain) {
+  return *chains[chain].serial;
 }
 
-uint8_t isp2GetAuxCount() { return isp2AuxCount; }
-uint8_t isp2GetLc1Count() { return isp2Lc1Count; }
-int     isp2GetState()    { return (int)isp2State; }
+uint8_t isp2GetAuxCount(uint8_t chain) { return chains[chain].auxCount; }
+uint8_t isp2GetLc1Count(uint8_t chain) { return chains[chain].lc1Count; }
+int     isp2GetState(uint8_t chain)    { return (int)chains[chain].parser.state; }
+const ISP2Stats& isp2GetStats(uint8_t chain) { return chains[chain].parser.stats; }
+
+bool isp2Live(const SensorData &data, uint8_t channels) {
+  uint32_t now = micros();
+  for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+    uint32_t us = data.isp2Us[ch];
+    if ((isp2MapDispatch(ch).channels & channels) && us != 0 &&
+        now - us < ISP2_STALE_MS * 1000UL) {
+      return true;
+    }
+  }
+  return false;
+}
 
-void isp2Read(SensorData &data) {
-  // Watchdog: resync if stuck mid-payload
-  if (isp2State == ISP2_READING_PAYLOAD &&
-      (millis() - isp2LastByte > ISP2_TIMEOUT_MS)) {
-    isp2State = ISP2_SYNC_HIGH;
+void isp2PrintStats(Print &out) {
+  for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+    const ISP2Stats &s = chains[ch].parser.stats;
+    const EngineValidator &v = chains[ch].val;
+    if (ISP2_CHAINS > 1) out.printf("-- Chain %d --\n", ch);
+    out.printf("Bytes: %lu  Packets: %lu (+%lu non-data)  Discarded: %lu\n",
+      (unsigned long)s.bytes, (unsigned long)s.packets,
+      (unsigned long)s.otherPackets, (unsigned long)s.discarded);
+    out.printf("Sync losses: %lu  Timeouts: %lu  Bad lengths: %lu  Overflows: %lu\n",
+      (unsigned long)s.syncLosses, (unsigned long)s.timeouts,
+      (unsigned long)s.badLengths, (unsigned long)s.overflows);
+    out.printf("Interval: min %.1f / avg %.1f / max %.1f ms (nominal %.2f)\n",
+      s.intervalMinUs / 1000.0f, isp2StatsMeanUs(s) / 1000.0f,
+      s.intervalMaxUs / 1000.0f, ISP2_FRAME_US / 1000.0f);
+    out.printf("Missed frames: %lu  Outages: %lu  Capture: %.2f%%\n",
+      (unsigned long)s.missedFrames, (unsigned long)s.outages, isp2StatsCapturePct(s));
+    out.printf("Rejected: %lu range  %lu rate  %lu VSS/GPS  (of %lu packets)\n",
+      (unsigned long)v.rangeRejects, (unsigned long)v.rateRejects,
+      (unsigned long)v.crossRejects, (unsigned long)v.packets);
   }
+}
 
-  while (isp2Serial.available() > 0) {
-    byte b = isp2Serial.read();
-    isp2LastByte = millis();
-
-    switch (isp2State) {
-      case ISP2_SYNC_HIGH:
-        if ((b & ISP2_H_SYNC_MASK) == ISP2_H_SYNC_MASK) {
-          isp2Header[0] = b;
-          isp2State = ISP2_SYNC_LOW;
-        }
-        break;
-
-      case ISP2_SYNC_LOW:
-        if ((b & ISP2_L_SYNC_MASK) == ISP2_L_SYNC_MASK) {
-          isp2Header[1] = b;
-          isp2IsData = bitRead(isp2Header[0], 4);
-          isp2PacketLen = ((isp2Header[0] & 0x01) << 7) | (isp2Header[1] & 0x7F);
-
-          if (isp2PacketLen > 0 && isp2PacketLen <= ISP2_MAX_WORDS) {
-            isp2BytesExpected = isp2PacketLen * 2;
-            isp2BytesRead = 0;
-            isp2State = ISP2_READING_PAYLOAD;
-          } else {
-            isp2State = ISP2_SYNC_HIGH;
-          }
-        } else if ((b & ISP2_H_SYNC_MASK) == ISP2_H_SYNC_MASK) {
-          isp2Header[0] = b;
-          // stay in SYNC_LOW — treat as new high sync
-        } else {
-          isp2State = ISP2_SYNC_HIGH;
-        }
-        break;
-
-      case ISP2_READING_PAYLOAD:
-        isp2Data[isp2BytesRead++] = b;
-        if (isp2BytesRead >= isp2BytesExpected) {
-          if (isp2IsData) {
-            processISP2Data(data);
-          }
-          isp2State = ISP2_SYNC_HIGH;
-        }
-        break;
+void isp2Read(SensorData &data) {
+  for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+    Isp2Chain &c = chains[ch];
+    uint32_t nowUs = micros();
+    if (c.serial->available() <= 0) {
+      c.parser.tick(nowUs);
+      continue;
     }
+    TRACE_BEGIN(TR_ISP2_RX);
+
+    UartSource src = { *c.serial, ch == 0, nowUs };
+    MapSink sink = { ch, isp2MapDispatch(ch), data };
+    uint32_t bytes = c.parser.poll(src, nowUs, sink);
+
+    TRACE_END(TR_ISP2_RX, bytes);
   }
 }
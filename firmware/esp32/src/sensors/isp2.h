@@ -4,27 +4,42 @@
  *  Non-blocking state machine parser for the ISP2 serial protocol.
  *  Decodes LC-1 wideband AFR and SSI-4 aux sensor data.
  *
+ *  Up to ISP2_CHAINS independent chains, each on its own UART with its
+ *  own parser, channel map (isp2_map.h), statistics and plausibility
+ *  state. All chains merge into the same SensorData; each stamps
+ *  isp2Us[chain] when it writes. Chain 0 is the main chain: raw capture
+ *  and USB pass-through follow it.
+ *
  *  On ESP32: runs as a high-priority FreeRTOS task driven by UART events.
  */
 #ifndef AB_ISP2_H
 #define AB_ISP2_H
 
 #include "sensor_data.h"
+#include "isp2_stats.h"
 #include <HardwareSerial.h>
 
-// Initialize UART2 for ISP2 at 19200 baud.
+// Initialize the ISP2 UARTs at 19200 baud.
 void isp2Init();
 
-// Process available bytes from the ISP2 serial buffer.
+// Process available bytes from every chain's serial buffer.
 // Called from the ISP2 FreeRTOS task. Non-blocking.
 void isp2Read(SensorData &data);
 
 // Get diagnostic info
-uint8_t isp2GetAuxCount();
-uint8_t isp2GetLc1Count();
-int     isp2GetState();
+uint8_t isp2GetAuxCount(uint8_t chain);
+uint8_t isp2GetLc1Count(uint8_t chain);
+int     isp2GetState(uint8_t chain);
+
+// Link-quality counters and packet interval statistics
+const ISP2Stats& isp2GetStats(uint8_t chain);
+void isp2PrintStats(Print &out);
+
+// Is one of these channels (EQ_* bits) live? True when a chain whose map
+// writes it merged a packet within ISP2_STALE_MS. Any task.
+bool isp2Live(const SensorData &data, uint8_t channels);
 
-// Access the serial port (for task setup)
-HardwareSerial& isp2GetSerial();
+// Access a chain's serial port (pass-through writes to chain 0)
+HardwareSerial& isp2GetSerial(uint8_t chain);
 
 #endif // AB_ISP2_H
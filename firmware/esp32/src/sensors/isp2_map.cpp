@@ -0,0 +1,287 @@
+/**
+ *  Analog Bridge — ISP2 Channel Map Implementation
+ */
+#include "isp2_map.h"
+#include "isp2.h"
+#include "config.h"
+#include "isp2_defs.h"
+#include "engine_validate.h"
+#include "ui/console.h"
+#include <Preferences.h>
+
+#define ISP2_MAP_MAGIC       0x1501
+#define ISP2_LAYOUT_CONFIRM  3      // packets in a row before a layout counts
+
+static Preferences prefs;
+
+struct MapState {
+  Isp2ChannelMap map;
+
+  // Two dispatch tables: the serial task builds the idle one, then swaps
+  Isp2Dispatch dispatch[2];
+  Isp2Dispatch* volatile active;
+
+  // Layout change detection (ISP2 task only)
+  uint8_t layoutAux, layoutLc1;     // accepted layout
+  uint8_t pendingAux, pendingLc1;   // candidate layout
+  uint8_t pendingCount;
+};
+
+static MapState chains[ISP2_CHAINS];
+
+// NVS keys: chain 0 keeps the single-chain key
+static const char* const mapKeys[] = { "map", "map1", "map2", "map3" };
+static_assert(ISP2_CHAINS <= sizeof(mapKeys) / sizeof(mapKeys[0]), "add NVS keys for extra chains");
+
+static const char* const destNames[ISP2_DEST_COUNT] = {
+  "none", "coolant", "oilp", "map", "vss", "afr", "afr1", "egt", "fuelp"
+};
+
+static float SensorData::* const destFields[ISP2_DEST_COUNT] = {
+  nullptr, &SensorData::coolant, &SensorData::oilp, &SensorData::map,
+  &SensorData::vss, &SensorData::afr, &SensorData::afr1,
+  &SensorData::egt, &SensorData::fuelp
+};
+
+// Plausibility check for each destination (engine_validate.h)
+static const uint8_t destChecks[ISP2_DEST_COUNT] = {
+  0, EQ_COOLANT, EQ_OILP, EQ_MAP, EQ_VSS, EQ_AFR, EQ_AFR1, EQ_EGT, EQ_FUELP
+};
+
+// Status fields for LC-1 destinations (AFR banks only)
+static uint8_t SensorData::* lc1StatusField(uint8_t dest) {
+  return dest == ISP2_DEST_AFR  ? &SensorData::afrStat
+       : dest == ISP2_DEST_AFR1 ? &SensorData::afr1Stat
+       : nullptr;
+}
+
+static uint16_t SensorData::* lc1DetailField(uint8_t dest) {
+  return dest == ISP2_DEST_AFR  ? &SensorData::afrDetail
+       : dest == ISP2_DEST_AFR1 ? &SensorData::afr1Detail
+       : nullptr;
+}
+
+static const char* const calNames[ISP2_CAL_COUNT] = {
+  "volts", "coolant", "oilp", "map", "vss", "egt", "fuelp"
+};
+
+static const float* const calTables[ISP2_CAL_COUNT] = {
+  CalLut<AuxVoltsCurve>::table, CalLut<AuxCoolantCurve>::table,
+  CalLut<AuxOilpCurve>::table,  CalLut<AuxMapCurve>::table,
+  CalLut<AuxVssCurve>::table,   CalLut<AuxEgtCurve>::table,
+  CalLut<AuxFuelpCurve>::table
+};
+
+// Natural curve for a destination (used when no curve is given)
+static uint8_t defaultCal(uint8_t dest) {
+  switch (dest) {
+    case ISP2_DEST_COOLANT: return ISP2_CAL_COOLANT;
+    case ISP2_DEST_OILP:    return ISP2_CAL_OILP;
+    case ISP2_DEST_MAP:     return ISP2_CAL_MAP;
+    case ISP2_DEST_VSS:     return ISP2_CAL_VSS;
+    case ISP2_DEST_EGT:     return ISP2_CAL_EGT;
+    case ISP2_DEST_FUELP:   return ISP2_CAL_FUELP;
+    default:                return ISP2_CAL_VOLTS;
+  }
+}
+
+// Chain 0, Nova chain: SSI-4 #1 (coolant, oilp), LC-1 ×2, SSI-4 #2 (MAP, VSS)
+// Chain 1: SSI-4 #3 (EGT, fuel pressure)
+// Further chains start unmapped.
+static void setDefaults(uint8_t chain) {
+  Isp2ChannelMap &m = chains[chain].map;
+  memset(&m, 0, sizeof(m));
+  m.magic = ISP2_MAP_MAGIC;
+  if (chain == 0) {
+    m.auxDest[0] = ISP2_DEST_COOLANT;
+    m.auxDest[1] = ISP2_DEST_OILP;
+    m.auxDest[2] = ISP2_DEST_MAP;
+    m.auxDest[3] = ISP2_DEST_VSS;
+    m.lc1Dest[0] = ISP2_DEST_AFR;
+    m.lc1Dest[1] = ISP2_DEST_AFR1;
+    m.expectAux = 4;
+    m.expectLc1 = 2;
+  } else if (chain == 1) {
+    m.auxDest[0] = ISP2_DEST_EGT;
+    m.auxDest[1] = ISP2_DEST_FUELP;
+    m.expectAux = 4;
+  }
+  for (uint8_t i = 0; i < ISP2_AUX_SLOTS; i++) {
+    m.auxCal[i] = defaultCal(m.auxDest[i]);
+  }
+}
+
+static bool mapValid(const Isp2ChannelMap &m) {
+  if (m.magic != ISP2_MAP_MAGIC) return false;
+  for (uint8_t i = 0; i < ISP2_AUX_SLOTS; i++) {
+    if (m.auxDest[i] >= ISP2_DEST_COUNT || m.auxCal[i] >= ISP2_CAL_COUNT) return false;
+  }
+  for (uint8_t i = 0; i < ISP2_LC1_SLOTS; i++) {
+    if (m.lc1Dest[i] >= ISP2_DEST_COUNT) return false;
+  }
+  return true;
+}
+
+static void buildDispatch(uint8_t chain) {
+  MapState &c = chains[chain];
+  Isp2Dispatch *next = (c.active == &c.dispatch[0]) ? &c.dispatch[1] : &c.dispatch[0];
+  next->channels = 0;
+  for (uint8_t i = 0; i < ISP2_AUX_SLOTS; i++) {
+    next->aux[i].field = destFields[c.map.auxDest[i]];
+    next->aux[i].lut   = calTables[c.map.auxCal[i]];
+    next->channels |= destChecks[c.map.auxDest[i]];
+  }
+  for (uint8_t i = 0; i < ISP2_LC1_SLOTS; i++) {
+    next->lc1[i].field  = destFields[c.map.lc1Dest[i]];
+    next->lc1[i].status = lc1StatusField(c.map.lc1Dest[i]);
+    next->lc1[i].detail = lc1DetailField(c.map.lc1Dest[i]);
+    next->channels |= destChecks[c.map.lc1Dest[i]];
+  }
+  c.active = next;
+}
+
+static void saveMap(uint8_t chain) {
+  prefs.begin("isp2-map", false);
+  prefs.putBytes(mapKeys[chain], &chains[chain].map, sizeof(Isp2ChannelMap));
+  prefs.end();
+}
+
+static int8_t findName(const char* const *names, uint8_t count, const char* s) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (strcmp(names[i], s) == 0) return i;
+  }
+  return -1;
+}
+
+static void printChain(Print &out, uint8_t chain) {
+  const Isp2ChannelMap &m = chains[chain].map;
+  out.printf("--- ISP2 Channel Map, chain %d ---\n", chain);
+  for (uint8_t i = 0; i < ISP2_LC1_SLOTS; i++) {
+    out.printf("  l%d  LC-1 #%d  -> %s\n", i, i + 1, destNames[m.lc1Dest[i]]);
+  }
+  for (uint8_t i = 0; i < ISP2_AUX_SLOTS; i++) {
+    out.printf("  a%d  aux %d    -> %-8s (%s)\n", i, i,
+      destNames[m.auxDest[i]], calNames[m.auxCal[i]]);
+  }
+  out.printf("Expected: %dxLC1 %dxAUX   Detected: %dxLC1 %dxAUX\n",
+    m.expectLc1, m.expectAux, isp2GetLc1Count(chain), isp2GetAuxCount(chain));
+}
+
+//----------------------------------------------------------------
+// Public API
+//----------------------------------------------------------------
+
+void isp2MapInit() {
+  prefs.begin("isp2-map", true);
+  for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+    MapState &c = chains[ch];
+    size_t n = prefs.getBytes(mapKeys[ch], &c.map, sizeof(c.map));
+    if (n == sizeof(c.map) && mapValid(c.map)) {
+      Console.printf("INF: ISP2 chain %d map loaded from NVS\n", ch);
+    } else {
+      setDefaults(ch);
+      Console.printf("INF: ISP2 chain %d map: defaults\n", ch);
+    }
+    c.active = &c.dispatch[0];
+    c.layoutAux = c.layoutLc1 = 0xFF;
+    c.pendingAux = c.pendingLc1 = 0xFF;
+    c.pendingCount = 0;
+    buildDispatch(ch);
+  }
+  prefs.end();
+}
+
+const Isp2Dispatch& isp2MapDispatch(uint8_t chain) {
+  return *chains[chain].active;
+}
+
+void isp2MapCheckLayout(uint8_t chain, uint8_t auxCount, uint8_t lc1Count) {
+  MapState &c = chains[chain];
+  if (auxCount == c.layoutAux && lc1Count == c.layoutLc1) {
+    c.pendingCount = 0;
+    return;
+  }
+  if (auxCount != c.pendingAux || lc1Count != c.pendingLc1) {
+    c.pendingAux = auxCount;
+    c.pendingLc1 = lc1Count;
+    c.pendingCount = 0;
+  }
+  if (++c.pendingCount < ISP2_LAYOUT_CONFIRM) return;
+
+  bool first = c.layoutAux == 0xFF;
+  bool wasExpected = c.layoutAux == c.map.expectAux && c.layoutLc1 == c.map.expectLc1;
+  c.layoutAux = auxCount;
+  c.layoutLc1 = lc1Count;
+  c.pendingCount = 0;
+
+  if (auxCount != c.map.expectAux || lc1Count != c.map.expectLc1) {
+    Console.printf("WRN: ISP2 chain %d is %dxLC1 %dxAUX, map expects %dxLC1 %dxAUX ('M' to review)\n",
+      chain, lc1Count, auxCount, c.map.expectLc1, c.map.expectAux);
+  } else if (!wasExpected && !first) {
+    Console.printf("INF: ISP2 chain %d layout matches map\n", chain);
+  }
+}
+
+void isp2MapPrint(Print &out) {
+  for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+    printChain(out, ch);
+  }
+}
+
+void isp2MapCommand(const char* args) {
+  char first[8] = "", slot[8] = "", dest[10] = "", cal[10] = "";
+  int chain = 0;
+  sscanf(args, "%7s", first);
+  if (first[0] >= '0' && first[0] <= '9') {
+    chain = atoi(first);
+    sscanf(args, "%*s %7s %9s %9s", slot, dest, cal);
+    if (chain >= ISP2_CHAINS) {
+      Console.printf("ERR: no ISP2 chain %d (%d configured)\n", chain, ISP2_CHAINS);
+      return;
+    }
+  } else {
+    sscanf(args, "%7s %9s %9s", slot, dest, cal);
+  }
+  Isp2ChannelMap &m = chains[chain].map;
+
+  if (slot[0] == '\0') {
+    if (first[0]) printChain(Serial, chain);
+    else isp2MapPrint(Console);
+    return;
+  }
+  if (strcmp(slot, "reset") == 0) {
+    setDefaults(chain);
+    buildDispatch(chain);
+    saveMap(chain);
+    Console.printf("INF: ISP2 chain %d map reset to defaults\n", chain);
+    return;
+  }
+  if (strcmp(slot, "learn") == 0) {
+    m.expectAux = isp2GetAuxCount(chain);
+    m.expectLc1 = isp2GetLc1Count(chain);
+    saveMap(chain);
+    Console.printf("INF: ISP2 chain %d map expects %dxLC1 %dxAUX\n",
+      chain, m.expectLc1, m.expectAux);
+    return;
+  }
+
+  int idx = atoi(slot + 1);
+  int8_t d = findName(destNames, ISP2_DEST_COUNT, dest);
+  int8_t c = cal[0] ? findName(calNames, ISP2_CAL_COUNT, cal) : defaultCal(d);
+  bool isAux = slot[0] == 'a' && idx >= 0 && idx < ISP2_AUX_SLOTS;
+  bool isLc1 = slot[0] == 'l' && idx >= 0 && idx < ISP2_LC1_SLOTS;
+  if ((!isAux && !isLc1) || d < 0 || c < 0 || (isLc1 && cal[0])) {
+    Console.println("ERR: usage: M [chain] <a0-a7|l0-l3> <none|coolant|oilp|map|vss|afr|afr1|egt|fuelp> [volts|coolant|oilp|map|vss|egt|fuelp]");
+    return;
+  }
+
+  if (isAux) {
+    m.auxDest[idx] = d;
+    m.auxCal[idx] = c;
+  } else {
+    m.lc1Dest[idx] = d;
+  }
+  buildDispatch(chain);
+  saveMap(chain);
+  printChain(Serial, chain);
+}
@@ -0,0 +1,105 @@
+/**
+ *  Analog Bridge — ISP2 Channel Map
+ *
+ *  Binds each position in an ISP2 daisy-chain (aux word n, LC-1 n) to
+ *  a SensorData field and, for aux words, a calibration curve. One map
+ *  per chain (ISP2_CHAINS), stored in NVS so a rewired chain only needs
+ *  a serial command, not a reflash. Defaults reproduce the chains
+ *  documented in isp2_defs.h.
+ *
+ *  The map is compiled into a flat dispatch table (field pointer + LUT
+ *  pointer per slot) whenever it changes; per-packet decode is one
+ *  table load and one store per word.
+ *
+ *  Serial 'M' commands (line based), optional chain number first
+ *  (default 0):
+ *    M                   show maps and detected layouts
+ *    M a1 oilp [volts]   aux slot 1 → oil pressure (optional curve)
+ *    M l0 afr1           LC-1 slot 0 → AFR bank 2
+ *    M 1 a0 egt          chain 1, aux slot 0 → EGT
+ *    M a4 none           unmap a slot
+ *    M learn             accept the detected chain layout as expected
+ *    M reset             restore defaults
+ */
+#ifndef AB_ISP2_MAP_H
+#define AB_ISP2_MAP_H
+
+#include <Arduino.h>
+#include "sensor_data.h"
+
+#define ISP2_AUX_SLOTS  8
+#define ISP2_LC1_SLOTS  4
+
+// Destination fields
+enum Isp2Dest : uint8_t {
+  ISP2_DEST_NONE,
+  ISP2_DEST_COOLANT,
+  ISP2_DEST_OILP,
+  ISP2_DEST_MAP,
+  ISP2_DEST_VSS,
+  ISP2_DEST_AFR,
+  ISP2_DEST_AFR1,
+  ISP2_DEST_EGT,
+  ISP2_DEST_FUELP,
+  ISP2_DEST_COUNT
+};
+
+// Aux calibration curves (isp2_defs.h)
+enum Isp2Cal : uint8_t {
+  ISP2_CAL_VOLTS,
+  ISP2_CAL_COOLANT,
+  ISP2_CAL_OILP,
+  ISP2_CAL_MAP,
+  ISP2_CAL_VSS,
+  ISP2_CAL_EGT,
+  ISP2_CAL_FUELP,
+  ISP2_CAL_COUNT
+};
+
+// Persisted form
+struct Isp2ChannelMap {
+  uint16_t magic;
+  uint8_t  auxDest[ISP2_AUX_SLOTS];
+  uint8_t  auxCal[ISP2_AUX_SLOTS];
+  uint8_t  lc1Dest[ISP2_LC1_SLOTS];
+  uint8_t  expectAux;        // chain layout the map was written for
+  uint8_t  expectLc1;
+};
+
+// Dispatch form; a null field means the slot is ignored
+struct Isp2AuxSlot {
+  float SensorData::*field;
+  const float *lut;
+};
+
+// LC-1 slots mapped to an AFR bank also carry that bank's status
+struct Isp2Lc1Slot {
+  float    SensorData::*field;
+  uint8_t  SensorData::*status;
+  uint16_t SensorData::*detail;
+};
+
+struct Isp2Dispatch {
+  Isp2AuxSlot aux[ISP2_AUX_SLOTS];
+  Isp2Lc1Slot lc1[ISP2_LC1_SLOTS];
+  uint8_t     channels;      // EQ_* bits this chain writes (engine_validate.h)
+};
+
+// Load every chain's map from NVS (or defaults) and build the dispatch tables.
+void isp2MapInit();
+
+// Current dispatch table for a chain. Safe to call from the ISP2 task
+// while the serial task edits the map (tables are swapped, not edited
+// in place).
+const Isp2Dispatch& isp2MapDispatch(uint8_t chain);
+
+// Report the layout of each decoded packet. Warns once a layout that
+// differs from the map's expected one has been seen a few packets in a row.
+void isp2MapCheckLayout(uint8_t chain, uint8_t auxCount, uint8_t lc1Count);
+
+// Handle the text after a serial 'M' command.
+void isp2MapCommand(const char* args);
+
+void isp2MapPrint(Print &out);
+
+#endif // AB_ISP2_MAP_H
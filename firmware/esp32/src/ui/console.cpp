@@ -0,0 +1,41 @@
+/**
+ *  Analog Bridge — Console Output Implementation
+ */
+#include "console.h"
+#include "passthrough.h"
+
+#include <freertos/semphr.h>
+
+ConsolePrint Console;
+
+// Held across the passthruActive() check and the USB write, so the
+// pass-through cannot start between the two
+static SemaphoreHandle_t consoleMutex = nullptr;
+
+void consoleInit() {
+  consoleMutex = xSemaphoreCreateMutex();
+}
+
+void consoleLock() {
+  if (consoleMutex) xSemaphoreTake(consoleMutex, portMAX_DELAY);
+}
+
+void consoleUnlock() {
+  if (consoleMutex) xSemaphoreGive(consoleMutex);
+}
+
+// Dropped output still reports as written, so callers don't retry
+size_t ConsolePrint::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t ConsolePrint::write(const uint8_t *buf, size_t n) {
+  consoleLock();
+  size_t sent = passthruActive() ? n : Serial.write(buf, n);
+  consoleUnlock();
+  return sent;
+}
+
+void ConsolePrint::flush() {
+  if (!passthruActive()) Serial.flush();
+}
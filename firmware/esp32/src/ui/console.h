@@ -0,0 +1,35 @@
+/**
+ *  Analog Bridge — Console Output
+ *
+ *  Every module prints its INF/WRN/ERR lines and command replies
+ *  through Console instead of Serial. While the ISP2 pass-through is
+ *  active the USB port carries raw ISP2 to LogWorks, and ISP2 payload
+ *  bytes are 7-bit: ASCII landing mid-packet would decode as data. So
+ *  Console drops everything in that state; only the pass-through itself
+ *  writes to Serial directly.
+ */
+#ifndef AB_CONSOLE_H
+#define AB_CONSOLE_H
+
+#include <Arduino.h>
+
+class ConsolePrint : public Print {
+public:
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buf, size_t n) override;
+  void flush() override;
+  using Print::write;
+};
+
+extern ConsolePrint Console;
+
+// Create the output lock. Call from setup() before any task starts;
+// until then Console writes unlocked.
+void consoleInit();
+
+// Hold off Console writes (passthruStart()/stop() around the switch),
+// so a line is never cut by the port changing hands. Blocks.
+void consoleLock();
+void consoleUnlock();
+
+#endif // AB_CONSOLE_H
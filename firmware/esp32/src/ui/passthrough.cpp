@@ -0,0 +1,109 @@
+/**
+ *  Analog Bridge — ISP2 Pass-Through Implementation
+ */
+#include "passthrough.h"
+#include "config.h"
+#include "console.h"
+#include "sensors/isp2.h"
+#include <freertos/stream_buffer.h>
+
+#define PASSTHRU_ESCAPE_LEN  3   // "+++"
+
+static StreamBufferHandle_t ptBuf = nullptr;
+static volatile bool ptActive = false;
+static volatile uint32_t ptDropped = 0;   // chain bytes lost to a full buffer
+
+// Serial task side
+static uint32_t ptToHost = 0;
+static uint32_t ptToChain = 0;
+static unsigned long ptLastHostMs = 0;    // last byte from the host
+static uint8_t ptPlus = 0;                // escape characters held back
+
+static void stop() {
+  consoleLock();
+  ptActive = false;
+  Serial.printf("\nINF: ISP2 pass-through OFF (%lu to host, %lu to chain, %lu dropped)\n",
+    (unsigned long)ptToHost, (unsigned long)ptToChain, (unsigned long)ptDropped);
+  consoleUnlock();
+}
+
+//----------------------------------------------------------------
+// Public API
+//----------------------------------------------------------------
+
+void passthruInit() {
+  ptBuf = xStreamBufferCreate(PASSTHRU_BUF, 1);
+  if (!ptBuf) Serial.println("ERR: Pass-through buffer alloc failed");
+}
+
+void passthruStart() {
+  if (!ptBuf || ptActive) return;
+  // Any Console line already started finishes before the banner; later
+  // ones see ptActive and are dropped
+  consoleLock();
+  Serial.printf("INF: ISP2 pass-through ON — exit with %lus pause, +++, %lus pause\n",
+    (unsigned long)(PASSTHRU_GUARD_MS / 1000), (unsigned long)(PASSTHRU_GUARD_MS / 1000));
+  Serial.flush();
+
+  xStreamBufferReset(ptBuf);
+  ptToHost = 0;
+  ptToChain = 0;
+  ptDropped = 0;
+  ptPlus = 0;
+  ptLastHostMs = millis();
+  ptActive = true;
+  consoleUnlock();
+}
+
+bool passthruActive() {
+  return ptActive;
+}
+
+void passthruRecord(const uint8_t* bytes, size_t n) {
+  if (!ptActive) return;
+  size_t sent = xStreamBufferSend(ptBuf, bytes, n, 0);
+  if (sent < n) ptDropped += n - sent;
+}
+
+void passthruService() {
+  uint8_t buf[PASSTHRU_CHUNK];
+
+  // Chain → host: block briefly for the first bytes, then take the rest
+  size_t n = xStreamBufferReceive(ptBuf, buf, sizeof(buf), pdMS_TO_TICKS(PASSTHRU_POLL_MS));
+  while (n > 0) {
+    ptToHost += Serial.write(buf, n);
+    n = xStreamBufferReceive(ptBuf, buf, sizeof(buf), 0);
+  }
+
+  // Host → chain, holding back what may be an escape sequence
+  unsigned long now = millis();
+  int avail = Serial.available();
+  if (avail > 0) {
+    n = Serial.readBytes(buf, (size_t)avail < sizeof(buf) ? (size_t)avail : sizeof(buf));
+    uint8_t out[PASSTHRU_CHUNK + PASSTHRU_ESCAPE_LEN];
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+      uint8_t b = buf[i];
+      if (b == '+' && ptPlus < PASSTHRU_ESCAPE_LEN &&
+          (ptPlus > 0 || now - ptLastHostMs >= PASSTHRU_GUARD_MS)) {
+        ptPlus++;
+      } else {
+        while (ptPlus > 0) { out[m++] = '+'; ptPlus--; }
+        out[m++] = b;
+      }
+      ptLastHostMs = now;
+    }
+    if (m > 0) ptToChain += isp2GetSerial(0).write(out, m);
+  }
+
+  if (ptPlus > 0 && now - ptLastHostMs >= PASSTHRU_GUARD_MS) {
+    if (ptPlus == PASSTHRU_ESCAPE_LEN) {
+      stop();
+    } else {
+      // Not an escape after all: release the held characters
+      uint8_t plus[PASSTHRU_ESCAPE_LEN] = { '+', '+', '+' };
+      ptToChain += isp2GetSerial(0).write(plus, ptPlus);
+    }
+    ptPlus = 0;
+  }
+}
@@ -0,0 +1,39 @@
+/**
+ *  Analog Bridge — ISP2 Pass-Through
+ *
+ *  Turns the USB serial port into a transparent ISP2 port so LogWorks
+ *  or LM Programmer can talk to the chain while the bridge keeps
+ *  parsing and logging:
+ *    chain → host  every ISP2 UART read on the main chain (0) is teed
+ *                  into a stream buffer by the ISP2 task and written to
+ *                  USB in bulk by the serial task
+ *    host  → chain bytes from USB go out on chain 0's TX pin (LM
+ *                  Programmer commands; needs TX wired to the chain's IN)
+ *
+ *  Serial 'P' starts it. While active the serial task does nothing else:
+ *  no commands, no live debug. Exit with "+++" surrounded by
+ *  PASSTHRU_GUARD_MS of silence (modem style), or a reset. Other tasks'
+ *  INF/WRN lines go through Console (console.h), which is muted while
+ *  pass-through is active: ASCII landing inside a packet would decode
+ *  as ISP2 payload.
+ */
+#ifndef AB_PASSTHROUGH_H
+#define AB_PASSTHROUGH_H
+
+#include <Arduino.h>
+
+// Create the tee buffer. Call once from setup().
+void passthruInit();
+
+void passthruStart();
+bool passthruActive();
+
+// Tee one ISP2 UART read (ISP2 task). Never blocks; bytes that do not
+// fit are dropped and counted.
+void passthruRecord(const uint8_t* bytes, size_t n);
+
+// Move data both ways and watch for the escape (serial task). Waits up
+// to PASSTHRU_POLL_MS for chain data.
+void passthruService();
+
+#endif // AB_PASSTHROUGH_H
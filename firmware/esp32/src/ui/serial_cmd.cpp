@@ -12,9 +12,16 @@
 #include "config.h"
 #include "sensors/imu.h"
 #include "sensors/isp2.h"
+#include "sensors/isp2_map.h"
+#include "isp2_defs.h"
 #include "sensors/gps.h"
 #include "logging/sd_logger.h"
+#include "logging/raw_capture.h"
+#include "ui/passthrough.h"
+#include "ui/console.h"
 #include "web/web_server.h"
+#include "diag/task_timing.h"
+#include "diag/trace.h"
 #include <Arduino.h>
 #include <WiFi.h>
 
@@ -69,7 +76,7 @@ static void printLiveDebug(const SensorData &data, float now, bool isRecording)
   if (millis() - lastLiveDebug < 500) return;
   lastLiveDebug = millis();
 
-  Serial.printf("%.1fs %s  %5.1fmph %dsat%s  AFR %4.1f/%4.1f  %5.1fmph %5.1f\"Hg  OIL%3.0f CLT%4.0f  G %5.2f\n",
+  Console.printf("%.1fs %s  %5.1fmph %dsat%s  AFR %4.1f/%4.1f  %5.1fmph %5.1f\"Hg  OIL%3.0f CLT%4.0f  G %5.2f\n",
     now,
     isRecording ? "[REC]" : "     ",
     data.speed, data.satellites, data.gpsStale ? "!" : " ",
@@ -92,27 +99,29 @@ void serialCmdInit(CmdStartCallback onStart,
 }
 
 void serialCmdPrintStatus(const SensorData &data, bool isRecording) {
-  Serial.println("--- Analog Bridge v" FW_VERSION " (ESP32-S3) ---");
-  Serial.print("Uptime:    "); printHMS(Serial, millis()); Serial.println();
+  Console.println("--- Analog Bridge v" FW_VERSION " (ESP32-S3) ---");
+  Console.print("Uptime:    "); printHMS(Serial, millis()); Console.println();
   if (isRecording) {
-    Serial.print("Recording: YES — ");
-    Serial.printf("%s, %lu rows\n", sdGetFilename(), sdGetRowCount());
+    Console.print("Recording: YES — ");
+    Console.printf("%s, %lu rows\n", sdGetFilename(), sdGetRowCount());
   } else {
-    Serial.println("Recording: NO");
+    Console.println("Recording: NO");
   }
-  Serial.printf("GPS:       %s  sats=%d  115200/5Hz\n",
+  Console.printf("GPS:       %s  sats=%d  115200/5Hz\n",
     data.gpsStale ? "STALE" : "OK", data.satellites);
-  Serial.printf("IMU:       %s  cal=%s\n",
+  Console.printf("IMU:       %s  cal=%s\n",
     imuIsReady() ? "OK" : "FAIL",
     imuGetCalibration().magic == CAL_MAGIC ? "YES" : "NO");
-  Serial.printf("ISP2:      %d LC1, %d aux\n",
-    isp2GetLc1Count(), isp2GetAuxCount());
-  Serial.printf("WiFi:      %s  %d clients  IP %s\n",
+  for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+    Console.printf("ISP2 #%d:   %d LC1, %d aux\n",
+      ch, isp2GetLc1Count(ch), isp2GetAuxCount(ch));
+  }
+  Console.printf("WiFi:      %s  %d clients  IP %s\n",
     WiFi.getMode() == WIFI_AP ? "AP" : "STA",
     WiFi.softAPgetStationNum(),
     WiFi.softAPIP().toString().c_str());
-  Serial.printf("Debug:     %s\n", liveDebug ? "ON" : "OFF");
-  Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
+  Console.printf("Debug:     %s\n", liveDebug ? "ON" : "OFF");
+  Console.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
 }
 
 void serialCmdProcess(const SensorData &data, bool isRecording) {
@@ -126,26 +135,36 @@ void serialCmdProcess(const SensorData &data, bool isRecording) {
     char c = Serial.read();
     switch (c) {
       case '?':
-        Serial.println("--- Analog Bridge Commands ---");
-        Serial.println(" Recording:");
-        Serial.println("  r  Start recording to SD card");
-        Serial.println("  s  Stop recording (prints session summary)");
-        Serial.println("  k  Insert keyframe marker into log");
-        Serial.println(" Display:");
-        Serial.println("  d  Toggle live debug stream (2Hz)");
-        Serial.println("  p  Sensor snapshot (all values once)");
-        Serial.println("  v  System status (uptime, GPS, IMU, ISP2, WiFi)");
-        Serial.println("  i  ISP2 diagnostics (AFR, VSS, MAP, OIL, CLT)");
-        Serial.println(" IMU Calibration:");
-        Serial.println("  c  Accel — place level & still, ~2.5s, saves NVS");
-        Serial.println("  m  Mag   — tumble all axes 15s, saves NVS");
-        Serial.println("  C  Show current gyro/accel/mag cal values");
-        Serial.println("  E  Erase NVS cal (revert to defaults)");
-        Serial.println(" GPS:");
-        Serial.println("  g  Reconfigure GPS (115200 baud + 5Hz)");
-        Serial.println(" WiFi:");
-        Serial.println("  w  WiFi status (IP, clients, signal)");
-        Serial.println("  ?  This help");
+        Console.println("--- Analog Bridge Commands ---");
+        Console.println(" Recording:");
+        Console.println("  r  Start recording to SD card");
+        Console.println("  s  Stop recording (prints session summary)");
+        Console.println("  k  Insert keyframe marker into log");
+        Console.println("  b  Toggle binary log (.bin, next recording)");
+        Console.println("  R  Toggle raw ISP2 capture (.isp, next recording)");
+        Console.println(" Display:");
+        Console.println("  d  Toggle live debug stream (2Hz)");
+        Console.println("  p  Sensor snapshot (all values once)");
+        Console.println("  v  System status (uptime, GPS, IMU, ISP2, WiFi)");
+        Console.println("  i  ISP2 diagnostics (channels + link statistics)");
+        Console.println("  M  ISP2 channel maps (M a1 oilp | M l0 afr | M 1 a0 egt | M learn | M reset)");
+        Console.println("  P  ISP2 pass-through for LogWorks/LM Programmer (+++ exits)");
+        Console.println("  t  Task timing (exec, jitter, deadline misses)");
+#ifdef TRACE_ENABLE
+        Console.println("  T  Arm event trace capture");
+        Console.println("  J  Dump event trace (Chrome Trace JSON)");
+#endif
+        Console.println(" IMU Calibration:");
+        Console.println("  c  Accel — place level & still, ~2.5s, saves NVS");
+        Console.println("  m  Mag   — tumble all axes 15s, saves NVS");
+        Console.println("  z  Gyro  — forget learned bias model, relearn at next stop");
+        Console.println("  C  Show current gyro/accel/mag cal values");
+        Console.println("  E  Erase NVS cal (revert to defaults)");
+        Console.println(" GPS:");
+        Console.println("  g  Reconfigure GPS (115200 baud + 5Hz)");
+        Console.println(" WiFi:");
+        Console.println("  w  WiFi status (IP, clients, signal)");
+        Console.println("  ?  This help");
         break;
       case 'r':
         if (cbStart) cbStart();
@@ -157,27 +176,28 @@ void serialCmdProcess(const SensorData &data, bool isRecording) {
         if (isRecording) {
           if (cbKeyframe) cbKeyframe();
         } else {
-          Serial.println("WRN: Not recording — keyframe ignored");
+          Console.println("WRN: Not recording — keyframe ignored");
         }
         break;
       case 'd':
         liveDebug = !liveDebug;
-        Serial.printf("INF: Live debug %s\n", liveDebug ? "ON" : "OFF");
+        Console.printf("INF: Live debug %s\n", liveDebug ? "ON" : "OFF");
         break;
       case 'p':
-        Serial.println("--- Sensor Snapshot ---");
-        Serial.print("GPS: ");
-        printDegE7(Serial, data.lat); Serial.print(", ");
+        Console.println("--- Sensor Snapshot ---");
+        Console.print("GPS: ");
+        printDegE7(Serial, data.lat); Console.print(", ");
         printDegE7(Serial, data.lon);
-        Serial.printf("  %.1f mph  sats=%d%s\n",
+        Console.printf("  %.1f mph  sats=%d%s\n",
           data.speed, data.satellites, data.gpsStale ? " [STALE]" : "");
-        Serial.printf("IMU: acc=%.2f,%.2f,%.2f  gyro=%.1f,%.1f,%.1f  temp=%.1fC\n",
+        Console.printf("IMU: acc=%.2f,%.2f,%.2f  gyro=%.1f,%.1f,%.1f  temp=%.1fC\n",
           data.accx, data.accy, data.accz,
           data.rotx, data.roty, data.rotz, data.imuTemp);
-        Serial.printf("MAG: %.1f,%.1f,%.1f uT\n",
+        Console.printf("MAG: %.1f,%.1f,%.1f uT\n",
           data.magx, data.magy, data.magz);
-        Serial.printf("ENG: AFR=%.1f/%.1f  VSS=%.1fmph  MAP=%.1f  OIL=%.0f  CLT=%.0f\n",
-          data.afr, data.afr1, data.vss, data.map, data.oilp, data.coolant);
+        Console.printf("ENG: AFR=%.1f/%.1f  VSS=%.1fmph  MAP=%.1f  OIL=%.0f  CLT=%.0f  EGT=%.0f  FUEL=%.1f\n",
+          data.afr, data.afr1, data.vss, data.map, data.oilp, data.coolant,
+          data.egt, data.fuelp);
         break;
       case 'v':
         serialCmdPrintStatus(data, isRecording);
@@ -186,43 +206,85 @@ void serialCmdProcess(const SensorData &data, bool isRecording) {
         gpsReconfigure();
         break;
       case 'i':
-        Serial.printf("ISP2 state: %d\n", isp2GetState());
-        Serial.printf("LC1 devices: %d\n", isp2GetLc1Count());
-        Serial.printf("Aux channels: %d\n", isp2GetAuxCount());
-        Serial.printf("AFR: %.1f  AFR1: %.1f\n", data.afr, data.afr1);
-        Serial.printf("VSS: %.1fmph  MAP: %.1f  OIL: %.0f  CLT: %.0f\n",
-          data.vss, data.map, data.oilp, data.coolant);
+        for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+          Console.printf("Chain %d: state %d  LC1 devices: %d  Aux channels: %d  last packet %lu ms ago\n",
+            ch, isp2GetState(ch), isp2GetLc1Count(ch), isp2GetAuxCount(ch),
+            (unsigned long)((micros() - data.isp2Us[ch]) / 1000));
+        }
+        Console.printf("AFR: %.1f (%s %u)  AFR1: %.1f (%s %u)\n",
+          data.afr, lc1StatusName(data.afrStat), data.afrDetail,
+          data.afr1, lc1StatusName(data.afr1Stat), data.afr1Detail);
+        Console.printf("VSS: %.1fmph  MAP: %.1f  OIL: %.0f  CLT: %.0f  EGT: %.0f  FUEL: %.1f\n",
+          data.vss, data.map, data.oilp, data.coolant, data.egt, data.fuelp);
+        isp2PrintStats(Console);
+        rawCapturePrint(Console);
+        break;
+      case 'b':
+        sdSetBinary(!sdBinary());
+        Console.printf("INF: Log format %s%s\n", sdBinary() ? "binary (.bin)" : "CSV",
+          isRecording ? " (from next recording)" : "");
+        break;
+      case 'R':
+        rawCaptureSetEnabled(!rawCaptureEnabled());
+        Console.printf("INF: Raw ISP2 capture %s%s\n", rawCaptureEnabled() ? "ON" : "OFF",
+          isRecording ? " (from next recording)" : "");
+        break;
+      case 'M': {
+        String args = Serial.readStringUntil('\n');
+        args.trim();
+        isp2MapCommand(args.c_str());
+        break;
+      }
+      case 'P':
+        passthruStart();
+        return;  // rest of the input belongs to the pass-through
+      case 't':
+        taskTimingPrint(Console);
+        break;
+#ifdef TRACE_ENABLE
+      case 'T':
+        traceStart();
         break;
+      case 'J':
+        traceWriteJson(Console);
+        break;
+#endif
       case 'c':
-        if (isRecording) {
-          Serial.println("WRN: Stop recording before calibrating");
-        } else if (!imuIsReady()) {
-          Serial.println("ERR: IMU not available");
-        } else {
-          imuCalibrateAccel();
+        if (!imuIsReady()) {
+          Console.println("ERR: IMU not available");
+        } else if (!imuStartAccelCal()) {
+          Console.println("WRN: IMU calibration already running");
         }
         break;
       case 'm':
-        if (isRecording) {
-          Serial.println("WRN: Stop recording before calibrating");
-        } else if (!imuIsReady()) {
-          Serial.println("ERR: IMU not available");
+        if (!imuIsReady()) {
+          Console.println("ERR: IMU not available");
+        } else if (!imuStartMagCal()) {
+          Console.println("WRN: IMU calibration already running");
+        }
+        break;
+      case 'z':
+        if (!imuIsReady()) {
+          Console.println("ERR: IMU not available");
         } else {
-          imuCalibrateMag();
+          imuResetGyroModel();
+          Console.println("INF: Gyro model reset — relearning at the next stop");
         }
         break;
       case 'C':
         imuPrintCalibration();
         break;
       case 'E':
-        imuEraseCalibration();
+        if (!imuEraseCalibration()) {
+          Console.println("WRN: IMU calibration running, not erased");
+        }
         break;
       case 'w':
-        Serial.printf("WiFi mode:    %s\n", WiFi.getMode() == WIFI_AP ? "AP" : "STA");
-        Serial.printf("SSID:         %s\n", WiFi.softAPSSID().c_str());
-        Serial.printf("IP:           %s\n", WiFi.softAPIP().toString().c_str());
-        Serial.printf("Clients:      %d\n", WiFi.softAPgetStationNum());
-        Serial.printf("WS clients:   %d\n", webGetClientCount());
+        Console.printf("WiFi mode:    %s\n", WiFi.getMode() == WIFI_AP ? "AP" : "STA");
+        Console.printf("SSID:         %s\n", WiFi.softAPSSID().c_str());
+        Console.printf("IP:           %s\n", WiFi.softAPIP().toString().c_str());
+        Console.printf("Clients:      %d\n", WiFi.softAPgetStationNum());
+        Console.printf("WS clients:   %d\n", webGetClientCount());
         break;
     }
   }
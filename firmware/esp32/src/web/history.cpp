@@ -0,0 +1,169 @@
+/**
+ *  Analog Bridge — Telemetry History Ring Implementation
+ *
+ *  Written by taskWebSocket (core 0) at 5Hz, read by the async TCP task
+ *  when a client connects. The spinlock covers only the writer's update
+ *  and the reader's snapshot of head/used; the ~6 KB copy runs outside
+ *  it. Filled blocks don't change until the ring wraps onto them, and the
+ *  head block only appends, so the copy is consistent unless a new block
+ *  started meanwhile (every HISTORY_BLOCK_FRAMES pushes, ~5 s): then the
+ *  reader copies again.
+ *
+ *  Deltas saturate at ±127 quantization steps. The encoder tracks the
+ *  reconstructed value, so a jump larger than that (e.g. AFR dropping
+ *  to 0 on a sensor fault) is spread over a few frames instead of
+ *  drifting permanently. Each block restarts from an exact keyframe.
+ */
+#include "history.h"
+#include "config.h"
+#include <Arduino.h>
+
+#define HISTORY_BLOCKS  ((HISTORY_SECONDS * 1000UL / WS_BROADCAST_MS) / HISTORY_BLOCK_FRAMES + 1)
+#define HISTORY_VERSION 1
+
+struct HistoryBlock {
+  uint32_t startMs;
+  uint8_t  frames;                                      // 0 = unused
+  int16_t  key[HIST_CHANNEL_COUNT];
+  int8_t   delta[HISTORY_BLOCK_FRAMES - 1][HIST_CHANNEL_COUNT];
+};
+
+// Quantization per channel (value × scale → int16)
+static const uint16_t histScale[HIST_CHANNEL_COUNT] = {
+  100,  // ax    0.01 g (linx: G-G plot, gravity removed)
+  100,  // ay    0.01 g (liny)
+  10,   // afr   0.1
+  10,   // afr1  0.1
+  10,   // spd   0.1 mph
+  10,   // vss   0.1 mph
+  10,   // map   0.1 inHg
+  10,   // oil   0.1 psi
+  10,   // clt   0.1 °F
+};
+
+static HistoryBlock blocks[HISTORY_BLOCKS];
+static uint16_t head = 0;          // block currently being filled
+static uint16_t used = 0;          // blocks holding data (incl. head)
+static int16_t  recon[HIST_CHANNEL_COUNT];  // decoder-side value of last frame
+static uint32_t started = 0;       // blocks begun since boot (reader's wrap check)
+static portMUX_TYPE histMux = portMUX_INITIALIZER_UNLOCKED;
+
+static int16_t quantize(float v, uint16_t scale) {
+  float q = v * (float)scale;
+  if (q >  32767.0f) return  32767;
+  if (q < -32768.0f) return -32768;
+  return (int16_t)lroundf(q);
+}
+
+static uint8_t* put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF; p[1] = v >> 8;
+  return p + 2;
+}
+
+static uint8_t* put32(uint8_t *p, uint32_t v) {
+  p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = v >> 24;
+  return p + 4;
+}
+
+//----------------------------------------------------------------
+// Public API
+//----------------------------------------------------------------
+
+void historyPush(const SensorData &data, unsigned long nowMs) {
+  int16_t q[HIST_CHANNEL_COUNT];
+  q[HIST_AX]   = quantize(data.linx,    histScale[HIST_AX]);
+  q[HIST_AY]   = quantize(data.liny,    histScale[HIST_AY]);
+  q[HIST_AFR]  = quantize(data.afr,     histScale[HIST_AFR]);
+  q[HIST_AFR1] = quantize(data.afr1,    histScale[HIST_AFR1]);
+  q[HIST_SPD]  = quantize(data.speed,   histScale[HIST_SPD]);
+  q[HIST_VSS]  = quantize(data.vss,     histScale[HIST_VSS]);
+  q[HIST_MAP]  = quantize(data.map,     histScale[HIST_MAP]);
+  q[HIST_OIL]  = quantize(data.oilp,    histScale[HIST_OIL]);
+  q[HIST_CLT]  = quantize(data.coolant, histScale[HIST_CLT]);
+
+  portENTER_CRITICAL(&histMux);
+  HistoryBlock *b = &blocks[head];
+  if (used == 0 || b->frames >= HISTORY_BLOCK_FRAMES) {
+    // Start a new block with an exact keyframe, dropping the oldest
+    if (used > 0) head = (head + 1) % HISTORY_BLOCKS;
+    if (used < HISTORY_BLOCKS) used++;
+    started++;
+    b = &blocks[head];
+    b->startMs = nowMs;
+    b->frames = 1;
+    for (uint8_t c = 0; c < HIST_CHANNEL_COUNT; c++) {
+      b->key[c] = recon[c] = q[c];
+    }
+  } else {
+    int8_t *d = b->delta[b->frames - 1];
+    for (uint8_t c = 0; c < HIST_CHANNEL_COUNT; c++) {
+      int32_t diff = (int32_t)q[c] - recon[c];
+      if (diff >  127) diff =  127;
+      if (diff < -127) diff = -127;
+      d[c] = (int8_t)diff;
+      recon[c] += diff;
+    }
+    b->frames++;
+  }
+  portEXIT_CRITICAL(&histMux);
+}
+
+size_t historyMaxSize() {
+  return 12 + 2 * HIST_CHANNEL_COUNT +
+         HISTORY_BLOCKS * (5 + 2 * HIST_CHANNEL_COUNT +
+                           (HISTORY_BLOCK_FRAMES - 1) * HIST_CHANNEL_COUNT);
+}
+
+size_t historySerialize(uint8_t *buf, size_t len, unsigned long nowMs) {
+  if (len < historyMaxSize()) return 0;
+
+  uint8_t *p = buf;
+  *p++ = 'H';
+  *p++ = HISTORY_VERSION;
+  *p++ = HIST_CHANNEL_COUNT;
+  *p++ = HISTORY_BLOCK_FRAMES;
+  p = put16(p, WS_BROADCAST_MS);
+  uint8_t *countAt = p;
+  p = put16(p, 0);                 // block count, patched below
+  p = put32(p, nowMs);
+  for (uint8_t c = 0; c < HIST_CHANNEL_COUNT; c++) {
+    p = put16(p, histScale[c]);
+  }
+
+  uint8_t *blocksAt = p;
+  uint16_t n = 0;
+  for (uint8_t attempt = 0; attempt < 3; attempt++) {
+    portENTER_CRITICAL(&histMux);
+    n = used;
+    uint16_t last = head;
+    uint8_t lastFrames = blocks[head].frames;
+    uint32_t gen = started;
+    portEXIT_CRITICAL(&histMux);
+
+    p = blocksAt;
+    uint16_t idx = (last + HISTORY_BLOCKS - (n ? n - 1 : 0)) % HISTORY_BLOCKS;
+    for (uint16_t i = 0; i < n; i++) {
+      const HistoryBlock &b = blocks[idx];
+      uint8_t frames = idx == last ? lastFrames : b.frames;
+      p = put32(p, b.startMs);
+      *p++ = frames;
+      for (uint8_t c = 0; c < HIST_CHANNEL_COUNT; c++) {
+        p = put16(p, (uint16_t)b.key[c]);
+      }
+      size_t deltaBytes = (size_t)(frames - 1) * HIST_CHANNEL_COUNT;
+      memcpy(p, b.delta, deltaBytes);
+      p += deltaBytes;
+      idx = (idx + 1) % HISTORY_BLOCKS;
+    }
+
+    portENTER_CRITICAL(&histMux);
+    bool moved = started != gen;
+    portEXIT_CRITICAL(&histMux);
+    if (!moved) break;
+    n = 0;  // a block was recycled under the copy
+  }
+
+  if (n == 0) return 0;
+  put16(countAt, n);
+  return p - buf;
+}
@@ -0,0 +1,44 @@
+/**
+ *  Analog Bridge — Telemetry History Ring
+ *
+ *  Keeps the last HISTORY_SECONDS of dashboard telemetry in RAM so a
+ *  WebSocket client that joins mid-session starts with a full G-force
+ *  trail instead of a single point.
+ *
+ *  Samples are quantized to int16 and stored in fixed-size blocks:
+ *  one absolute keyframe followed by int8 deltas. ~6 KB for 120 s,
+ *  versus ~60 KB for the same span of raw SensorData.
+ *
+ *  Binary snapshot layout (little-endian, one WebSocket binary frame):
+ *    u8  'H', u8 version, u8 channels, u8 blockFrames,
+ *    u16 periodMs, u16 blockCount, u32 nowMs,
+ *    u16 scale[channels],
+ *    per block (oldest first):
+ *      u32 startMs, u8 frames, i16 key[channels],
+ *      i8  delta[(frames - 1) * channels]
+ */
+#ifndef AB_HISTORY_H
+#define AB_HISTORY_H
+
+#include "sensor_data.h"
+#include <stddef.h>
+
+// Channel order in every frame — must match HIST_CHANNELS in main.js
+enum HistoryChannel {
+  HIST_AX, HIST_AY, HIST_AFR, HIST_AFR1, HIST_SPD,
+  HIST_VSS, HIST_MAP, HIST_OIL, HIST_CLT,
+  HIST_CHANNEL_COUNT
+};
+
+// Append one sample. Call at WS_BROADCAST_MS from a single task.
+void historyPush(const SensorData &data, unsigned long nowMs);
+
+// Worst-case size of historySerialize() output.
+size_t historyMaxSize();
+
+// Copy the ring into buf (binary layout above). Safe to call from
+// the async TCP task while historyPush() runs on another core.
+// Returns bytes written, or 0 if buf is too small or ring is empty.
+size_t historySerialize(uint8_t *buf, size_t len, unsigned long nowMs);
+
+#endif // AB_HISTORY_H
@@ -3,13 +3,28 @@
  *
  *  WiFi AP mode by default. ESPAsyncWebServer serves:
  *    GET /     → gzipped dashboard HTML (from web_data.h)
- *    WS  /ws   → real-time sensor JSON at 5Hz
+ *    GET /api/status  → health check JSON + ISP2 link statistics
+ *    GET /api/metrics → Prometheus text (see diag/metrics.h)
+ *    GET /api/trace   → Chrome trace JSON (TRACE_ENABLE builds, diag/trace.h)
+ *    WS  /ws   → real-time sensor JSON at 5Hz, preceded by one binary
+ *                history frame (see history.h) on connect;
+ *                accepts remote commands (see web_server.h)
+ *
+ *  Remote commands are parsed in the async TCP callback but only queued
+ *  there. webProcessCommand() runs them from its own task, so the
+ *  recording callbacks never execute inside the network stack.
  */
 #include "web_server.h"
+#include "history.h"
 #include "config.h"
+#include "diag/metrics.h"
+#include "diag/trace.h"
+#include "sensors/isp2.h"
+#include "ui/console.h"
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include <ESPmDNS.h>
+#include <ctype.h>
 
 // Generated by web-ui build pipeline (gzip → C array)
 // Placeholder until the real UI is built
@@ -18,6 +33,165 @@
 static AsyncWebServer server(80);
 static AsyncWebSocket ws("/ws");
 
+static WebStartCallback    cbStart    = nullptr;
+static WebStopCallback     cbStop     = nullptr;
+static WebKeyframeCallback cbKeyframe = nullptr;
+static WebRecordingQuery   cbIsRecording = nullptr;
+
+// Remote command marshalled from the async TCP task to webProcessCommand()
+struct WebCommand {
+  uint32_t clientId;
+  uint32_t reqId;
+  char     cmd;
+};
+static QueueHandle_t cmdQueue = NULL;
+
+// Connected clients and the frames each one has missed because its send
+// queue was full. Written from the async TCP task (connect/disconnect)
+// and the WS task (broadcast), read by the metrics scrape.
+struct WsClientSlot {
+  uint32_t id;        // 0 = free
+  uint32_t dropped;
+};
+static WsClientSlot wsSlots[WS_MAX_CLIENTS];
+static portMUX_TYPE wsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Returns false if all WS_MAX_CLIENTS slots are taken
+static bool slotOpen(uint32_t id) {
+  bool ok = false;
+  portENTER_CRITICAL(&wsMux);
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (wsSlots[i].id == 0) {
+      wsSlots[i].id = id;
+      wsSlots[i].dropped = 0;
+      ok = true;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&wsMux);
+  return ok;
+}
+
+// Frees the slot; returns the client's dropped frame count
+static uint32_t slotClose(uint32_t id) {
+  uint32_t dropped = 0;
+  portENTER_CRITICAL(&wsMux);
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (wsSlots[i].id == id) {
+      dropped = wsSlots[i].dropped;
+      wsSlots[i].id = 0;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&wsMux);
+  return dropped;
+}
+
+//----------------------------------------------------------------
+// Send a command ack to one client
+//----------------------------------------------------------------
+static void sendAck(uint32_t clientId, uint32_t reqId, char cmd,
+                    bool ok, const char* err) {
+  char json[96];
+  if (ok) {
+    snprintf(json, sizeof(json),
+      "{\"ack\":%lu,\"cmd\":\"%c\",\"ok\":true,\"rec\":%s}",
+      (unsigned long)reqId, cmd,
+      (cbIsRecording && cbIsRecording()) ? "true" : "false");
+  } else {
+    snprintf(json, sizeof(json),
+      "{\"ack\":%lu,\"cmd\":\"%c\",\"ok\":false,\"err\":\"%s\"}",
+      (unsigned long)reqId, cmd, err);
+  }
+  ws.text(clientId, json);
+}
+
+//----------------------------------------------------------------
+// Value of "key" in a flat JSON object: the first non-blank after the
+// colon, or NULL if the key (or its colon) is missing.
+//----------------------------------------------------------------
+static const char* jsonValue(const char* msg, const char* key) {
+  const char* p = strstr(msg, key);
+  if (!p) return NULL;
+  p += strlen(key);
+  while (isspace((unsigned char)*p)) p++;
+  if (*p++ != ':') return NULL;
+  while (isspace((unsigned char)*p)) p++;
+  return p;
+}
+
+//----------------------------------------------------------------
+// Parse {"id":N,"cmd":"x"} or a bare "x". Returns false if malformed;
+// reqId is still filled in when the id could be read, for the error ack.
+//----------------------------------------------------------------
+static bool parseCommand(const char* msg, WebCommand &out) {
+  out.reqId = 0;
+  out.cmd = '?';
+  while (isspace((unsigned char)*msg)) msg++;
+  if (msg[0] != '{') {
+    if (msg[0] == '\0' || msg[1] != '\0' || msg[0] == '"' || msg[0] == '\\') return false;
+    out.cmd = msg[0];
+    return true;
+  }
+  const char* id  = jsonValue(msg, "\"id\"");
+  const char* cmd = jsonValue(msg, "\"cmd\"");
+  if (id) out.reqId = strtoul(id, NULL, 10);
+  if (!cmd || cmd[0] != '"' || cmd[1] == '\0' || cmd[1] == '"' ||
+      cmd[1] == '\\' || cmd[2] != '"') {
+    return false;
+  }
+  out.cmd = cmd[1];
+  return true;
+}
+
+static void onWsData(AsyncWebSocketClient *client, void *arg,
+                     uint8_t *data, size_t len) {
+  AwsFrameInfo *info = (AwsFrameInfo*)arg;
+  // Commands are tiny — accept only single, complete text frames, and
+  // answer anything else once (on its last fragment) so the client
+  // doesn't wait out its timeout
+  if (!info->final || info->index != 0 || info->len != len ||
+      info->opcode != WS_TEXT || len >= 64) {
+    if (info->final && info->index + len >= info->len) {
+      Console.printf("WRN: Bad WebSocket frame from #%u\n", client->id());
+      sendAck(client->id(), 0, '?', false, "bad frame");
+    }
+    return;
+  }
+  char msg[64];
+  memcpy(msg, data, len);
+  msg[len] = '\0';
+
+  WebCommand c;
+  c.clientId = client->id();
+  if (!parseCommand(msg, c)) {
+    Console.printf("WRN: Bad WebSocket command from #%u\n", client->id());
+    sendAck(c.clientId, c.reqId, '?', false, "bad command");
+    return;
+  }
+  if (!cmdQueue || xQueueSend(cmdQueue, &c, 0) != pdTRUE) {
+    sendAck(c.clientId, c.reqId, c.cmd, false, "busy");
+  }
+}
+
+//----------------------------------------------------------------
+// Send the history ring as one binary frame so a new client can
+// draw its G-force trail before the first live JSON frame arrives.
+//----------------------------------------------------------------
+static void sendHistory(AsyncWebSocketClient *client) {
+  size_t cap = historyMaxSize();
+  uint8_t *buf = (uint8_t*)malloc(cap);
+  if (!buf) {
+    Console.println("WRN: History backfill skipped (no heap)");
+    return;
+  }
+  size_t len = historySerialize(buf, cap, millis());
+  if (len > 0) {
+    client->binary(buf, len);  // copied into the client's send queue
+  }
+  free(buf);
+}
+
 //----------------------------------------------------------------
 // WebSocket event handler
 //----------------------------------------------------------------
@@ -25,17 +199,27 @@ static void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
                       AwsEventType type, void *arg, uint8_t *data, size_t len) {
   switch (type) {
     case WS_EVT_CONNECT:
-      Serial.printf("INF: WebSocket client #%u connected from %s\n",
+      Console.printf("INF: WebSocket client #%u connected from %s\n",
         client->id(), client->remoteIP().toString().c_str());
+      if (!slotOpen(client->id())) {
+        Console.printf("WRN: WebSocket client #%u refused (%d connected)\n",
+          client->id(), WS_MAX_CLIENTS);
+        client->close();
+        break;
+      }
+      sendHistory(client);
       break;
-    case WS_EVT_DISCONNECT:
-      Serial.printf("INF: WebSocket client #%u disconnected\n", client->id());
+    case WS_EVT_DISCONNECT: {
+      uint32_t dropped = slotClose(client->id());
+      Console.printf("INF: WebSocket client #%u disconnected (%lu frames dropped)\n",
+        client->id(), (unsigned long)dropped);
       break;
+    }
     case WS_EVT_ERROR:
-      Serial.printf("WRN: WebSocket error on client #%u\n", client->id());
+      Console.printf("WRN: WebSocket error on client #%u\n", client->id());
       break;
     case WS_EVT_DATA:
-      // Client-to-server messages (future: remote commands)
+      onWsData(client, arg, data, len);
       break;
     default:
       break;
@@ -46,7 +230,51 @@ static void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
 // Public API
 //----------------------------------------------------------------
 
+void webCmdInit(WebStartCallback onStart,
+                WebStopCallback onStop,
+                WebKeyframeCallback onKeyframe,
+                WebRecordingQuery isRecording) {
+  cbStart       = onStart;
+  cbStop        = onStop;
+  cbKeyframe    = onKeyframe;
+  cbIsRecording = isRecording;
+}
+
+bool webProcessCommand(TickType_t wait) {
+  WebCommand c;
+  if (!cmdQueue || xQueueReceive(cmdQueue, &c, wait) != pdTRUE) return false;
+
+  bool recording = cbIsRecording && cbIsRecording();
+  switch (c.cmd) {
+    case 'r':
+      if (recording) { sendAck(c.clientId, c.reqId, c.cmd, false, "already recording"); break; }
+      if (cbStart) cbStart();
+      if (cbIsRecording && !cbIsRecording()) {
+        sendAck(c.clientId, c.reqId, c.cmd, false, "SD open failed");
+      } else {
+        sendAck(c.clientId, c.reqId, c.cmd, true, NULL);
+      }
+      break;
+    case 's':
+      if (!recording) { sendAck(c.clientId, c.reqId, c.cmd, false, "not recording"); break; }
+      if (cbStop) cbStop();
+      sendAck(c.clientId, c.reqId, c.cmd, true, NULL);
+      break;
+    case 'k':
+      if (!recording) { sendAck(c.clientId, c.reqId, c.cmd, false, "not recording"); break; }
+      if (cbKeyframe) cbKeyframe();
+      sendAck(c.clientId, c.reqId, c.cmd, true, NULL);
+      break;
+    default:
+      sendAck(c.clientId, c.reqId, c.cmd, false, "unsupported");
+      break;
+  }
+  return true;
+}
+
 void webInit() {
+  cmdQueue = xQueueCreate(WS_CMD_QUEUE_LEN, sizeof(WebCommand));
+
   // Build SSID with last 4 hex of MAC for uniqueness
   uint8_t mac[6];
   WiFi.macAddress(mac);
@@ -59,12 +287,12 @@ void webInit() {
   WiFi.softAP(ssid, WIFI_AP_PASSWORD, WIFI_AP_CHANNEL, 0, WIFI_AP_MAX_CLIENTS);
   delay(100);  // Let AP stabilize
 
-  Serial.printf("INF: WiFi AP started — SSID: %s\n", ssid);
-  Serial.printf("INF: Dashboard: http://%s/\n", WiFi.softAPIP().toString().c_str());
+  Console.printf("INF: WiFi AP started — SSID: %s\n", ssid);
+  Console.printf("INF: Dashboard: http://%s/\n", WiFi.softAPIP().toString().c_str());
 
   // mDNS — access via http://analogbridge.local/
   if (MDNS.begin("analogbridge")) {
-    Serial.println("INF: mDNS: http://analogbridge.local/");
+    Console.println("INF: mDNS: http://analogbridge.local/");
     MDNS.addService("http", "tcp", 80);
   }
 
@@ -78,53 +306,156 @@ void webInit() {
 
   // Health check endpoint (useful for testing)
   server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
-    char json[128];
-    snprintf(json, sizeof(json),
-      "{\"fw\":\"%s\",\"heap\":%d,\"uptime\":%lu,\"clients\":%d}",
+    // "isp2" holds one stats object per chain (~285 bytes each)
+    char json[128 + ISP2_CHAINS * 296];
+    int len = snprintf(json, sizeof(json),
+      "{\"fw\":\"%s\",\"heap\":%d,\"uptime\":%lu,\"clients\":%d,\"isp2\":[",
       FW_VERSION, ESP.getFreeHeap(), millis() / 1000, ws.count());
+    for (uint8_t ch = 0; ch < ISP2_CHAINS; ch++) {
+      const ISP2Stats &isp2 = isp2GetStats(ch);
+      len += snprintf(json + len, sizeof(json) - len,
+        "%s{\"bytes\":%lu,\"pkts\":%lu,\"other\":%lu,\"discard\":%lu,"
+        "\"syncLoss\":%lu,\"timeouts\":%lu,\"badLen\":%lu,\"overflow\":%lu,"
+        "\"missed\":%lu,\"outages\":%lu,\"ivMinUs\":%lu,\"ivAvgUs\":%lu,\"ivMaxUs\":%lu,\"capture\":%.2f}",
+        ch ? "," : "",
+        (unsigned long)isp2.bytes, (unsigned long)isp2.packets,
+        (unsigned long)isp2.otherPackets, (unsigned long)isp2.discarded,
+        (unsigned long)isp2.syncLosses, (unsigned long)isp2.timeouts,
+        (unsigned long)isp2.badLengths, (unsigned long)isp2.overflows,
+        (unsigned long)isp2.missedFrames, (unsigned long)isp2.outages,
+        (unsigned long)isp2.intervalMinUs,
+        (unsigned long)isp2StatsMeanUs(isp2), (unsigned long)isp2.intervalMaxUs,
+        isp2StatsCapturePct(isp2));
+    }
+    snprintf(json + len, sizeof(json) - len, "]}");
     request->send(200, "application/json", json);
   });
 
+  // Pipeline counters + latency histograms for a local scraper
+  server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response =
+      request->beginResponseStream("text/plain; version=0.0.4");
+    metricsWrite(*response);
+    request->send(response);
+  });
+
+#ifdef TRACE_ENABLE
+  // Event trace: ?start arms a new capture, otherwise stream the last
+  // one as Chrome Trace Event JSON (open in ui.perfetto.dev)
+  server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+    if (request->hasParam("start")) {
+      traceStart();
+      request->send(200, "application/json", "{\"armed\":true}");
+      return;
+    }
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+      "application/json",
+      [](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+        return traceFillJson(buf, maxLen, index);
+      });
+    response->addHeader("Content-Disposition", "attachment; filename=trace.json");
+    request->send(response);
+  });
+#endif
+
   // WebSocket
   ws.onEvent(onWsEvent);
   server.addHandler(&ws);
 
   server.begin();
-  Serial.println("INF: Web server started on port 80");
+  Console.println("INF: Web server started on port 80");
 }
 
+// WebSocket JSON: per value type, format and argument of one member
+#define JSON_FMT_DEG(key, dg)   ",\"" #key "\":%.7f"
+#define JSON_FMT_F(key, dg)     ",\"" #key "\":%." #dg "f"
+#define JSON_FMT_U8(key, dg)    ",\"" #key "\":%u"
+#define JSON_FMT_BOOL(key, dg)  ",\"" #key "\":%s"
+#define JSON_ARG_DEG(m)   , (double)data.m / 1e7
+#define JSON_ARG_F(m)     , (double)data.m
+#define JSON_ARG_U8(m)    , (unsigned)data.m
+#define JSON_ARG_BOOL(m)  , data.m ? "true" : "false"
+#define JSON_FMT_GPS(name, unit, m, type, store, dg, group, json)  AB_IN_GROUP(group, GPS, JSON_FMT_##type(json, dg))
+#define JSON_FMT_IMU(name, unit, m, type, store, dg, group, json)  AB_IN_GROUP(group, IMU, JSON_FMT_##type(json, dg))
+#define JSON_FMT_ENG(name, unit, m, type, store, dg, group, json)  AB_IN_GROUP(group, ENG, JSON_FMT_##type(json, dg))
+#define JSON_ARG_GPS(name, unit, m, type, store, dg, group, json)  AB_IN_GROUP(group, GPS, JSON_ARG_##type(m))
+#define JSON_ARG_IMU(name, unit, m, type, store, dg, group, json)  AB_IN_GROUP(group, IMU, JSON_ARG_##type(m))
+#define JSON_ARG_ENG(name, unit, m, type, store, dg, group, json)  AB_IN_GROUP(group, ENG, JSON_ARG_##type(m))
+
+// Append ,"name":{members[extra]} to json at p
+#define JSON_GROUP(G, name, extraFmt, ...)                                   \
+  if (p < end) {                                                             \
+    char *open = p + sizeof(",\"" name "\":") - 1;                           \
+    p += snprintf(p, end - p, ",\"" name "\":" AB_CHANNELS(JSON_FMT_##G, )   \
+                  extraFmt "}" AB_CHANNELS(JSON_ARG_##G, ), ##__VA_ARGS__);  \
+    if (p < end) *open = '{';                                                \
+  }
+
 void webBroadcast(const SensorData &data, bool isRecording,
                   const char* filename, unsigned long rowCount,
                   float duration, uint16_t keyframeCount) {
   if (ws.count() == 0) return;  // No clients, skip serialization
 
-  // Build JSON payload (~350 bytes)
-  char json[512];
-  int len = snprintf(json, sizeof(json),
-    "{\"t\":%.3f,"
-    "\"gps\":{\"lat\":%.7f,\"lon\":%.7f,\"spd\":%.1f,\"alt\":%.0f,\"dir\":%.0f,\"sat\":%d,\"stale\":%s},"
-    "\"imu\":{\"ax\":%.2f,\"ay\":%.2f,\"az\":%.2f,\"gx\":%.1f,\"gy\":%.1f,\"gz\":%.1f,"
-            "\"mx\":%.0f,\"my\":%.0f,\"mz\":%.0f,\"tmp\":%.1f},"
-    "\"eng\":{\"afr\":%.1f,\"afr1\":%.1f,\"vss\":%.1f,\"map\":%.1f,\"oil\":%.0f,\"clt\":%.0f},"
-    "\"rec\":{\"on\":%s,\"file\":\"%s\",\"rows\":%lu,\"dur\":%.1f,\"kf\":%d}}",
-    (float)millis() / 1000.0f,
-    // GPS — convert degE7 back to float for JSON
-    (double)data.lat / 1e7, (double)data.lon / 1e7,
-    data.speed, data.alt, data.dir, data.satellites,
-    data.gpsStale ? "true" : "false",
-    // IMU
-    data.accx, data.accy, data.accz,
-    data.rotx, data.roty, data.rotz,
-    data.magx, data.magy, data.magz, data.imuTemp,
-    // Engine
-    data.afr, data.afr1, data.vss, data.map, data.oilp, data.coolant,
-    // Recording
-    isRecording ? "true" : "false",
-    filename ? filename : "",
-    rowCount, duration, keyframeCount
-  );
-
-  ws.textAll(json, len);
+  // Build JSON payload (~590 bytes): one object per channel group,
+  // formats and arguments expanded from channels.h. Every member is
+  // written with a leading comma; the group's first one becomes its '{'.
+  char json[704];
+  char *p = json;
+  char *end = json + sizeof(json);
+  p += snprintf(p, end - p, "{\"t\":%.3f", (float)millis() / 1000.0f);
+  JSON_GROUP(GPS, "gps", "");
+  JSON_GROUP(IMU, "imu", "");
+  JSON_GROUP(ENG, "eng", ",\"afrDet\":%u,\"afr1Det\":%u", data.afrDetail, data.afr1Detail);
+  if (p < end) {
+    p += snprintf(p, end - p, ",\"rec\":{\"on\":%s,\"file\":\"%s\",\"rows\":%lu,\"dur\":%.1f,\"kf\":%d}}",
+      isRecording ? "true" : "false",
+      filename ? filename : "",
+      rowCount, duration, keyframeCount);
+  }
+  if (p >= end) {
+    Console.println("WRN: WS frame truncated");
+    return;
+  }
+  int len = p - json;
+
+  // Per client: one whose send queue is full (stalled phone, weak
+  // link) misses this frame; the others still get it. The next one is
+  // only 200ms away.
+  uint32_t sent = 0, dropped = 0;
+  TRACE_BEGIN(TR_WS_SEND);
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    uint32_t id = wsSlots[i].id;
+    if (id == 0) continue;
+    AsyncWebSocketClient *c = ws.client(id);
+    if (!c) continue;
+    if (c->queueIsFull()) {
+      portENTER_CRITICAL(&wsMux);
+      if (wsSlots[i].id == id) wsSlots[i].dropped++;
+      portEXIT_CRITICAL(&wsMux);
+      dropped++;
+      continue;
+    }
+    c->text(json, len);
+    sent++;
+  }
+  TRACE_END(TR_WS_SEND, sent);
+  if (sent) metricsInc(MC_WS_FRAMES_SENT, sent);
+  if (dropped) metricsInc(MC_WS_FRAMES_DROPPED, dropped);
+}
+
+void webWriteMetrics(Print &out) {
+  WsClientSlot snap[WS_MAX_CLIENTS];
+  portENTER_CRITICAL(&wsMux);
+  memcpy(snap, wsSlots, sizeof(snap));
+  portEXIT_CRITICAL(&wsMux);
+  out.printf("# HELP ab_ws_client_frames_dropped_total %s\n"
+             "# TYPE ab_ws_client_frames_dropped_total counter\n",
+             "WebSocket frames skipped per connected client (send queue full)");
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (snap[i].id == 0) continue;
+    out.printf("ab_ws_client_frames_dropped_total{client=\"%lu\"} %lu\n",
+      (unsigned long)snap[i].id, (unsigned long)snap[i].dropped);
+  }
 }
 
 int webGetClientCount() {
@@ -4,16 +4,45 @@
  *  WiFi AP + ESPAsyncWebServer + WebSocket for live monitoring.
  *  Serves gzipped dashboard HTML from PROGMEM, broadcasts sensor
  *  data as JSON over WebSocket at 5Hz.
+ *
+ *  Remote commands arrive as WebSocket text frames:
+ *    {"id":12,"cmd":"k"}      (a bare "k" is also accepted, id 0)
+ *  and are answered with an ack once executed:
+ *    {"ack":12,"cmd":"k","ok":true,"rec":true}
+ *    {"ack":12,"cmd":"x","ok":false,"err":"unsupported"}
+ *  Whitespace around the JSON colons is allowed. A frame that doesn't
+ *  parse is answered at once with cmd "?" (and its id, if readable):
+ *    {"ack":12,"cmd":"?","ok":false,"err":"bad command"}
+ *  Supported: r = start, s = stop, k = keyframe.
  */
 #ifndef AB_WEB_SERVER_H
 #define AB_WEB_SERVER_H
 
 #include "sensor_data.h"
+#include <Arduino.h>
+
+// Callback function types for remote commands
+typedef void (*WebStartCallback)();
+typedef void (*WebStopCallback)();
+typedef void (*WebKeyframeCallback)();
+typedef bool (*WebRecordingQuery)();
 
 // Initialize WiFi AP and start the web server.
 void webInit();
 
-// Broadcast sensor data to all connected WebSocket clients.
+// Set callbacks for remote commands (same ones the button and serial use).
+void webCmdInit(WebStartCallback onStart,
+                WebStopCallback onStop,
+                WebKeyframeCallback onKeyframe,
+                WebRecordingQuery isRecording);
+
+// Wait up to `wait` ticks for a queued remote command, run it and ack
+// the sender. Call from a dedicated task — never from the async TCP task.
+// Returns true if a command was processed.
+bool webProcessCommand(TickType_t wait);
+
+// Broadcast sensor data to all connected WebSocket clients. A client
+// whose send queue is full skips the frame; the others still get it.
 // Call at WS_BROADCAST_MS interval (5Hz).
 void webBroadcast(const SensorData &data, bool isRecording,
                   const char* filename, unsigned long rowCount,
@@ -25,4 +54,7 @@ int webGetClientCount();
 // Cleanup disconnected clients (call periodically).
 void webCleanup();
 
+// Write per-client WebSocket drop counters (Prometheus text).
+void webWriteMetrics(Print &out);
+
 #endif // AB_WEB_SERVER_H
@@ -0,0 +1,230 @@
+/**
+ *  Analog Bridge — Attitude Filter (Mahony AHRS)
+ *
+ *  Orientation of the car-frame IMU axes (accx/accy/accz after the axis
+ *  remap) from gyro, accel and, when calibrated, magnetometer, plus the
+ *  acceleration with gravity taken out.
+ *
+ *  Mahony complementary filter on a unit quaternion: the gyro rotates
+ *  the estimate every sample (exact axis-angle step, so the 80 ms sample
+ *  period costs no accuracy on a 60 dps turn) and a proportional
+ *  correction pulls it toward
+ *    - gravity: the accel vector minus the car's own motion, which is
+ *      known from wheel speed: dv/dt along the forward axis plus the
+ *      centripetal ω × v. Without this, 0.8 g in a corner would tilt
+ *      the estimate. What is left is weighted down as it strays from
+ *      1 g (bumps, wheelspin, VSS dropouts). With no usable speed the
+ *      car's motion is unknown: only samples within AHRS_ACC_GATE_BLIND
+ *      of 1 g correct, at AHRS_KP_ACC_BLIND, and the gravity-free accel
+ *      is not to be trusted (the caller flags it).
+ *    - magnetic north: heading only (the error's vertical component), so
+ *      a disturbed field never tilts roll/pitch. No mag = gyro heading.
+ *  No integral term: gyro_bias.h already removes the gyro offset.
+ *
+ *  Earth frame is z up; the estimate starts level and aligned to the
+ *  first accel (and mag) sample, so there is no settling period.
+ *  Constant time, no allocation. Runs on the ESP32; the Mega logs the
+ *  attitude channels as 0. tools/host/ahrs_bench.cpp drives it on a host.
+ */
+#ifndef AB_AHRS_H
+#define AB_AHRS_H
+
+#include <stdint.h>
+#include <math.h>
+
+//----------------------------------------------------------------
+// Tuning
+//----------------------------------------------------------------
+#define AHRS_KP_ACC     0.5f    // 1/s: tilt follows gravity in ~2 s
+#define AHRS_KP_MAG     0.2f    // 1/s: heading follows north in ~5 s
+#define AHRS_ACC_GATE   0.2f    // g: gravity residual off 1 g by this gets no weight
+#define AHRS_KP_ACC_BLIND   0.05f  // 1/s: without speed, tilt follows gravity in ~20 s
+#define AHRS_ACC_GATE_BLIND 0.05f  // g: ...and only from samples this close to 1 g
+
+#define AHRS_G          9.80665f
+#define AHRS_DEG        57.29578f
+
+struct Ahrs {
+  float q[4];          // w, x, y, z: car frame → earth frame
+  float speed;         // m/s, last wheel speed
+  bool  speedOk;       // speed is a measurement
+  bool  started;
+};
+
+inline void ahrsReset(Ahrs &a) {
+  a.q[0] = 1.0f;
+  a.q[1] = a.q[2] = a.q[3] = 0.0f;
+  a.speed = 0.0f;
+  a.speedOk = false;
+  a.started = false;
+}
+
+// Earth z (up) in the car frame: the accel reading of a car at rest
+inline void ahrsUp(const Ahrs &a, float up[3]) {
+  const float *q = a.q;
+  up[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+  up[1] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+  up[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+// Rotate a car-frame vector into the earth frame
+inline void ahrsToEarth(const Ahrs &a, const float v[3], float e[3]) {
+  const float *q = a.q;
+  e[0] = (1 - 2 * (q[2] * q[2] + q[3] * q[3])) * v[0] + 2 * (q[1] * q[2] - q[0] * q[3]) * v[1] + 2 * (q[1] * q[3] + q[0] * q[2]) * v[2];
+  e[1] = 2 * (q[1] * q[2] + q[0] * q[3]) * v[0] + (1 - 2 * (q[1] * q[1] + q[3] * q[3])) * v[1] + 2 * (q[2] * q[3] - q[0] * q[1]) * v[2];
+  e[2] = 2 * (q[1] * q[3] - q[0] * q[2]) * v[0] + 2 * (q[2] * q[3] + q[0] * q[1]) * v[1] + (1 - 2 * (q[1] * q[1] + q[2] * q[2])) * v[2];
+}
+
+inline void ahrsNormalize(float *v, uint8_t n) {
+  float s = 0.0f;
+  for (uint8_t i = 0; i < n; i++) s += v[i] * v[i];
+  if (s <= 0.0f) return;
+  s = 1.0f / sqrtf(s);
+  for (uint8_t i = 0; i < n; i++) v[i] *= s;
+}
+
+// First sample: roll/pitch from gravity, heading from the mag (or 0)
+inline void ahrsStart(Ahrs &a, const float acc[3], const float *mag) {
+  float roll = atan2f(acc[1], acc[2]);
+  float pitch = atan2f(-acc[0], sqrtf(acc[1] * acc[1] + acc[2] * acc[2]));
+  float yaw = 0.0f;
+  if (mag) {
+    // Tilt-compensated heading of the field's horizontal component
+    float cr = cosf(roll), sr = sinf(roll), cp = cosf(pitch), sp = sinf(pitch);
+    float hx = mag[0] * cp + mag[1] * sp * sr + mag[2] * sp * cr;
+    float hy = mag[1] * cr - mag[2] * sr;
+    yaw = atan2f(-hy, hx);
+  }
+  float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+  float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+  float cy = cosf(yaw * 0.5f), sy = sinf(yaw * 0.5f);
+  a.q[0] = cr * cp * cy + sr * sp * sy;
+  a.q[1] = sr * cp * cy - cr * sp * sy;
+  a.q[2] = cr * sp * cy + sr * cp * sy;
+  a.q[3] = cr * cp * sy - sr * sp * cy;
+  a.started = true;
+}
+
+// One IMU sample in the car frame: gyro dps (bias removed), accel g, mag
+// uT or null, wheel speed m/s along the forward (x) axis, dt seconds.
+// speedOk false: no speed source (speed is ignored), see the top.
+inline void ahrsUpdate(Ahrs &a, const float gyro[3], const float acc[3], const float *mag,
+                       float speed, bool speedOk, float dt) {
+  if (!speedOk) speed = 0.0f;
+  if (!a.started) {
+    ahrsStart(a, acc, mag);
+    a.speed = speed;
+    a.speedOk = speedOk;
+    return;
+  }
+  if (dt <= 0.0f) return;
+
+  float w[3] = { gyro[0] / AHRS_DEG, gyro[1] / AHRS_DEG, gyro[2] / AHRS_DEG };
+
+  // Car's own acceleration, g: forward dv/dt and centripetal ω × (v, 0, 0).
+  // dv/dt unfiltered: any low-pass lags the accel it is subtracted from,
+  // and VSS jitter is what the 1 g gate is for. None on the sample speed
+  // comes back: the last one is not a measurement.
+  float dvdt = speedOk && a.speedOk ? (speed - a.speed) / dt : 0.0f;
+  a.speed = speed;
+  a.speedOk = speedOk;
+  float grav[3] = {
+    acc[0] - dvdt / AHRS_G,
+    acc[1] - w[2] * speed / AHRS_G,
+    acc[2] + w[1] * speed / AHRS_G,
+  };
+
+  float e[3] = { 0.0f, 0.0f, 0.0f };
+  float up[3];
+  ahrsUp(a, up);
+
+  // Gravity: error = measured × estimated, weighted by how close to 1 g
+  float gn = sqrtf(grav[0] * grav[0] + grav[1] * grav[1] + grav[2] * grav[2]);
+  float wAcc = 1.0f - fabsf(gn - 1.0f) / (speedOk ? AHRS_ACC_GATE : AHRS_ACC_GATE_BLIND);
+  if (wAcc > 0.0f && gn > 0.0f) {
+    float g[3] = { grav[0] / gn, grav[1] / gn, grav[2] / gn };
+    float kp = (speedOk ? AHRS_KP_ACC : AHRS_KP_ACC_BLIND) * wAcc;
+    e[0] += kp * (g[1] * up[2] - g[2] * up[1]);
+    e[1] += kp * (g[2] * up[0] - g[0] * up[2]);
+    e[2] += kp * (g[0] * up[1] - g[1] * up[0]);
+  }
+
+  // North: horizontal field direction vs estimated north, about `up` only
+  if (mag) {
+    float m[3] = { mag[0], mag[1], mag[2] };
+    ahrsNormalize(m, 3);
+    float h[3];
+    ahrsToEarth(a, m, h);
+    float bx = sqrtf(h[0] * h[0] + h[1] * h[1]);
+    if (bx > 0.1f) {
+      // Estimated north (bx, 0, bz) back in the car frame
+      float n[3] = { bx, 0.0f, h[2] };
+      const float *q = a.q;
+      float r[3] = {
+        (1 - 2 * (q[2] * q[2] + q[3] * q[3])) * n[0] + 2 * (q[1] * q[3] - q[0] * q[2]) * n[2],
+        2 * (q[1] * q[2] - q[0] * q[3]) * n[0] + 2 * (q[0] * q[1] + q[2] * q[3]) * n[2],
+        2 * (q[0] * q[2] + q[1] * q[3]) * n[0] + (1 - 2 * (q[1] * q[1] + q[2] * q[2])) * n[2],
+      };
+      float em[3] = {
+        m[1] * r[2] - m[2] * r[1],
+        m[2] * r[0] - m[0] * r[2],
+        m[0] * r[1] - m[1] * r[0],
+      };
+      float d = (em[0] * up[0] + em[1] * up[1] + em[2] * up[2]) * AHRS_KP_MAG;
+      e[0] += d * up[0];
+      e[1] += d * up[1];
+      e[2] += d * up[2];
+    }
+  }
+
+  // Rotate by (ω + e)·dt: exact axis-angle step
+  float r[3] = { (w[0] + e[0]) * dt, (w[1] + e[1]) * dt, (w[2] + e[2]) * dt };
+  float angle = sqrtf(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+  float dq[4];
+  if (angle > 1e-6f) {
+    float s = sinf(angle * 0.5f) / angle;
+    dq[0] = cosf(angle * 0.5f);
+    dq[1] = r[0] * s;
+    dq[2] = r[1] * s;
+    dq[3] = r[2] * s;
+  } else {
+    dq[0] = 1.0f;
+    dq[1] = r[0] * 0.5f;
+    dq[2] = r[1] * 0.5f;
+    dq[3] = r[2] * 0.5f;
+  }
+  float *q = a.q;
+  float q0 = q[0] * dq[0] - q[1] * dq[1] - q[2] * dq[2] - q[3] * dq[3];
+  float q1 = q[0] * dq[1] + q[1] * dq[0] + q[2] * dq[3] - q[3] * dq[2];
+  float q2 = q[0] * dq[2] - q[1] * dq[3] + q[2] * dq[0] + q[3] * dq[1];
+  float q3 = q[0] * dq[3] + q[1] * dq[2] - q[2] * dq[1] + q[3] * dq[0];
+  q[0] = q0; q[1] = q1; q[2] = q2; q[3] = q3;
+  ahrsNormalize(q, 4);
+}
+
+// Degrees, 0 when level and facing magnetic north (or the first sample's
+// heading without a mag):
+//   roll   ±180, about the forward axis (right-hand rule)
+//   pitch  ±90, + = nose up
+//   yaw    0–360, heading, clockwise seen from above
+inline void ahrsEuler(const Ahrs &a, float &roll, float &pitch, float &yaw) {
+  const float *q = a.q;
+  roll = atan2f(q[0] * q[1] + q[2] * q[3], 0.5f - q[1] * q[1] - q[2] * q[2]) * AHRS_DEG;
+  float s = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+  if (s > 1.0f) s = 1.0f;
+  if (s < -1.0f) s = -1.0f;
+  pitch = asinf(s) * AHRS_DEG;
+  yaw = -atan2f(q[1] * q[2] + q[0] * q[3], 0.5f - q[2] * q[2] - q[3] * q[3]) * AHRS_DEG;
+  if (yaw < 0.0f) yaw += 360.0f;
+}
+
+// Accel with gravity removed, car frame, g: acc − up
+inline void ahrsLinear(const Ahrs &a, const float acc[3], float lin[3]) {
+  float up[3];
+  ahrsUp(a, up);
+  lin[0] = acc[0] - up[0];
+  lin[1] = acc[1] - up[1];
+  lin[2] = acc[2] - up[2];
+}
+
+#endif // AB_AHRS_H
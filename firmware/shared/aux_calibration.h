@@ -0,0 +1,176 @@
+/**
+ *  Analog Bridge — Compile-Time Aux Calibration Tables
+ *
+ *  Turns a curve definition (linear, polynomial, Steinhart-Hart
+ *  thermistor, piecewise table) into a lookup table indexed by the raw
+ *  10-bit ISP2 aux value, evaluated entirely by the compiler. At run
+ *  time every conversion is one indexed load, however expensive the
+ *  curve is to compute.
+ *
+ *  A curve is any type with a constexpr static float at(uint16_t raw):
+ *
+ *    struct OilCurve {
+ *      static constexpr float at(uint16_t raw) {
+ *        return calLinear(calVolts(raw), 25.0, -12.5);
+ *      }
+ *    };
+ *    float psi = calLookup<OilCurve>(raw);
+ *
+ *  Written to C++11 (single-return constexpr) for the AVR toolchain.
+ *  Tables live in PROGMEM on AVR (4 KB each at 1024 entries, 1 KB at
+ *  256 on the ATmega328) and in flash .rodata on ESP32.
+ */
+#ifndef AB_AUX_CALIBRATION_H
+#define AB_AUX_CALIBRATION_H
+
+#include <stdint.h>
+
+//----------------------------------------------------------------
+// Table size and storage per platform
+//----------------------------------------------------------------
+#define CAL_RAW_BITS     10           // ISP2 aux words are 10-bit
+#define CAL_VREF         5.0          // SSI-4 input range (V)
+
+#if defined(__AVR__)
+  #include <avr/pgmspace.h>
+  #define CAL_LUT_ATTR     PROGMEM
+  #define CAL_LUT_READ(p)  pgm_read_float(p)
+  #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+    #define CAL_LUT_BITS   8          // 32 KB flash: quarter-resolution tables
+  #endif
+#else
+  #define CAL_LUT_ATTR
+  #define CAL_LUT_READ(p)  (*(p))
+#endif
+
+#ifndef CAL_LUT_BITS
+  #define CAL_LUT_BITS     10         // one entry per raw code
+#endif
+
+#define CAL_LUT_SIZE     (1u << CAL_LUT_BITS)
+#define CAL_LUT_SHIFT    (CAL_RAW_BITS - CAL_LUT_BITS)
+
+//----------------------------------------------------------------
+// Curve building blocks
+//----------------------------------------------------------------
+
+// Raw 10-bit code to volts
+constexpr double calVolts(uint16_t raw) {
+  return (double)raw * CAL_VREF / 1023.0;
+}
+
+constexpr double calLinear(double x, double gain, double offset) {
+  return x * gain + offset;
+}
+
+// Pin x to [lo, hi]: keeps a shorted or open sender inside the range
+// the channel can store
+constexpr double calClamp(double x, double lo, double hi) {
+  return x < lo ? lo : x > hi ? hi : x;
+}
+
+// c0 + c1·x + c2·x² + c3·x³ (Horner)
+constexpr double calPoly(double x, double c0, double c1, double c2 = 0.0, double c3 = 0.0) {
+  return c0 + x * (c1 + x * (c2 + x * c3));
+}
+
+// Natural log: ln(m·2^e) = ln(m) + e·ln2 with m in [1,2), then the
+// atanh series 2·Σ y^k/k, y = (m−1)/(m+1) ≤ 1/3 (16 terms, < 1e-15)
+constexpr double calLnSeries(double y2, double term, unsigned k) {
+  return k > 31 ? 0.0 : term / k + calLnSeries(y2, term * y2, k + 2);
+}
+
+constexpr double calLnMantissa(double y) {
+  return 2.0 * calLnSeries(y * y, y, 1);
+}
+
+constexpr double calLn(double x, int e = 0) {
+  return x <= 0.0 ? -1.0e30
+       : x >= 2.0 ? calLn(x * 0.5, e + 1)
+       : x <  1.0 ? calLn(x * 2.0, e - 1)
+       : calLnMantissa((x - 1.0) / (x + 1.0)) + e * 0.69314718055994531;
+}
+
+// Thermistor to ground with a pull-up to CAL_VREF: volts to ohms.
+// Rails are clamped so open/short circuits stay finite.
+constexpr double calThermistorOhms(double v, double pullupOhms) {
+  return v <= 0.0 ? 1.0
+       : v >= CAL_VREF ? 1.0e9
+       : pullupOhms * v / (CAL_VREF - v);
+}
+
+constexpr double calShKelvin(double lnR, double a, double b, double c) {
+  return 1.0 / (a + b * lnR + c * lnR * lnR * lnR);
+}
+
+// Steinhart-Hart: 1/T = A + B·ln(R) + C·ln(R)³, result in °F
+constexpr double calSteinhartF(double ohms, double a, double b, double c) {
+  return (calShKelvin(calLn(ohms), a, b, c) - 273.15) * 1.8 + 32.0;
+}
+
+// Piecewise-linear table, points sorted by x; clamps at both ends
+struct CalPoint {
+  float x, y;
+};
+
+constexpr double calLerp(const CalPoint &p0, const CalPoint &p1, double x) {
+  return p0.y + (x - p0.x) * (p1.y - p0.y) / (p1.x - p0.x);
+}
+
+constexpr double calPiecewise(double x, const CalPoint *p, unsigned n, unsigned i = 1) {
+  return x <= p[0].x ? p[0].y
+       : x >= p[n - 1].x ? p[n - 1].y
+       : x <= p[i].x ? calLerp(p[i - 1], p[i], x)
+       : calPiecewise(x, p, n, i + 1);
+}
+
+template <unsigned N>
+constexpr double calPiecewise(double x, const CalPoint (&p)[N]) {
+  return calPiecewise(x, p, N);
+}
+
+//----------------------------------------------------------------
+// Table generation
+// The index pack doubles at each step, so template depth stays at
+// log2(size) instead of one level per entry.
+//----------------------------------------------------------------
+template <unsigned... I>
+struct CalSeq {
+  typedef CalSeq<I..., (sizeof...(I) + I)...> Doubled;
+};
+
+template <unsigned N>
+struct CalMakeSeq {
+  static_assert((N & (N - 1)) == 0, "table size must be a power of two");
+  typedef typename CalMakeSeq<N / 2>::Type::Doubled Type;
+};
+
+template <>
+struct CalMakeSeq<1> {
+  typedef CalSeq<0> Type;
+};
+
+template <class Curve, class Seq>
+struct CalLutData;
+
+template <class Curve, unsigned... I>
+struct CalLutData<Curve, CalSeq<I...> > {
+  static const float table[sizeof...(I)];
+};
+
+// Each entry samples the middle of the raw codes it covers
+template <class Curve, unsigned... I>
+const float CalLutData<Curve, CalSeq<I...> >::table[sizeof...(I)] CAL_LUT_ATTR = {
+  (float)Curve::at((uint16_t)((I << CAL_LUT_SHIFT) | ((1u << CAL_LUT_SHIFT) >> 1)))...
+};
+
+template <class Curve>
+using CalLut = CalLutData<Curve, typename CalMakeSeq<CAL_LUT_SIZE>::Type>;
+
+// Raw 10-bit aux value to engineering units: one table load
+template <class Curve>
+inline float calLookup(uint16_t raw) {
+  return CAL_LUT_READ(&CalLut<Curve>::table[(raw & 0x3FF) >> CAL_LUT_SHIFT]);
+}
+
+#endif // AB_AUX_CALIBRATION_H
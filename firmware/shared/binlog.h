@@ -0,0 +1,108 @@
+/**
+ *  Analog Bridge — Binary Log Format
+ *
+ *  Fixed-record alternative to the CSV log (.bin next to where the .csv
+ *  would be), written by both targets and turned back into the same
+ *  CSV on a host by tools/host/bin2csv.cpp.
+ *
+ *  Layout (little-endian, 512-byte blocks so the AVR can write raw
+ *  sectors into a preallocated contiguous file):
+ *    block 0    BinlogHeader, zero padded to 512 bytes
+ *    block 1..  BINLOG_PER_BLOCK records of BinlogRecord each, the rest
+ *               of the block zero (records never straddle two sectors)
+ *
+ *  A record is the time, a SensorFrame (sensor_frame.h: every field at
+ *  the precision the CSV prints it, quantized the way the CSV rounds
+ *  it) and the keyframe, so a converted file reads like the CSV the
+ *  device would have written.
+ *
+ *  Records end with BINLOG_SYNC. The first record without it ends the
+ *  log: a preallocated file that lost power mid-session is zero filled
+ *  past the last block written.
+ *
+ *  The record is exactly its fields, no spare bytes: 80 with the current
+ *  channels, six to a block and 32 bytes of tail. A power-of-two record
+ *  would only save the reader the skip over the tail; 128 bytes cost a
+ *  third of each block. The header carries the record size and channel
+ *  count so bin2csv refuses a log written with a different channel table.
+ */
+#ifndef AB_BINLOG_H
+#define AB_BINLOG_H
+
+#include <stdint.h>
+#include <string.h>
+#include "sensor_frame.h"
+
+#define BINLOG_MAGIC       "ABLG"
+#define BINLOG_VERSION     4
+#define BINLOG_BLOCK       512
+#define BINLOG_SYNC        0xA5
+
+#define BINLOG_SRC_AVR     1
+#define BINLOG_SRC_ESP32   2
+
+struct BinlogHeader {
+  char     magic[4];          // "ABLG"
+  uint8_t  version;
+  uint8_t  source;            // BINLOG_SRC_*
+  uint16_t recordSize;        // sizeof(BinlogRecord)
+  uint16_t sampleMs;          // nominal row period
+  uint8_t  channels;          // AB_CHANNEL_COUNT
+  uint8_t  reserved;
+  char     date[24];          // first line of the CSV (GPS date/time)
+  char     firmware[16];      // FW_VERSION
+};
+
+static_assert(sizeof(BinlogHeader) == 52, "binlog header layout");
+
+// One CSV row: the packed sample plus what only the log carries
+struct __attribute__((packed)) BinlogRecord {
+  uint32_t    timeMs;         // since recording start
+  SensorFrame frame;
+  uint16_t    keyframe;
+  uint8_t     sync;           // BINLOG_SYNC
+};
+
+static_assert(sizeof(BinlogRecord) == 4 + sizeof(SensorFrame) + 2 + 1, "binlog record layout");
+static_assert(sizeof(BinlogRecord) <= BINLOG_BLOCK / 2, "channel table outgrew the binlog record");
+
+#define BINLOG_PER_BLOCK   (BINLOG_BLOCK / sizeof(BinlogRecord))
+
+// File offset of the record after the one at pos: the next slot in the
+// block, or the first of the next block once the tail is reached
+inline size_t binlogNextRecord(size_t pos) {
+  pos += sizeof(BinlogRecord);
+  if (pos % BINLOG_BLOCK + sizeof(BinlogRecord) > BINLOG_BLOCK) {
+    pos += BINLOG_BLOCK - pos % BINLOG_BLOCK;
+  }
+  return pos;
+}
+
+inline void binlogHeaderInit(BinlogHeader &h, uint8_t source, uint16_t sampleMs,
+                             const char *date, const char *firmware) {
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, BINLOG_MAGIC, 4);
+  h.version = BINLOG_VERSION;
+  h.source = source;
+  h.recordSize = sizeof(BinlogRecord);
+  h.sampleMs = sampleMs;
+  h.channels = AB_CHANNEL_COUNT;
+  if (date) strncpy(h.date, date, sizeof(h.date) - 1);
+  if (firmware) strncpy(h.firmware, firmware, sizeof(h.firmware) - 1);
+}
+
+inline bool binlogHeaderValid(const BinlogHeader &h) {
+  return memcmp(h.magic, BINLOG_MAGIC, 4) == 0 && h.version == BINLOG_VERSION &&
+         h.recordSize == sizeof(BinlogRecord) && h.channels == AB_CHANNEL_COUNT;
+}
+
+// Fill one record from SensorData (either target's copy: same names)
+template <class Data>
+void binlogEncode(BinlogRecord &r, const Data &d, uint32_t timeMs, uint16_t keyframe) {
+  r.timeMs   = timeMs;
+  sensorFrameEncode(r.frame, d);
+  r.keyframe = keyframe;
+  r.sync     = BINLOG_SYNC;
+}
+
+#endif // AB_BINLOG_H
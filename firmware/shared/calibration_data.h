@@ -3,7 +3,8 @@
  *
  *  Shared between AVR (EEPROM) and ESP32 (NVS) targets.
  *  The storage backend differs, but the data structure and
- *  calibration math are identical.
+ *  calibration math are identical. (The AVR sketch still keeps its own
+ *  copy with a per-axis magScale[3] from min/max tumble cal.)
  *
  *  Axis remapping: maps chip X/Y/Z to car Forward/Right/Down (SAE)
  *  Change the defines below when the sensor board is mounted differently.
@@ -30,18 +31,21 @@
 struct IMUCalibration {
   uint16_t magic;             // Must match CAL_MAGIC or struct is ignored
 
-  // Gyro bias — auto-zeroed every boot, NOT persisted
-  // Kept in struct for runtime convenience
+  // Gyro bias — AVR: auto-zeroed every boot, not persisted.
+  // ESP32: current output of the learned temperature model (gyro_bias.h,
+  // own NVS key "gyroModel"), updated every sample
   float gyroBias[3];          // dps offset (subtracted from raw)
 
   // Accelerometer offset — zeroed on level surface via 'c' command
   float accelBias[3];         // g offset (subtracted from raw)
 
-  // Magnetometer hard-iron offset — min/max tumble cal via 'm' command
+  // Magnetometer hard-iron offset — ellipsoid centre from the 'm' tumble
   float magBias[3];           // uT offset (subtracted from raw)
 
-  // Magnetometer soft-iron scale — normalizes to sphere
-  float magScale[3];          // multiplier per axis (nominally 1.0)
+  // Magnetometer soft-iron matrix — maps the tumble ellipsoid onto a
+  // sphere, cross-axis terms included (mag_fit.h):
+  //   corrected = magSoft × (raw − magBias)
+  float magSoft[3][3];        // row-major, unitless (nominally identity)
 };
 
 //----------------------------------------------------------------
@@ -0,0 +1,124 @@
+/**
+ *  Analog Bridge — Channel Schema
+ *
+ *  The one list of logged channels. Everything that enumerates them is
+ *  expanded from AB_CHANNELS at compile time:
+ *    SensorData fields         sensor_data.h, AVR sketch
+ *    SensorFrame and its codec sensor_frame.h (binary log)
+ *    CSV header, units, rows   both targets' SD loggers and serial output
+ *    WebSocket JSON            web_server.cpp
+ *    bin2csv                   tools/host/bin2csv.cpp
+ *  so each output is straight-line code with the format of every field
+ *  fixed by its row here; nothing is looked up at run time.
+ *
+ *  Adding a channel is one row. New rows go at the end: parsers that
+ *  index the older columns by position keep working. log-analyzer.html
+ *  keeps its own copy of the names (EXPECTED_COLS).
+ *
+ *  X(name, unit, member, type, store, digits, group, json)
+ *    name    CSV column
+ *    unit    units row, printed as "(unit)"
+ *    member  SensorData / SensorFrame field (_ for log-only columns)
+ *    type    value and its formatting:
+ *              TIME  recording time, ms printed as s   (log only)
+ *              KEY   keyframe number                   (log only)
+ *              DEG   degE7 long printed as degrees
+ *              F     float printed with `digits` decimals
+ *              U8    uint8_t
+ *              BOOL  bool printed as 0/1
+ *    store   SensorFrame field: I32, I16, U16, U8, or NONE. F channels
+ *            are stored × 10^digits, i.e. at the precision printed.
+ *    digits  decimals in CSV, JSON and the frame
+ *    group   JSON object: GPS, IMU, ENG; LOG for log-only columns
+ *    json    key inside the JSON object
+ *
+ *  Usage: define X for one row and pass the separator to put between
+ *  rows, e.g. the header is AB_CHANNELS(AB_CSV_NAME, ",").
+ */
+#ifndef AB_CHANNELS_H
+#define AB_CHANNELS_H
+
+#define AB_CHANNELS(X, S) \
+  X(time,     "s",       _,          TIME, NONE, 3, LOG, t)      S \
+  X(lat,      "deg",     lat,        DEG,  I32,  7, GPS, lat)    S \
+  X(lon,      "deg",     lon,        DEG,  I32,  7, GPS, lon)    S \
+  X(speed,    "mph",     speed,      F,    U16,  2, GPS, spd)    S \
+  X(alt,      "ft",      alt,        F,    I32,  2, GPS, alt)    S \
+  X(dir,      "deg",     dir,        F,    U16,  2, GPS, dir)    S \
+  X(sats,     "#",       satellites, U8,   U8,   0, GPS, sat)    S \
+  X(accx,     "g",       accx,       F,    I16,  2, IMU, ax)     S \
+  X(accy,     "g",       accy,       F,    I16,  2, IMU, ay)     S \
+  X(accz,     "g",       accz,       F,    I16,  2, IMU, az)     S \
+  X(rotx,     "dps",     rotx,       F,    I16,  2, IMU, gx)     S \
+  X(roty,     "dps",     roty,       F,    I16,  2, IMU, gy)     S \
+  X(rotz,     "dps",     rotz,       F,    I16,  2, IMU, gz)     S \
+  X(magx,     "uT",      magx,       F,    I16,  2, IMU, mx)     S \
+  X(magy,     "uT",      magy,       F,    I16,  2, IMU, my)     S \
+  X(magz,     "uT",      magz,       F,    I16,  2, IMU, mz)     S \
+  X(imuTemp,  "C",       imuTemp,    F,    I16,  1, IMU, tmp)    S \
+  X(afr,      "afr",     afr,        F,    I16,  2, ENG, afr)    S \
+  X(afr1,     "afr",     afr1,       F,    I16,  2, ENG, afr1)   S \
+  X(vss,      "mph",     vss,        F,    I16,  2, ENG, vss)    S \
+  X(map,      "inHgVac", map,        F,    I16,  2, ENG, map)    S \
+  X(oilp,     "psig",    oilp,       F,    I16,  2, ENG, oil)    S \
+  X(coolant,  "F",       coolant,    F,    I16,  2, ENG, clt)    S \
+  X(gpsStale, "flag",    gpsStale,   BOOL, U8,   0, GPS, stale)  S \
+  X(keyframe, "#",       _,          KEY,  NONE, 0, LOG, kf)     S \
+  X(afrStat,  "code",    afrStat,    U8,   U8,   0, ENG, afrSt)  S \
+  X(afr1Stat, "code",    afr1Stat,   U8,   U8,   0, ENG, afr1St) S \
+  X(engQual,  "flags",   engQual,    U8,   U8,   0, ENG, q)      S \
+  X(egt,      "F",       egt,        F,    I16,  0, ENG, egt)    S \
+  X(fuelp,    "psig",    fuelp,      F,    I16,  2, ENG, fuel)   S \
+  X(roll,     "deg",     roll,       F,    I16,  1, IMU, roll)   S \
+  X(pitch,    "deg",     pitch,      F,    I16,  1, IMU, pitch)  S \
+  X(yaw,      "deg",     yaw,        F,    I16,  1, IMU, yaw)    S \
+  X(linx,     "g",       linx,       F,    I16,  2, IMU, lx)     S \
+  X(liny,     "g",       liny,       F,    I16,  2, IMU, ly)     S \
+  X(linz,     "g",       linz,       F,    I16,  2, IMU, lz)     S \
+  X(rpm,      "rpm",     rpm,        F,    U16,  0, ENG, rpm)    S \
+  X(rpmConf,  "%",       rpmConf,    U8,   U8,   0, ENG, rpmQ)   S \
+  X(linOk,    "flag",    linOk,      BOOL, U8,   0, IMU, lok)
+
+//----------------------------------------------------------------
+// Whole-table expansions
+//----------------------------------------------------------------
+
+#define AB_CSV_NAME(name, unit, m, type, store, dg, group, json)  #name
+#define AB_CSV_UNIT(name, unit, m, type, store, dg, group, json)  "(" unit ")"
+#define AB_CHANNEL_ONE(name, unit, m, type, store, dg, group, json)  + 1
+
+// String literals, so F() and PROGMEM take them as is
+#define AB_CSV_HEADER  AB_CHANNELS(AB_CSV_NAME, ",")
+#define AB_CSV_UNITS   AB_CHANNELS(AB_CSV_UNIT, ",")
+
+#define AB_CHANNEL_COUNT  (0 AB_CHANNELS(AB_CHANNEL_ONE, ))
+
+// SensorData member for each value type; log-only columns have none
+#define AB_FIELD_TIME(m)
+#define AB_FIELD_KEY(m)
+#define AB_FIELD_DEG(m)   long m;
+#define AB_FIELD_F(m)     float m;
+#define AB_FIELD_U8(m)    uint8_t m;
+#define AB_FIELD_BOOL(m)  bool m;
+#define AB_CHANNEL_FIELD(name, unit, m, type, store, dg, group, json)  AB_FIELD_##type(m)
+
+// Declares every channel's SensorData member, in column order
+#define AB_CHANNEL_FIELDS  AB_CHANNELS(AB_CHANNEL_FIELD, )
+
+// AB_IN_GROUP(group, G, x...): x when the row's group is G, else nothing.
+// Lets one expansion pick out a JSON object's rows.
+#define AB_IN_GROUP(group, G, ...)  AB_GROUP_##group##_##G(__VA_ARGS__)
+#define AB_GROUP_LOG_GPS(...)
+#define AB_GROUP_LOG_IMU(...)
+#define AB_GROUP_LOG_ENG(...)
+#define AB_GROUP_GPS_GPS(...)  __VA_ARGS__
+#define AB_GROUP_GPS_IMU(...)
+#define AB_GROUP_GPS_ENG(...)
+#define AB_GROUP_IMU_GPS(...)
+#define AB_GROUP_IMU_IMU(...)  __VA_ARGS__
+#define AB_GROUP_IMU_ENG(...)
+#define AB_GROUP_ENG_GPS(...)
+#define AB_GROUP_ENG_IMU(...)
+#define AB_GROUP_ENG_ENG(...)  __VA_ARGS__
+
+#endif // AB_CHANNELS_H
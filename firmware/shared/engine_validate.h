@@ -0,0 +1,191 @@
+/**
+ *  Analog Bridge — Engine Channel Plausibility Checks
+ *
+ *  ISP2 has no checksum: a payload decoded out of sync turns into wild
+ *  values (40 AFR, 300 psi oil). After each ISP2 packet the engine
+ *  channels are checked for
+ *    - range:  outside what the sensor can physically report
+ *    - rate:   moved further from the last accepted value than the
+ *              channel can in the elapsed time
+ *    - cross:  VSS disagrees with GPS speed while GPS has a fix
+ *  and each failing channel sets its bit in engQual. Values are left
+ *  as decoded, so logs keep the raw reading next to the verdict.
+ *
+ *  A genuine step (sender swapped, wheelspin ended) looks like a rate
+ *  violation only until it has held: the first rejected value becomes a
+ *  relock candidate, and once ENG_RATE_RELOCK more rejects each land
+ *  within the rate limit of the one before, the level is accepted as
+ *  the new reference. A reject that doesn't match restarts the count
+ *  from itself, so a noisy sender never relocks.
+ *
+ *  Constant time per packet, no allocation; shared by both targets.
+ */
+#ifndef AB_ENGINE_VALIDATE_H
+#define AB_ENGINE_VALIDATE_H
+
+#include <stdint.h>
+#include <math.h>
+#include "isp2_defs.h"
+
+// Channel order = engQual bit order
+enum EngineChannel : uint8_t {
+  ENG_AFR, ENG_AFR1, ENG_VSS, ENG_MAP, ENG_OILP, ENG_COOLANT, ENG_EGT, ENG_FUELP,
+  ENG_CH_COUNT
+};
+
+#define EQ_AFR      (1 << ENG_AFR)
+#define EQ_AFR1     (1 << ENG_AFR1)
+#define EQ_VSS      (1 << ENG_VSS)
+#define EQ_MAP      (1 << ENG_MAP)
+#define EQ_OILP     (1 << ENG_OILP)
+#define EQ_COOLANT  (1 << ENG_COOLANT)
+#define EQ_EGT      (1 << ENG_EGT)
+#define EQ_FUELP    (1 << ENG_FUELP)
+#define EQ_ALL      0xFF
+
+//----------------------------------------------------------------
+// Limits: plausible range and fastest believable change per second
+// Tune for your sensors alongside the curves in isp2_defs.h
+//----------------------------------------------------------------
+#define ENG_AFR_MIN        6.0f     // LC-1 reports 7.35-22.4 at 14.7 mult
+#define ENG_AFR_MAX        25.0f
+#define ENG_AFR_RATE       60.0f    // AFR/s — tip-in lean spikes are fast
+#define ENG_VSS_MIN        0.0f
+#define ENG_VSS_MAX        180.0f   // mph
+#define ENG_VSS_RATE       40.0f    // mph/s — ~1.8 g, beyond a 454 on street tires
+#define ENG_MAP_MIN        -15.0f   // inHgVac (1-bar sensor: ±14.7)
+#define ENG_MAP_MAX        30.0f
+#define ENG_MAP_RATE       300.0f   // inHg/s — snap throttle, 20 → 0 in ~70 ms
+#define ENG_OILP_MIN       -5.0f    // psig (sender offset at 0 psi)
+#define ENG_OILP_MAX       120.0f
+#define ENG_OILP_RATE      150.0f   // psi/s — cold start to full pressure
+#define ENG_COOLANT_MIN    -40.0f   // °F
+#define ENG_COOLANT_MAX    300.0f
+#define ENG_COOLANT_RATE   10.0f    // °F/s — thermostat opening is ~1 °F/s
+#define ENG_EGT_MIN        -40.0f   // °F
+#define ENG_EGT_MAX        2000.0f
+#define ENG_EGT_RATE       800.0f   // °F/s — bare-junction probe on a throttle stab
+#define ENG_FUELP_MIN      -5.0f    // psig (sender offset at 0 psi)
+#define ENG_FUELP_MAX      100.0f
+#define ENG_FUELP_RATE     100.0f   // psi/s — pump prime, regulator opening
+
+static_assert(COOLANT_CLAMP_LO_F < ENG_COOLANT_MIN && COOLANT_CLAMP_HI_F > ENG_COOLANT_MAX,
+              "a clamped (shorted/open) coolant sender must fail the range check");
+
+#define ENG_RATE_RELOCK    3        // agreeing rate rejects before accepting a new level
+#define ENG_RATE_GAP_US    1000000UL  // link gap (µs) after which rate checks restart
+
+// VSS vs GPS: flag when |vss - gps| > tol + frac × gps above min speed
+#define ENG_VSS_GPS_MIN_MPH  10.0f
+#define ENG_VSS_GPS_TOL_MPH  8.0f
+#define ENG_VSS_GPS_TOL_FRAC 0.35f
+
+struct EngineValidator {
+  float    last[ENG_CH_COUNT];    // last accepted value
+  float    cand[ENG_CH_COUNT];    // relock candidate: the latest rate reject
+  uint8_t  miss[ENG_CH_COUNT];    // packets since last[], up to ENG_RATE_RELOCK
+  uint8_t  agree[ENG_CH_COUNT];   // rejects in a row that matched cand[]
+  uint8_t  has;                   // bit per channel: last[] is valid
+  uint8_t  hasCand;               // bit per channel: cand[] is valid
+  bool     primed;
+  uint32_t lastUs;
+
+  // Counters ('i' command)
+  uint32_t packets;
+  uint32_t rangeRejects;
+  uint32_t rateRejects;
+  uint32_t crossRejects;
+};
+
+struct EngineLimit {
+  float lo, hi, rate;
+};
+
+// Check the engine channels of d after a packet decoded at nowUs.
+// Only the channels in mask (EQ_* bits) are checked and updated in
+// d.engQual — one validator per ISP2 chain, masked to the channels that
+// chain writes. Returns this packet's verdict.
+template <class Data>
+uint8_t engineValidate(EngineValidator &v, Data &d, uint32_t nowUs, uint8_t mask = EQ_ALL) {
+  static const EngineLimit limits[ENG_CH_COUNT] = {
+    { ENG_AFR_MIN,     ENG_AFR_MAX,     ENG_AFR_RATE },
+    { ENG_AFR_MIN,     ENG_AFR_MAX,     ENG_AFR_RATE },
+    { ENG_VSS_MIN,     ENG_VSS_MAX,     ENG_VSS_RATE },
+    { ENG_MAP_MIN,     ENG_MAP_MAX,     ENG_MAP_RATE },
+    { ENG_OILP_MIN,    ENG_OILP_MAX,    ENG_OILP_RATE },
+    { ENG_COOLANT_MIN, ENG_COOLANT_MAX, ENG_COOLANT_RATE },
+    { ENG_EGT_MIN,     ENG_EGT_MAX,     ENG_EGT_RATE },
+    { ENG_FUELP_MIN,   ENG_FUELP_MAX,   ENG_FUELP_RATE },
+  };
+  const float values[ENG_CH_COUNT] = {
+    d.afr, d.afr1, d.vss, d.map, d.oilp, d.coolant, d.egt, d.fuelp
+  };
+
+  uint32_t dtUs = nowUs - v.lastUs;
+  bool rateOk = v.primed && dtUs < ENG_RATE_GAP_US;
+  float dt = dtUs * 1e-6f;
+  uint8_t q = 0;
+
+  // AFR without lambda status is "no reading", not a bad one (Lc1Status)
+  uint8_t noAfr = ((d.afrStat != LC1_LAMBDA ? EQ_AFR : 0) |
+                   (d.afr1Stat != LC1_LAMBDA ? EQ_AFR1 : 0)) & mask;
+  v.has &= ~noAfr;
+  v.hasCand &= ~noAfr;
+  uint8_t skip = noAfr | (uint8_t)~mask;
+
+  for (uint8_t ch = 0; ch < ENG_CH_COUNT; ch++) {
+    uint8_t bit = 1 << ch;
+    if (skip & bit) continue;
+    float x = values[ch];
+    const EngineLimit &lim = limits[ch];
+
+    bool bad = false;
+    if (!(x >= lim.lo && x <= lim.hi)) {          // also catches NaN
+      bad = true;
+      v.hasCand &= ~bit;
+      v.rangeRejects++;
+    } else if (rateOk && (v.has & bit) &&
+               fabsf(x - v.last[ch]) > lim.rate * dt * (v.miss[ch] + 1)) {
+      // Relock only on a level that holds: each reject within one
+      // packet's rate limit of the previous one
+      if ((v.hasCand & bit) && fabsf(x - v.cand[ch]) <= lim.rate * dt) {
+        v.agree[ch]++;
+      } else {
+        v.agree[ch] = 0;
+        v.hasCand |= bit;
+      }
+      v.cand[ch] = x;
+      if (v.agree[ch] < ENG_RATE_RELOCK) {
+        bad = true;
+        v.rateRejects++;
+      }
+    }
+
+    if (bad) {
+      q |= bit;
+      // The allowed change grows with the time since last[], but only
+      // for a few packets: past that a new level has to relock
+      if (v.miss[ch] < ENG_RATE_RELOCK) v.miss[ch]++;
+    } else {
+      v.last[ch] = x;
+      v.miss[ch] = 0;
+      v.agree[ch] = 0;
+      v.has |= bit;
+      v.hasCand &= ~bit;
+    }
+  }
+
+  if ((mask & EQ_VSS) && !(q & EQ_VSS) && !d.gpsStale && d.speed > ENG_VSS_GPS_MIN_MPH &&
+      fabsf(d.vss - d.speed) > ENG_VSS_GPS_TOL_MPH + d.speed * ENG_VSS_GPS_TOL_FRAC) {
+    q |= EQ_VSS;
+    v.crossRejects++;
+  }
+
+  v.lastUs = nowUs;
+  v.primed = true;
+  v.packets++;
+  d.engQual = (d.engQual & ~mask) | q;
+  return q;
+}
+
+#endif // AB_ENGINE_VALIDATE_H
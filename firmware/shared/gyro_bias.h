@@ -0,0 +1,152 @@
+/**
+ *  Analog Bridge — Online Gyro Bias Estimator
+ *
+ *  Tracks the gyro zero-rate offset for the whole session instead of
+ *  measuring it once at boot. MPU9250 bias moves with die temperature,
+ *  so the estimate is a per-axis line in imuTemp:
+ *    bias(T) = offset + slope × (T − GB_TEMP_REF)
+ *
+ *  Zero-velocity updates: every GB_WINDOW consecutive samples with the
+ *  car stopped (caller's verdict: VSS, GPS speed) and low accel and
+ *  gyro variance give one observation, the window's mean raw rate at
+ *  its mean temperature. Observations go into exponentially forgotten
+ *  least-squares sums (GB_FORGET per window); the slope fit is ridge
+ *  regularized toward zero so a session at one temperature only moves
+ *  the offset.
+ *
+ *  GyroBiasModel is the part worth keeping across power cycles (a few
+ *  floats, ESP32 NVS); everything else rebuilds in one window.
+ *
+ *  Constant time per sample, no allocation. ESP32 only: the Mega still
+ *  measures its gyro offset once at boot. No Arduino headers, so it also
+ *  builds on a host.
+ */
+#ifndef AB_GYRO_BIAS_H
+#define AB_GYRO_BIAS_H
+
+#include <stdint.h>
+#include <string.h>
+
+//----------------------------------------------------------------
+// Tuning
+//----------------------------------------------------------------
+#define GB_WINDOW          64       // samples per still window (~5 s at 12.5 Hz)
+#define GB_STOP_MPH        0.5f     // VSS (and GPS speed, with a fix) below this = stopped
+#define GB_ACC_VAR         0.0004f  // g² per axis: 0.02 g rms, idle shake passes, rolling doesn't
+#define GB_GYRO_VAR        0.25f    // dps² per axis: 0.5 dps rms
+#define GB_FORGET          0.98f    // per accepted window; ~50 windows of memory
+#define GB_TEMP_REF        35.0f    // °C, model reference (typical cabin die temperature)
+#define GB_SLOPE_RIDGE     20.0f    // °C²·windows pulling the slope toward 0
+#define GB_SLOPE_MAX       0.3f     // dps/°C clamp (datasheet ZRO drift is ±0.24)
+
+// Decayed sums over accepted windows; temperatures relative to GB_TEMP_REF
+struct GyroBiasModel {
+  float w;           // Σ weight
+  float t, tt;       // Σ ΔT, Σ ΔT²
+  float b[3];        // Σ bias
+  float tb[3];       // Σ ΔT × bias
+};
+
+struct GyroBiasTracker {
+  GyroBiasModel model;
+  float offset[3];   // dps at GB_TEMP_REF
+  float slope[3];    // dps/°C
+  float last[3];     // last accepted window's mean rate (dps)
+
+  // Current window
+  uint16_t n;
+  float sum[6], sq[6];   // gyro dps, then accel g
+  float sumT;
+
+  // Counters ('C' command)
+  uint32_t windows;      // accepted
+  uint32_t rejects;      // full windows with too much motion
+};
+
+// Bias for the model's sums, written to t.offset/slope
+inline void gyroBiasFit(GyroBiasTracker &t) {
+  const GyroBiasModel &m = t.model;
+  for (uint8_t i = 0; i < 3; i++) {
+    if (m.w <= 0.0f) {
+      t.offset[i] = 0.0f;
+      t.slope[i] = 0.0f;
+      continue;
+    }
+    // Centered: Σ(ΔT − mean)(b − mean) and Σ(ΔT − mean)²
+    float cov = m.tb[i] - m.t * m.b[i] / m.w;
+    float var = m.tt - m.t * m.t / m.w;
+    float s = cov / (var + GB_SLOPE_RIDGE);
+    if (s > GB_SLOPE_MAX) s = GB_SLOPE_MAX;
+    if (s < -GB_SLOPE_MAX) s = -GB_SLOPE_MAX;
+    t.slope[i] = s;
+    t.offset[i] = (m.b[i] - s * m.t) / m.w;
+  }
+}
+
+inline void gyroBiasWindowReset(GyroBiasTracker &t) {
+  t.n = 0;
+  t.sumT = 0.0f;
+  for (uint8_t i = 0; i < 6; i++) t.sum[i] = t.sq[i] = 0.0f;
+}
+
+// Start from a saved model, or from nothing (bias 0 until the first
+// still window) when saved is null
+inline void gyroBiasInit(GyroBiasTracker &t, const GyroBiasModel *saved) {
+  memset(&t, 0, sizeof(t));
+  if (saved) t.model = *saved;
+  gyroBiasFit(t);
+}
+
+// Bias (dps, chip axes) at die temperature tempC
+inline void gyroBiasAt(const GyroBiasTracker &t, float tempC, float bias[3]) {
+  float dT = tempC - GB_TEMP_REF;
+  for (uint8_t i = 0; i < 3; i++) bias[i] = t.offset[i] + t.slope[i] * dT;
+}
+
+// One IMU sample: raw gyro (dps, before bias), accel (g), die
+// temperature, and whether the car is stopped. Returns true when the
+// sample completed a still window and the model moved.
+inline bool gyroBiasFeed(GyroBiasTracker &t, const float gyro[3], const float acc[3],
+                         float tempC, bool stopped) {
+  if (!stopped) {
+    gyroBiasWindowReset(t);
+    return false;
+  }
+  for (uint8_t i = 0; i < 6; i++) {
+    float v = i < 3 ? gyro[i] : acc[i - 3];
+    t.sum[i] += v;
+    t.sq[i] += v * v;
+  }
+  t.sumT += tempC;
+  if (++t.n < GB_WINDOW) return false;
+
+  // Engine shake or someone leaning on the car: discard the window
+  const float inv = 1.0f / GB_WINDOW;
+  for (uint8_t i = 0; i < 6; i++) {
+    float mean = t.sum[i] * inv;
+    float var = t.sq[i] * inv - mean * mean;
+    if (var > (i < 3 ? GB_GYRO_VAR : GB_ACC_VAR)) {
+      t.rejects++;
+      gyroBiasWindowReset(t);
+      return false;
+    }
+  }
+
+  GyroBiasModel &m = t.model;
+  float dT = t.sumT * inv - GB_TEMP_REF;
+  m.w  = m.w  * GB_FORGET + 1.0f;
+  m.t  = m.t  * GB_FORGET + dT;
+  m.tt = m.tt * GB_FORGET + dT * dT;
+  for (uint8_t i = 0; i < 3; i++) {
+    float b = t.sum[i] * inv;
+    t.last[i] = b;
+    m.b[i]  = m.b[i]  * GB_FORGET + b;
+    m.tb[i] = m.tb[i] * GB_FORGET + dT * b;
+  }
+  gyroBiasFit(t);
+  t.windows++;
+  gyroBiasWindowReset(t);
+  return true;
+}
+
+#endif // AB_GYRO_BIAS_H
@@ -0,0 +1,75 @@
+/**
+ *  Analog Bridge — Raw ISP2 Capture Format
+ *
+ *  Side file (.isp, next to the CSV) holding every byte read from the
+ *  ISP2 UART, so odd packets can be replayed through isp2_parser.h on
+ *  a host and old sessions re-converted with new calibration curves.
+ *
+ *  Layout (little-endian):
+ *    header   16 bytes, Isp2CaptureHeader
+ *    records  varint dtUs | varint n | n raw bytes
+ *
+ *  One record per UART read: dtUs is the time since the previous record
+ *  (the first is relative to startUs), and every byte in a record
+ *  carries that read's timestamp — the same time the parser saw. A
+ *  record with n = 0 marks bytes lost by the capture itself (buffer
+ *  full); the replay resyncs there.
+ *
+ *  Overhead is 2-3 bytes per read, so even a saturated 19200 baud link
+ *  stays near 2 KB/s; a typical chain (18-byte packets every 82 ms)
+ *  is ~250 B/s.
+ */
+#ifndef AB_ISP2_CAPTURE_H
+#define AB_ISP2_CAPTURE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define ISP2_CAP_MAGIC     "ISP2"
+#define ISP2_CAP_VERSION   1
+#define ISP2_CAP_MAX_REC   10     // two varints, excluding payload
+
+struct Isp2CaptureHeader {
+  char     magic[4];     // "ISP2"
+  uint8_t  version;
+  uint8_t  reserved[3];
+  uint32_t baud;
+  uint32_t startUs;      // micros() when the capture opened
+};
+
+static_assert(sizeof(Isp2CaptureHeader) == 16, "capture header layout");
+
+inline void isp2CapHeaderInit(Isp2CaptureHeader &h, uint32_t baud, uint32_t startUs) {
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, ISP2_CAP_MAGIC, 4);
+  h.version = ISP2_CAP_VERSION;
+  h.baud = baud;
+  h.startUs = startUs;
+}
+
+inline bool isp2CapHeaderValid(const Isp2CaptureHeader &h) {
+  return memcmp(h.magic, ISP2_CAP_MAGIC, 4) == 0 && h.version == ISP2_CAP_VERSION;
+}
+
+// LEB128: 7 bits per byte, high bit set on all but the last
+inline uint8_t isp2CapPutVarint(uint8_t *out, uint32_t v) {
+  uint8_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+// Returns bytes consumed, 0 if truncated or malformed
+inline uint8_t isp2CapGetVarint(const uint8_t *in, size_t avail, uint32_t &v) {
+  v = 0;
+  for (uint8_t n = 0; n < 5 && n < avail; n++) {
+    v |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+    if (!(in[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+#endif // AB_ISP2_CAPTURE_H
@@ -2,17 +2,22 @@
  *  Analog Bridge — ISP2 Protocol Definitions
  *
  *  Innovate Motorsports ISP2 serial protocol constants and
- *  voltage-to-unit conversion macros. Platform-agnostic.
+ *  aux channel calibration curves. Platform-agnostic.
  *
  *  Daisy-chain order (as wired on the 1969 Nova):
  *    SSI-4 #1: ch0=coolant, ch1=oilp
  *    LC-1  #1: wideband AFR bank 1
  *    LC-1  #2: wideband AFR bank 2
  *    SSI-4 #2: ch2=MAP, ch3=VSS
+ *
+ *  Optional second chain (ESP32, separate UART):
+ *    SSI-4 #3: ch0=EGT, ch1=fuel pressure
  */
 #ifndef AB_ISP2_DEFS_H
 #define AB_ISP2_DEFS_H
 
+#include <stdint.h>
+
 //----------------------------------------------------------------
 // ISP2 Protocol Constants
 //----------------------------------------------------------------
@@ -24,18 +29,91 @@
 #define ISP2_TIMEOUT_MS    200    // Resync if payload stalls this long
 
 //----------------------------------------------------------------
-// Aux channel voltage-to-unit conversions
+// LC-1 status
+// The LC-1 header word carries a 3-bit function code that says what
+// the following 13-bit word holds. Stored as function + 1 so a zeroed
+// SensorData reads as "no data" rather than "lambda".
+//----------------------------------------------------------------
+enum Lc1Status : uint8_t {
+  LC1_NONE = 0,       // no LC-1 packet decoded for this bank
+  LC1_LAMBDA,         // normal: word = lambda (AFR valid)
+  LC1_O2,             // free-air O2 level, word = 0.1 %
+  LC1_FREE_AIR_CAL,   // free-air calibration in progress
+  LC1_NEED_CAL,       // free-air calibration required
+  LC1_WARMUP,         // heater warm-up, word = 0.1 % of operating temp
+  LC1_HEATER_CAL,     // heater calibration, word = countdown
+  LC1_ERROR,          // sensor/heater fault, word = error code
+  LC1_RESERVED
+};
+
+inline uint8_t lc1StatusFromFunc(uint8_t func) {
+  return (uint8_t)((func & 0x07) + LC1_LAMBDA);
+}
+
+inline const char* lc1StatusName(uint8_t status) {
+  switch (status) {
+    case LC1_LAMBDA:       return "lambda";
+    case LC1_O2:           return "O2";
+    case LC1_FREE_AIR_CAL: return "cal";
+    case LC1_NEED_CAL:     return "need cal";
+    case LC1_WARMUP:       return "warmup";
+    case LC1_HEATER_CAL:   return "heater cal";
+    case LC1_ERROR:        return "error";
+    case LC1_RESERVED:     return "reserved";
+    default:               return "--";
+  }
+}
+
+//----------------------------------------------------------------
+// Aux channel calibration curves
+// Evaluated at build time into 10-bit lookup tables (aux_calibration.h);
+// convert with calLookup<AuxCoolantCurve>(raw) etc.
 // Tune for your specific sensors
 //----------------------------------------------------------------
+#include "aux_calibration.h"
 
-// Coolant temp: placeholder linear (TODO: Steinhart-Hart for thermistor)
-#define AUX_COOLANT_F(v)   ((v) * 100.0f)
+// Plain input voltage (unmapped or diagnostic channels)
+struct AuxVoltsCurve {
+  static constexpr float at(uint16_t raw) {
+    return calVolts(raw);
+  }
+};
+
+// Coolant temp: GM-style NTC sender to ground, external pull-up to 5V.
+// Steinhart-Hart fit through 0°C/9420Ω, 40°C/1459Ω, 100°C/177Ω
+// (within 0.6°C of the GM table from -40°C to 120°C).
+// Clamped just outside the plausible range: a shorted sender (raw 0)
+// would otherwise read ~770°F, past what the binary log stores
+// (I16 ×100), and the CSV and .bin would disagree. The ends still fail
+// the ENG_COOLANT_MIN/MAX range check.
+#define COOLANT_PULLUP_OHM 2490.0
+#define COOLANT_SH_A       1.459853e-3
+#define COOLANT_SH_B       2.334242e-4
+#define COOLANT_SH_C       8.505461e-8
+#define COOLANT_CLAMP_LO_F -60.0
+#define COOLANT_CLAMP_HI_F 320.0
+
+struct AuxCoolantCurve {
+  static constexpr float at(uint16_t raw) {
+    return calClamp(calSteinhartF(calThermistorOhms(calVolts(raw), COOLANT_PULLUP_OHM),
+                                  COOLANT_SH_A, COOLANT_SH_B, COOLANT_SH_C),
+                    COOLANT_CLAMP_LO_F, COOLANT_CLAMP_HI_F);
+  }
+};
 
 // Oil pressure: 0.5-4.5V = 0-100 PSI linear sender
-#define AUX_OILP_PSI(v)    (((v) - 0.5f) * 25.0f)
+struct AuxOilpCurve {
+  static constexpr float at(uint16_t raw) {
+    return calLinear(calVolts(raw), 25.0, -12.5);
+  }
+};
 
 // MAP: 1-bar sensor (0-5V = -14.7 to +14.7 inHg)
-#define AUX_MAP_INHG(v)    ((v) * 5.858f - 14.696f)
+struct AuxMapCurve {
+  static constexpr float at(uint16_t raw) {
+    return calLinear(calVolts(raw), 5.858, -14.696);
+  }
+};
 
 //----------------------------------------------------------------
 // VSS (Vehicle Speed Sensor) calibration
@@ -44,8 +122,29 @@
 //   VSS @ 100 mph: 1271 Hz → 12.71 Hz per MPH
 // SSI-4 frequency mode: 0-5V maps linearly to 0..SSI4_VSS_FREQ_MAX Hz
 //----------------------------------------------------------------
-#define SSI4_VSS_FREQ_MAX  1500.0f  // Hz — SSI-4 configured max
-#define VSS_HZ_PER_MPH     12.71f   // Hz per MPH for this drivetrain
-#define AUX_VSS_MPH(v)     (((v) / 5.0f * SSI4_VSS_FREQ_MAX) / VSS_HZ_PER_MPH)
+#define SSI4_VSS_FREQ_MAX  1500.0   // Hz — SSI-4 configured max
+#define VSS_HZ_PER_MPH     12.71    // Hz per MPH for this drivetrain
+
+struct AuxVssCurve {
+  static constexpr float at(uint16_t raw) {
+    return calLinear(calVolts(raw) / CAL_VREF * SSI4_VSS_FREQ_MAX, 1.0 / VSS_HZ_PER_MPH, 0.0);
+  }
+};
+
+// EGT: K-type thermocouple amplifier, 5 mV/°C from 0°C (0-5V = 0-1000°C)
+#define EGT_MV_PER_C       5.0
+
+struct AuxEgtCurve {
+  static constexpr float at(uint16_t raw) {
+    return calLinear(calVolts(raw), 1000.0 / EGT_MV_PER_C * 1.8, 32.0);
+  }
+};
+
+// Fuel pressure: 0.5-4.5V = 0-100 PSI linear sender
+struct AuxFuelpCurve {
+  static constexpr float at(uint16_t raw) {
+    return calLinear(calVolts(raw), 25.0, -12.5);
+  }
+};
 
 #endif // AB_ISP2_DEFS_H
@@ -0,0 +1,270 @@
+/**
+ *  Analog Bridge — ISP2 Packet Parser
+ *
+ *  The one ISP2 framing state machine and packet decoder, header-only
+ *  and free of UART, Arduino and global state, shared by the AVR
+ *  sketch, the ESP32 firmware and the host tools (tools/host/).
+ *
+ *  Bytes arrive as contiguous spans: sync hunting scans the span,
+ *  payload bytes are copied in one block, and each packet is walked
+ *  once. Time is passed in by the caller (µs, wrapping uint32_t) once
+ *  per span, so a raw capture (isp2_capture.h) replayed span by span
+ *  with its recorded timestamps takes exactly the decisions the device
+ *  took.
+ *
+ *    ISP2Parser parser = {};
+ *    parser.poll(source, micros(), sink);     // or tick() + feed(span)
+ *
+ *  Source: size_t read(uint8_t *buf, size_t max) — bytes already
+ *  received, never blocks; 0 when drained.
+ *
+ *  Sink, called per packet with words in chain position order:
+ *    void lc1(uint8_t idx, uint8_t status, float afr, uint16_t detail);
+ *    void aux(uint8_t idx, uint16_t raw);
+ *    void done(const ISP2Parser &p, ISP2Layout layout);
+ *
+ *  ISP2StaticSink builds a sink from a compile-time channel map;
+ *  ISP2NovaSink is the map for the chain documented in isp2_defs.h.
+ *  Derive from either to hook done().
+ */
+#ifndef AB_ISP2_PARSER_H
+#define AB_ISP2_PARSER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "isp2_defs.h"
+#include "isp2_stats.h"
+
+#ifndef ISP2_READ_CHUNK
+  #define ISP2_READ_CHUNK  32     // bytes per source read in poll()
+#endif
+
+enum ISP2State : uint8_t { ISP2_SYNC_HIGH, ISP2_SYNC_LOW, ISP2_READING_PAYLOAD };
+
+struct ISP2Layout {
+  uint8_t lc1Count;
+  uint8_t auxCount;
+};
+
+struct ISP2Parser {
+  uint8_t   state;
+  uint8_t   header[2];
+  uint8_t   data[ISP2_MAX_WORDS * 2];
+  uint8_t   packetLen;          // words
+  bool      isData;
+  uint8_t   bytesRead;
+  uint8_t   bytesExpected;
+  uint32_t  lastByteUs;
+  ISP2Stats stats;
+
+  // Resync if stuck mid-payload. Call before each span.
+  void tick(uint32_t nowUs) {
+    if (state == ISP2_READING_PAYLOAD &&
+        nowUs - lastByteUs > ISP2_TIMEOUT_MS * 1000UL) {
+      state = ISP2_SYNC_HIGH;
+      stats.timeouts++;
+    }
+  }
+
+  // Drain a source: tick once, then feed everything it has
+  template <class Source, class Sink>
+  uint32_t poll(Source &src, uint32_t nowUs, Sink &sink) {
+    tick(nowUs);
+    uint8_t buf[ISP2_READ_CHUNK];
+    uint32_t total = 0;
+    size_t n;
+    while ((n = src.read(buf, sizeof(buf))) > 0) {
+      feed(buf, n, nowUs, sink);
+      total += n;
+    }
+    return total;
+  }
+
+  // Parse one span of bytes received at nowUs
+  template <class Sink>
+  void feed(const uint8_t *p, size_t n, uint32_t nowUs, Sink &sink) {
+    if (n == 0) return;
+    const uint8_t *end = p + n;
+    lastByteUs = nowUs;
+    stats.bytes += n;
+
+    while (p < end) {
+      switch (state) {
+        case ISP2_SYNC_HIGH: {
+          const uint8_t *start = p;
+          while (p < end && (*p & ISP2_H_SYNC_MASK) != ISP2_H_SYNC_MASK) p++;
+          stats.discarded += p - start;
+          if (p == end) return;
+          header[0] = *p++;
+          state = ISP2_SYNC_LOW;
+          break;
+        }
+
+        case ISP2_SYNC_LOW: {
+          uint8_t b = *p++;
+          if ((b & ISP2_L_SYNC_MASK) == ISP2_L_SYNC_MASK) {
+            header[1] = b;
+            isData = (header[0] >> 4) & 0x01;
+            uint8_t len = ((header[0] & 0x01) << 7) | (header[1] & 0x7F);
+            if (len > 0 && len <= ISP2_MAX_WORDS) {
+              packetLen = len;
+              bytesExpected = len * 2;
+              bytesRead = 0;
+              state = ISP2_READING_PAYLOAD;
+            } else {
+              state = ISP2_SYNC_HIGH;
+              stats.badLengths++;
+            }
+          } else if ((b & ISP2_H_SYNC_MASK) == ISP2_H_SYNC_MASK) {
+            header[0] = b;
+            stats.discarded++;  // previous high byte
+            // stay in SYNC_LOW — treat as new high sync
+          } else {
+            state = ISP2_SYNC_HIGH;
+            stats.syncLosses++;
+            stats.discarded += 2;
+          }
+          break;
+        }
+
+        default: {
+          size_t take = bytesExpected - bytesRead;
+          if (take > (size_t)(end - p)) take = end - p;
+          memcpy(data + bytesRead, p, take);
+          p += take;
+          bytesRead += take;
+          if (bytesRead < bytesExpected) return;
+
+          state = ISP2_SYNC_HIGH;
+          if (isData) {
+            isp2StatsPacket(stats, nowUs);
+            sink.done(*this, decode(sink));
+          } else {
+            stats.otherPackets++;
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  // Walk the current packet. LC-1 sub-packets are 2 words (header +
+  // lambda), aux sub-packets 1 word (10-bit value).
+  template <class Sink>
+  ISP2Layout decode(Sink &sink) const {
+    ISP2Layout layout = {0, 0};
+    uint8_t w = 0;
+    while (w < packetLen) {
+      uint8_t hi = data[w * 2];
+      uint8_t lo = data[w * 2 + 1];
+
+      if (hi & ISP2_LC1_FLAG) {
+        // LC-1 header word: func(bits 12-10), afrMult(bits 8,6-0)
+        uint8_t  func    = (hi >> 2) & 0x07;
+        uint16_t afrMult = ((hi & 0x01) << 7) | (lo & 0x7F);
+
+        // Next word is lambda (or the status detail, see Lc1Status)
+        w++;
+        if (w >= packetLen) break;
+        hi = data[w * 2];
+        lo = data[w * 2 + 1];
+        uint16_t lambda = ((hi & 0x3F) << 7) | (lo & 0x7F);
+
+        uint8_t status = lc1StatusFromFunc(func);
+        if (status == LC1_LAMBDA) {
+          // Integer product (< 2^24, so exact in float): one soft-float
+          // op on AVR instead of two, same result bit for bit
+          uint32_t afrX10k = (uint32_t)(lambda + 500) * afrMult;
+          sink.lc1(layout.lc1Count, status, (float)afrX10k / 10000.0f, 0);
+        } else {
+          sink.lc1(layout.lc1Count, status, 0.0f, lambda);
+        }
+        layout.lc1Count++;
+      } else {
+        sink.aux(layout.auxCount, ((hi & 0x07) << 7) | (lo & 0x7F));
+        layout.auxCount++;
+      }
+      w++;
+    }
+    return layout;
+  }
+};
+
+//----------------------------------------------------------------
+// Compile-time channel map
+// Each chain position names a destination field (and for aux words a
+// calibration curve); dispatch by position unrolls to a compare chain
+// with the table loads inlined. Positions past the list are ignored.
+//
+//   typedef ISP2StaticSink<Data,
+//     ISP2Slots<ISP2Lc1<Data, &Data::afr, &Data::afrStat, &Data::afrDetail> >,
+//     ISP2Slots<ISP2Aux<Data, &Data::oilp, AuxOilpCurve>, ISP2Skip> > Sink;
+//----------------------------------------------------------------
+template <class Data, float Data::*Field, class Curve>
+struct ISP2Aux {
+  static void store(Data &d, uint16_t raw) {
+    d.*Field = calLookup<Curve>(raw);
+  }
+};
+
+template <class Data, float Data::*Afr, uint8_t Data::*Status, uint16_t Data::*Detail>
+struct ISP2Lc1 {
+  static void store(Data &d, uint8_t status, float afr, uint16_t detail) {
+    d.*Afr = afr;
+    d.*Status = status;
+    d.*Detail = detail;
+  }
+};
+
+// Unused chain position
+struct ISP2Skip {
+  template <class Data>
+  static void store(Data &, uint16_t) {}
+  template <class Data>
+  static void store(Data &, uint8_t, float, uint16_t) {}
+};
+
+template <class... Slots>
+struct ISP2Slots;
+
+template <>
+struct ISP2Slots<> {
+  template <class Data, class... Args>
+  static void store(uint8_t, Data &, Args...) {}
+};
+
+template <class First, class... Rest>
+struct ISP2Slots<First, Rest...> {
+  template <class Data, class... Args>
+  static void store(uint8_t idx, Data &d, Args... args) {
+    if (idx == 0) First::store(d, args...);
+    else ISP2Slots<Rest...>::store(idx - 1, d, args...);
+  }
+};
+
+template <class Data, class Lc1Slots, class AuxSlots>
+struct ISP2StaticSink {
+  Data &data;
+
+  explicit ISP2StaticSink(Data &d) : data(d) {}
+
+  void lc1(uint8_t idx, uint8_t status, float afr, uint16_t detail) {
+    Lc1Slots::store(idx, data, status, afr, detail);
+  }
+  void aux(uint8_t idx, uint16_t raw) {
+    AuxSlots::store(idx, data, raw);
+  }
+  void done(const ISP2Parser &, ISP2Layout) {}
+};
+
+// Nova chain: SSI-4 #1 (coolant, oilp), LC-1 ×2, SSI-4 #2 (MAP, VSS)
+template <class Data>
+using ISP2NovaSink = ISP2StaticSink<Data,
+  ISP2Slots<ISP2Lc1<Data, &Data::afr,  &Data::afrStat,  &Data::afrDetail>,
+            ISP2Lc1<Data, &Data::afr1, &Data::afr1Stat, &Data::afr1Detail> >,
+  ISP2Slots<ISP2Aux<Data, &Data::coolant, AuxCoolantCurve>,
+            ISP2Aux<Data, &Data::oilp,    AuxOilpCurve>,
+            ISP2Aux<Data, &Data::map,     AuxMapCurve>,
+            ISP2Aux<Data, &Data::vss,     AuxVssCurve> > >;
+
+#endif // AB_ISP2_PARSER_H
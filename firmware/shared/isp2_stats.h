@@ -0,0 +1,74 @@
+/**
+ *  Analog Bridge — ISP2 Link-Quality Statistics
+ *
+ *  Packet accounting for the ISP2 parser, shared by both targets:
+ *  what was decoded, and every way the framing can lose data (sync
+ *  hunting, bad header lengths, stalled payloads, UART overflow).
+ *
+ *  The chain emits one packet every ISP2_FRAME_US, so gaps between
+ *  consecutive data packets reveal lost frames even when framing never
+ *  visibly breaks (e.g. a UART buffer overflow dropping a whole packet).
+ *  A gap of ISP2_OUTAGE_US or more is the chain being off, unplugged or
+ *  silent, not lost frames: it counts as one outage and the next packet
+ *  starts a new interval, so a reconnect leaves the capture rate alone.
+ *
+ *  Single writer (the ISP2 reader); 32-bit fields may be read from
+ *  elsewhere for display.
+ */
+#ifndef AB_ISP2_STATS_H
+#define AB_ISP2_STATS_H
+
+#include <stdint.h>
+
+#define ISP2_FRAME_US      81920UL  // ISP2 chain packet period (81.92 ms)
+#define ISP2_OUTAGE_US     500000UL // longer gap = outage (the ESP32's ISP2_STALE_MS)
+
+struct ISP2Stats {
+  uint32_t bytes;          // bytes read from the UART
+  uint32_t packets;        // data packets decoded
+  uint32_t otherPackets;   // non-data packets (e.g. LM Programmer traffic)
+  uint32_t discarded;      // bytes skipped while hunting for a header
+  uint32_t syncLosses;     // header high byte not followed by a low byte
+  uint32_t timeouts;       // payload stalled past ISP2_TIMEOUT_MS
+  uint32_t badLengths;     // header length 0 or > ISP2_MAX_WORDS
+  uint32_t overflows;      // UART receive buffer overflows (if reported)
+  uint32_t missedFrames;   // frames implied by gaps between data packets
+  uint32_t outages;        // gaps of ISP2_OUTAGE_US or more (not in missedFrames)
+
+  // Interval between consecutive data packets (µs)
+  uint32_t lastPacketUs;
+  uint32_t intervalMinUs;
+  uint32_t intervalMaxUs;
+  uint32_t intervalCount;
+  uint64_t intervalSumUs;
+};
+
+// Record a decoded data packet at time nowUs (micros()).
+inline void isp2StatsPacket(ISP2Stats &s, uint32_t nowUs) {
+  uint32_t iv = nowUs - s.lastPacketUs;
+  if (s.packets > 0 && iv >= ISP2_OUTAGE_US) {
+    s.outages++;
+  } else if (s.packets > 0) {
+    if (s.intervalCount == 0 || iv < s.intervalMinUs) s.intervalMinUs = iv;
+    if (iv > s.intervalMaxUs) s.intervalMaxUs = iv;
+    s.intervalSumUs += iv;
+    s.intervalCount++;
+    if (iv > ISP2_FRAME_US + ISP2_FRAME_US / 2) {
+      s.missedFrames += (iv + ISP2_FRAME_US / 2) / ISP2_FRAME_US - 1;
+    }
+  }
+  s.lastPacketUs = nowUs;
+  s.packets++;
+}
+
+inline uint32_t isp2StatsMeanUs(const ISP2Stats &s) {
+  return s.intervalCount ? (uint32_t)(s.intervalSumUs / s.intervalCount) : 0;
+}
+
+// Fraction of expected frames actually decoded, in percent
+inline float isp2StatsCapturePct(const ISP2Stats &s) {
+  uint32_t expected = s.packets + s.missedFrames;
+  return expected ? 100.0f * (float)s.packets / (float)expected : 0.0f;
+}
+
+#endif // AB_ISP2_STATS_H
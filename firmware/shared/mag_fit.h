@@ -0,0 +1,303 @@
+/**
+ *  Analog Bridge — Streaming Magnetometer Ellipsoid Fit
+ *
+ *  Raw magnetometer readings taken while tumbling the sensor lie on an
+ *  ellipsoid: shifted by hard iron, stretched and tilted by soft iron
+ *  (the steel body around the board). Min/max per axis only finds the
+ *  shift and an axis-aligned stretch; this fits the full quadric
+ *    a x² + b y² + c z² + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+ *  by least squares and turns it into
+ *    corrected = soft × (raw − bias)
+ *  with bias the ellipsoid centre and soft the symmetric matrix that maps
+ *  it onto a sphere of the same mean radius (so the output stays in uT).
+ *
+ *  Streaming: magFitAdd() folds each sample into the normal-equation sums
+ *  (upper triangle of DᵀD and Dᵀ1, doubles), so memory is constant however
+ *  long the tumble runs. magFitSolve() does the 9×9 solve and a 3×3 Jacobi
+ *  eigen decomposition once at the end, twice over: the sums can be
+ *  shifted to any point exactly, so the second fit runs about the
+ *  centre the first one found.
+ *
+ *  Fit quality, from the same sums (no samples kept):
+ *    - spread: the residual Σ(dᵀp − 1)² = pᵀ(DᵀD)p − 2pᵀ(Dᵀ1) + n. Near
+ *      the surface a sample's dᵀp − 1 is twice its relative error in
+ *      corrected field magnitude (times the quadric's constant), so this
+ *      gives the rms spread of |corrected| over the tumble.
+ *    - cover: the samples' spread along their thinnest direction, after
+ *      correction, against a full tumble's (R / √3 on every axis). A
+ *      tumble that stayed mostly in one plane fits its own samples well
+ *      but guesses the third axis; only this catches it.
+ *
+ *  ESP32 only. The Mega keeps its per-axis magScale, and avr-gcc's
+ *  double is 32-bit, too short for these sums. No Arduino headers: a
+ *  host program can fit recorded tumbles with it.
+ */
+#ifndef AB_MAG_FIT_H
+#define AB_MAG_FIT_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define MAG_FIT_MIN_SAMPLES  50       // fewer cannot pin down 9 parameters
+#define MAG_FIT_MAX_RATIO    2.5f     // longest / shortest ellipsoid axis accepted
+#define MAG_FIT_MAX_SPREAD   0.05f    // rms |corrected| spread accepted, fraction of R
+#define MAG_FIT_MIN_COVER    0.3f     // thinnest-axis coverage accepted (hemisphere: 0.5)
+
+struct MagFit {
+  double ata[45];    // DᵀD, upper triangle row by row
+  double atb[9];     // Dᵀ1
+  uint32_t n;
+};
+
+enum MagFitResult : uint8_t {
+  MAG_FIT_OK,
+  MAG_FIT_FEW,       // under MAG_FIT_MIN_SAMPLES
+  MAG_FIT_SINGULAR,  // samples do not span 3D (not rotated enough)
+  MAG_FIT_SHAPE,     // not an ellipsoid, or stretched past MAG_FIT_MAX_RATIO
+  MAG_FIT_SPREAD,    // samples off the ellipsoid past MAG_FIT_MAX_SPREAD
+  MAG_FIT_FLAT,      // tumble covered less than MAG_FIT_MIN_COVER on some axis
+};
+
+struct MagFitQuality {
+  float radius;      // uT, fitted field
+  float spread;      // rms |corrected| error over the samples, fraction of radius
+  float cover;       // 0 (one plane) .. 1 (full tumble)
+};
+
+inline void magFitReset(MagFit &f) {
+  memset(&f, 0, sizeof(f));
+}
+
+inline void magFitAdd(MagFit &f, const float m[3]) {
+  double x = m[0], y = m[1], z = m[2];
+  double d[9] = { x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z };
+  uint8_t k = 0;
+  for (uint8_t i = 0; i < 9; i++) {
+    f.atb[i] += d[i];
+    for (uint8_t j = i; j < 9; j++) f.ata[k++] += d[i] * d[j];
+  }
+  f.n++;
+}
+
+// Symmetric 3×3 eigen decomposition (cyclic Jacobi): a = v diag(e) vᵀ,
+// eigenvectors in v's columns
+inline void magFitEigen3(double a[3][3], double e[3], double v[3][3]) {
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++) v[i][j] = i == j ? 1.0 : 0.0;
+
+  for (uint8_t sweep = 0; sweep < 30; sweep++) {
+    double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+    if (off < 1e-15 * (fabs(a[0][0]) + fabs(a[1][1]) + fabs(a[2][2]))) break;
+    for (uint8_t p = 0; p < 2; p++) {
+      for (uint8_t q = p + 1; q < 3; q++) {
+        if (a[p][q] == 0.0) continue;
+        double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+        double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+        double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+        for (uint8_t k = 0; k < 3; k++) {     // a ← a·J
+          double akp = a[k][p], akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (uint8_t k = 0; k < 3; k++) {     // a ← Jᵀ·a
+          double apk = a[p][k], aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (uint8_t k = 0; k < 3; k++) {     // v ← v·J
+          double vkp = v[k][p], vkq = v[k][q];
+          v[k][p] = c * vkp - s * vkq;
+          v[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+  for (uint8_t i = 0; i < 3; i++) e[i] = a[i][i];
+}
+
+// Entry (i, j) of the Gram matrix of [d; 1] (i, j = 9: the constant):
+// DᵀD, Dᵀ1 and n from the sums
+inline double magFitGram(const MagFit &f, uint8_t i, uint8_t j) {
+  if (i > j) { uint8_t t = i; i = j; j = t; }
+  if (j == 9) return i == 9 ? (double)f.n : f.atb[i];
+  return f.ata[9 * i - i * (i - 1) / 2 + (j - i)];
+}
+
+// Row i of the map from [d; 1] to [d; 1] of the samples minus c: every
+// term of d is a polynomial of degree ≤ 2, so the shift is linear in d
+inline uint8_t magFitShiftRow(const double c[3], uint8_t i, uint8_t col[4], double w[4]) {
+  static const uint8_t sq[3][2] = { { 0, 6 }, { 1, 7 }, { 2, 8 } };       // x², 2x
+  static const uint8_t xy[3][4] = { { 3, 0, 1 }, { 4, 0, 2 }, { 5, 1, 2 } };  // 2xy: x, y
+  col[0] = i;
+  w[0] = 1.0;
+  if (i < 3) {             // (x − a)² = x² − a·2x + a²
+    col[1] = sq[i][1]; w[1] = -c[i];
+    col[2] = 9;        w[2] = c[i] * c[i];
+    return 3;
+  }
+  if (i < 6) {             // 2(x − a)(y − b) = 2xy − b·2x − a·2y + 2ab
+    uint8_t a = xy[i - 3][1], b = xy[i - 3][2];
+    col[1] = 6 + a; w[1] = -c[b];
+    col[2] = 6 + b; w[2] = -c[a];
+    col[3] = 9;     w[3] = 2.0 * c[a] * c[b];
+    return 4;
+  }
+  if (i < 9) {             // 2(x − a) = 2x − 2a
+    col[1] = 9; w[1] = -2.0 * c[i - 6];
+    return 2;
+  }
+  return 1;
+}
+
+// Gram entry (i, j) as if every sample had been added minus c
+inline double magFitGramAt(const MagFit &f, const double c[3], uint8_t i, uint8_t j) {
+  uint8_t ci[4], cj[4];
+  double wi[4], wj[4];
+  uint8_t ni = magFitShiftRow(c, i, ci, wi);
+  uint8_t nj = magFitShiftRow(c, j, cj, wj);
+  double g = 0.0;
+  for (uint8_t a = 0; a < ni; a++)
+    for (uint8_t b = 0; b < nj; b++) g += wi[a] * wj[b] * magFitGram(f, ci[a], cj[b]);
+  return g;
+}
+
+// Least-squares quadric about c: normal equations DᵀD p = Dᵀ1, Gaussian
+// elimination with partial pivoting. False if the samples do not span 3D.
+inline bool magFitQuadric(const MagFit &f, const double c[3], double p[9]) {
+  double m[9][10];
+  for (uint8_t i = 0; i < 9; i++) {
+    for (uint8_t j = i; j < 9; j++) m[i][j] = m[j][i] = magFitGramAt(f, c, i, j);
+    m[i][9] = magFitGramAt(f, c, i, 9);
+  }
+  double scale = 0.0;
+  for (uint8_t i = 0; i < 9; i++) scale = fmax(scale, fabs(m[i][i]));
+  for (uint8_t col = 0; col < 9; col++) {
+    uint8_t piv = col;
+    for (uint8_t r = col + 1; r < 9; r++) {
+      if (fabs(m[r][col]) > fabs(m[piv][col])) piv = r;
+    }
+    if (fabs(m[piv][col]) <= 1e-13 * scale) return false;
+    if (piv != col) {
+      for (uint8_t j = col; j < 10; j++) {
+        double t = m[col][j]; m[col][j] = m[piv][j]; m[piv][j] = t;
+      }
+    }
+    for (uint8_t r = col + 1; r < 9; r++) {
+      double fct = m[r][col] / m[col][col];
+      for (uint8_t j = col; j < 10; j++) m[r][j] -= fct * m[col][j];
+    }
+  }
+  for (int8_t i = 8; i >= 0; i--) {
+    double s = m[i][9];
+    for (uint8_t j = i + 1; j < 9; j++) s -= m[i][j] * p[j];
+    p[i] = s / m[i][i];
+  }
+  return true;
+}
+
+// Quadric xᵀAx + 2vᵀx = 1; centre c = −A⁻¹v. False if A is singular.
+inline bool magFitCentre(const double p[9], double c[3]) {
+  double A[3][3] = { { p[0], p[3], p[4] },
+                     { p[3], p[1], p[5] },
+                     { p[4], p[5], p[2] } };
+  const double *v = p + 6;
+  double det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+             - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+             + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+  if (det == 0.0) return false;
+  double inv[3][3] = {
+    { A[1][1] * A[2][2] - A[1][2] * A[2][1], A[0][2] * A[2][1] - A[0][1] * A[2][2], A[0][1] * A[1][2] - A[0][2] * A[1][1] },
+    { A[1][2] * A[2][0] - A[1][0] * A[2][2], A[0][0] * A[2][2] - A[0][2] * A[2][0], A[0][2] * A[1][0] - A[0][0] * A[1][2] },
+    { A[1][0] * A[2][1] - A[1][1] * A[2][0], A[0][1] * A[2][0] - A[0][0] * A[2][1], A[0][0] * A[1][1] - A[0][1] * A[1][0] },
+  };
+  for (uint8_t i = 0; i < 3; i++) {
+    c[i] = -(inv[i][0] * v[0] + inv[i][1] * v[1] + inv[i][2] * v[2]) / det;
+  }
+  return true;
+}
+
+// Fit the accumulated samples. On MAG_FIT_OK writes the hard-iron bias
+// (uT) and the soft-iron matrix (row-major, unitless); otherwise leaves
+// them alone. q gets the fit quality as far as it got (zero before), so
+// MAG_FIT_SPREAD and MAG_FIT_FLAT can say by how much.
+inline MagFitResult magFitSolve(const MagFit &f, float bias[3], float soft[3][3], MagFitQuality *q) {
+  MagFitQuality tmp;
+  if (!q) q = &tmp;
+  memset(q, 0, sizeof(*q));
+  if (f.n < MAG_FIT_MIN_SAMPLES) return MAG_FIT_FEW;
+
+  // Fit once about the origin, then again about the centre found. The
+  // "= 1" form weighs samples by their distance from the origin, so a
+  // fit made far off centre (the hard-iron shift) bends with the noise.
+  double o[3] = { 0.0, 0.0, 0.0 }, p[9], c[3];
+  if (!magFitQuadric(f, o, p)) return MAG_FIT_SINGULAR;
+  if (!magFitCentre(p, o)) return MAG_FIT_SHAPE;
+  if (!magFitQuadric(f, o, p)) return MAG_FIT_SINGULAR;
+  if (!magFitCentre(p, c)) return MAG_FIT_SHAPE;
+
+  // About the centre: yᵀAy = 1 − vᵀc, so M = A / (1 − vᵀc) has yᵀMy = 1
+  double kq = 1.0 - (p[6] * c[0] + p[7] * c[1] + p[8] * c[2]);
+  if (kq == 0.0) return MAG_FIT_SHAPE;
+  double M[3][3] = { { p[0], p[3], p[4] },
+                     { p[3], p[1], p[5] },
+                     { p[4], p[5], p[2] } };
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++) M[i][j] /= kq;
+
+  double e[3], V[3][3];
+  magFitEigen3(M, e, V);
+  double eMin = fmin(e[0], fmin(e[1], e[2]));
+  double eMax = fmax(e[0], fmax(e[1], e[2]));
+  if (!(eMin > 0.0)) return MAG_FIT_SHAPE;
+  if (sqrt(eMax / eMin) > MAG_FIT_MAX_RATIO) return MAG_FIT_SHAPE;
+
+  // soft = R·M^½ with R the geometric mean radius: the ellipsoid maps
+  // onto a sphere of radius R
+  double R = pow(e[0] * e[1] * e[2], -1.0 / 6.0);
+  double s[3] = { sqrt(e[0]) * R, sqrt(e[1]) * R, sqrt(e[2]) * R };
+  double S[3][3];
+  for (uint8_t i = 0; i < 3; i++) {
+    for (uint8_t j = 0; j < 3; j++) {
+      S[i][j] = V[i][0] * s[0] * V[j][0] + V[i][1] * s[1] * V[j][1] + V[i][2] * s[2] * V[j][2];
+    }
+  }
+  q->radius = (float)R;
+
+  // Σ(dᵀp − 1)² = pᵀ(DᵀD)p − 2pᵀ(Dᵀ1) + n, about o like the fit, and
+  // dᵀp − 1 = kq (|corrected|² / R² − 1) ≈ 2 kq × relative error
+  double ssr = (double)f.n;
+  for (uint8_t i = 0; i < 9; i++) {
+    ssr -= 2.0 * p[i] * magFitGramAt(f, o, i, 9);
+    for (uint8_t j = 0; j < 9; j++) ssr += p[i] * magFitGramAt(f, o, i, j) * p[j];
+  }
+  q->spread = (float)(sqrt(fmax(ssr, 0.0) / f.n) / (2.0 * fabs(kq)));
+
+  // Sample covariance (Dᵀ1 holds Σx², Σy², Σz², 2Σxy, 2Σxz, 2Σyz, 2Σx,
+  // 2Σy, 2Σz), taken through soft: R² / 3 on every axis for a full tumble
+  double mean[3] = { f.atb[6] / (2.0 * f.n), f.atb[7] / (2.0 * f.n), f.atb[8] / (2.0 * f.n) };
+  double cov[3][3] = { { f.atb[0], f.atb[3] / 2, f.atb[4] / 2 },
+                       { f.atb[3] / 2, f.atb[1], f.atb[5] / 2 },
+                       { f.atb[4] / 2, f.atb[5] / 2, f.atb[2] } };
+  double sc[3][3];
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++) cov[i][j] = cov[i][j] / f.n - mean[i] * mean[j];
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++)
+      sc[i][j] = S[i][0] * cov[0][j] + S[i][1] * cov[1][j] + S[i][2] * cov[2][j];
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++)
+      M[i][j] = sc[i][0] * S[j][0] + sc[i][1] * S[j][1] + sc[i][2] * S[j][2];
+  magFitEigen3(M, e, V);
+  q->cover = (float)(sqrt(3.0 * fmax(fmin(e[0], fmin(e[1], e[2])), 0.0)) / R);
+
+  if (!(q->spread <= MAG_FIT_MAX_SPREAD)) return MAG_FIT_SPREAD;
+  if (!(q->cover >= MAG_FIT_MIN_COVER)) return MAG_FIT_FLAT;
+  for (uint8_t i = 0; i < 3; i++) {
+    bias[i] = (float)(o[i] + c[i]);
+    for (uint8_t j = 0; j < 3; j++) soft[i][j] = (float)S[i][j];
+  }
+  return MAG_FIT_OK;
+}
+
+#endif // AB_MAG_FIT_H
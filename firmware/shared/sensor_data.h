@@ -4,38 +4,29 @@
  *  Central data contract used by all platform targets (AVR, ESP32).
  *  Every sensor writer fills this struct; every consumer reads it.
  *
- *  CSV column order matches the struct field order for clarity:
- *    time, lat, lon, speed, alt, dir, sats,
- *    accx/y/z, rotx/y/z, magx/y/z, imuTemp,
- *    afr, afr1, vss, map, oilp, coolant, gpsStale, keyframe
+ *  The logged channels are declared from the schema in channels.h
+ *  (AB_CHANNEL_FIELDS), in CSV column order; units are in the table.
+ *  IMU axes are in car frame after remap: X=fwd, Y=right, Z=down (SAE).
+ *  afr/afr1 are 0 unless the LC-1 reports lambda; afrStat/afr1Stat are
+ *  Lc1Status (isp2_defs.h), engQual the EQ_* bits (engine_validate.h).
+ *
+ *  Engine fields may come from more than one ISP2 chain (ESP32); each
+ *  chain stamps isp2Us[] with the time of the packet it last merged.
  */
 #ifndef AB_SENSOR_DATA_H
 #define AB_SENSOR_DATA_H
 
 #include <stdint.h>
+#include "channels.h"
 
-struct SensorData {
-  // GPS
-  long     lat, lon;            // degE7 (latitude × 1e7) for precision
-  float    speed;               // mph
-  float    alt;                 // ft
-  float    dir;                 // degrees (heading)
-  uint8_t  satellites;          // satellite count
-  bool     gpsStale;            // true if no fix for > GPS_STALE_MS
+#define ISP2_MAX_CHAINS  2      // isp2Us[] slots; ESP32 ISP2_CHAINS must fit
 
-  // IMU — accelerometer, gyroscope, magnetometer, temperature
-  // Axes are in car frame after remap: X=fwd, Y=right, Z=down (SAE)
-  float accx, accy, accz;      // g
-  float rotx, roty, rotz;      // dps (degrees per second)
-  float magx, magy, magz;      // uT (microtesla)
-  float imuTemp;                // °C (MPU9250 die temperature)
+struct SensorData {
+  AB_CHANNEL_FIELDS
 
-  // ISP2 / Engine
-  float afr, afr1;             // air-fuel ratio (bank 1 and 2)
-  float vss;                   // vehicle speed (mph) from reluctor
-  float map;                   // manifold vacuum/boost (inHgVac)
-  float oilp;                  // oil pressure (psig)
-  float coolant;               // coolant temperature (°F)
+  // Not logged
+  uint16_t afrDetail, afr1Detail; // LC-1 word when not lambda (O2, warm-up, error)
+  uint32_t isp2Us[ISP2_MAX_CHAINS]; // per-chain micros() of the last merged packet
 };
 
 #endif // AB_SENSOR_DATA_H
@@ -0,0 +1,138 @@
+/**
+ *  Analog Bridge — Packed Sensor Frame
+ *
+ *  Fixed-point copy of one SensorData sample, the payload of a binary
+ *  log record (binlog.h), which is its only user. The ESP32 history
+ *  ring keeps its own delta-coded channels, and live snapshots stay
+ *  SensorData.
+ *  One field per channel in channels.h, in column order, sized by the
+ *  row's store, about half of either target's SensorData (the
+ *  static_assert below pins the size). Packed, so the layout is the same
+ *  on AVR, ESP32 and host (little-endian).
+ *
+ *  Each F field is kept at the precision the CSV prints it, quantized
+ *  with the same steps Print::print(float) takes, so
+ *    sensorFrameEncode → sensorFrameDecode → CSV
+ *  prints what the CSV would have shown for the original values.
+ *  Out-of-range values saturate; SF_NAN marks a NaN in I16 fields.
+ *
+ *  Not carried: afrDetail/afr1Detail (not logged) and isp2Us (per-run
+ *  link bookkeeping).
+ */
+#ifndef AB_SENSOR_FRAME_H
+#define AB_SENSOR_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "channels.h"
+
+#define SF_NAN  (-32768)
+
+#define SF_FIELD_NONE(m)
+#define SF_FIELD_I32(m)  int32_t m;
+#define SF_FIELD_I16(m)  int16_t m;
+#define SF_FIELD_U16(m)  uint16_t m;
+#define SF_FIELD_U8(m)   uint8_t m;
+#define SF_FIELD(name, unit, m, type, store, dg, group, json)  SF_FIELD_##store(m)
+
+struct __attribute__((packed)) SensorFrame {
+  AB_CHANNELS(SF_FIELD, )
+};
+
+// Bytes per store: the frame is exactly its fields, nothing in between
+#define SF_SIZE_NONE  0
+#define SF_SIZE_I32   4
+#define SF_SIZE_I16   2
+#define SF_SIZE_U16   2
+#define SF_SIZE_U8    1
+#define SF_SIZE(name, unit, m, type, store, dg, group, json)  SF_SIZE_##store
+
+static_assert(sizeof(SensorFrame) == AB_CHANNELS(SF_SIZE, +), "SensorFrame layout");
+
+// Value × 10^decimals as the integer Print::print(x, decimals) shows:
+// same rounding term, same digit-by-digit float steps. Saturates to
+// [lo, hi] in magnitude; NaN returns nan.
+inline int32_t sensorFrameQ(float x, uint8_t decimals, int32_t lo, int32_t hi, int32_t nan) {
+  static const float rounding[4] = {
+    0.5f, 0.5f / 10.0f, 0.5f / 10.0f / 10.0f, 0.5f / 10.0f / 10.0f / 10.0f
+  };
+  static const int32_t pow10[4] = { 1, 10, 100, 1000 };
+  if (x != x) return nan;
+  bool neg = x < 0.0f;
+  if (neg) x = -x;
+  x += rounding[decimals];
+  int32_t limit = neg ? -lo : hi;
+  if (!(x < (float)(limit / pow10[decimals] + 1))) return neg ? lo : hi;
+
+  uint32_t ip = (uint32_t)x;
+  float rem = x - (float)ip;
+  int32_t v = ip;
+  for (uint8_t i = 0; i < decimals; i++) {
+    rem *= 10.0f;
+    uint8_t d = (uint8_t)rem;
+    rem -= d;
+    v = v * 10 + d;
+  }
+  if (v > limit) v = limit;
+  return neg ? -v : v;
+}
+
+inline int16_t sensorFrameQ16(float x, uint8_t decimals) {
+  return (int16_t)sensorFrameQ(x, decimals, SF_NAN + 1, 32767, SF_NAN);
+}
+
+inline uint16_t sensorFrameQU16(float x, uint8_t decimals) {
+  return (uint16_t)sensorFrameQ(x, decimals, 0, 65535, 0);
+}
+
+inline int32_t sensorFrameQ32(float x, uint8_t decimals) {
+  return sensorFrameQ(x, decimals, -2000000000L, 2000000000L, 0);
+}
+
+inline float sensorFrameF16(int16_t v, float scale) {
+  return v == SF_NAN ? NAN : (float)v / scale;
+}
+
+// F channels: quantize / scale back by store
+#define SF_QUANT_I32  sensorFrameQ32
+#define SF_QUANT_I16  sensorFrameQ16
+#define SF_QUANT_U16  sensorFrameQU16
+#define SF_FLOAT_I32(v, scale)  ((float)(v) / (scale))
+#define SF_FLOAT_I16(v, scale)  sensorFrameF16(v, scale)
+#define SF_FLOAT_U16(v, scale)  ((float)(v) / (scale))
+#define SF_SCALE_0  1.0f
+#define SF_SCALE_1  10.0f
+#define SF_SCALE_2  100.0f
+#define SF_SCALE_3  1000.0f
+
+// Per value type; everything but F is copied as is
+#define SF_ENCODE_TIME(m, store, dg)
+#define SF_ENCODE_KEY(m, store, dg)
+#define SF_ENCODE_DEG(m, store, dg)   f.m = d.m;
+#define SF_ENCODE_F(m, store, dg)     f.m = SF_QUANT_##store(d.m, dg);
+#define SF_ENCODE_U8(m, store, dg)    f.m = d.m;
+#define SF_ENCODE_BOOL(m, store, dg)  f.m = d.m;
+#define SF_ENCODE(name, unit, m, type, store, dg, group, json)  SF_ENCODE_##type(m, store, dg)
+
+#define SF_DECODE_TIME(m, store, dg)
+#define SF_DECODE_KEY(m, store, dg)
+#define SF_DECODE_DEG(m, store, dg)   d.m = f.m;
+#define SF_DECODE_F(m, store, dg)     d.m = SF_FLOAT_##store(f.m, SF_SCALE_##dg);
+#define SF_DECODE_U8(m, store, dg)    d.m = f.m;
+#define SF_DECODE_BOOL(m, store, dg)  d.m = f.m != 0;
+#define SF_DECODE(name, unit, m, type, store, dg, group, json)  SF_DECODE_##type(m, store, dg)
+
+// Pack a sample (either target's SensorData: same field names)
+template <class Data>
+void sensorFrameEncode(SensorFrame &f, const Data &d) {
+  AB_CHANNELS(SF_ENCODE, )
+}
+
+// Unpack into SensorData; fields the frame does not carry are left alone
+template <class Data>
+void sensorFrameDecode(Data &d, const SensorFrame &f) {
+  AB_CHANNELS(SF_DECODE, )
+}
+
+#endif // AB_SENSOR_FRAME_H
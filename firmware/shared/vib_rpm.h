@@ -0,0 +1,211 @@
+/**
+ *  Analog Bridge — Engine RPM from Chassis Vibration
+ *
+ *  The ISP2 chains carry no tach signal, but a running engine shakes the
+ *  car at its firing frequency: cylinders/2 pulses per crank revolution
+ *  (a V8 at 3000 rpm is 100 Hz), with harmonics. The IMU's accel FIFO at
+ *  VR_FS sees up to ~480 Hz, i.e. 7200 rpm on a V8.
+ *
+ *  Windows of VR_N samples run through a bank of Goertzel filters on a
+ *  fixed frequency grid (half a DFT bin apart, Hann window), summed over
+ *  the three axes so the board's mounting doesn't matter. Per window:
+ *    - the strongest band of ±VR_BAND bins at or above VR_RPM_MIN. Band
+ *      power, not bin power: during a fast rev the firing peak smears
+ *      over many bins and would lose to its sharper half order.
+ *    - or the strongest near the last estimate, while that is within
+ *      VR_TRACK_KEEP of it (a harmonic that briefly wins does not make
+ *      the estimate jump an octave)
+ *    - refined to the sharpest bin in the band, then between bins by a
+ *      parabola through the log powers
+ *    - confidence from the band's height over the median band (noise
+ *      floor): 0 below VR_SNR_MIN_DB, 100 at VR_SNR_FULL_DB. With 0 the
+ *      engine is off or drowned out, and rpm reads 0.
+ *
+ *  Streaming: vibRpmAdd() advances every filter by one sample, so there
+ *  is no sample buffer and the work is spread over the window. The bank
+ *  is kept as flat arrays per axis so the inner loop is one contiguous,
+ *  branch-free pass the compiler unrolls.
+ *
+ *  Constant time per sample, no allocation (~11 KB state); host-buildable.
+ *  Too big for the Mega.
+ */
+#ifndef AB_VIB_RPM_H
+#define AB_VIB_RPM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+//----------------------------------------------------------------
+// Tuning
+//----------------------------------------------------------------
+#define VR_FS           1000.0f  // Hz, accel sample rate fed to vibRpmAdd()
+#define VR_N            256      // samples per window: 256 ms, updates ~4 Hz
+#define VR_F_MIN        20.0f    // Hz, lowest (600 rpm on a four, 300 on a V8)
+#define VR_F_MAX        480.0f   // Hz, highest, under the 500 Hz Nyquist (7200 rpm)
+#define VR_BIN_HZ       (VR_FS / (2 * VR_N))  // grid step, half a DFT bin (1.95 Hz)
+#define VR_BINS         ((int)((VR_F_MAX - VR_F_MIN) / VR_BIN_HZ) + 1)  // 236
+#define VR_RPM_MIN      500.0f   // below any idle: lower peaks are other orders
+#define VR_BAND         3        // peak power summed over ± this many bins
+#define VR_SNR_MIN_DB   6.0f     // band power over its median: below this no estimate
+#define VR_SNR_FULL_DB  15.0f    // ...and 100 % confidence at this
+#define VR_TRACK_HZ     40.0f    // search this far around the last peak
+#define VR_TRACK_KEEP   0.5f     // local peak ≥ this × global peak keeps the track
+
+struct VibRpm {
+  float coeff[VR_BINS];           // 2 cos(2π f / VR_FS)
+  float win[VR_N];                // Hann
+  float s1[3][VR_BINS];           // Goertzel state per axis
+  float s2[3][VR_BINS];
+  float power[VR_BINS];           // last window, summed over axes
+  float band[VR_BINS];            // power summed over ±VR_BAND bins
+  float scratch[VR_BINS];         // median
+  float dc[3], sum[3];            // window mean, removed from the next one
+  uint16_t n;                     // samples in the current window
+  float order;                    // firing pulses per crank revolution
+  uint16_t kMin;                  // first bin at or above VR_RPM_MIN
+
+  // Result of the last window
+  float hz;                       // firing frequency, 0 = none
+  float rpm;                      // 0 when conf is 0
+  uint8_t conf;                   // 0-100 %
+  uint32_t windows;
+};
+
+inline void vibRpmRestart(VibRpm &t) {
+  memset(t.s1, 0, sizeof(t.s1));
+  memset(t.s2, 0, sizeof(t.s2));
+  t.sum[0] = t.sum[1] = t.sum[2] = 0.0f;
+  t.n = 0;
+}
+
+// cylinders: of a four-stroke engine, fires cylinders/2 times per turn
+inline void vibRpmInit(VibRpm &t, uint8_t cylinders) {
+  memset(&t, 0, sizeof(t));
+  t.order = cylinders * 0.5f;
+  float k0 = ceilf((VR_RPM_MIN * t.order / 60.0f - VR_F_MIN) / VR_BIN_HZ);
+  t.kMin = k0 > 0.0f ? (uint16_t)k0 : 0;
+  for (uint16_t k = 0; k < VR_BINS; k++) {
+    t.coeff[k] = 2.0f * cosf(2.0f * (float)M_PI * (VR_F_MIN + k * VR_BIN_HZ) / VR_FS);
+  }
+  for (uint16_t i = 0; i < VR_N; i++) {
+    t.win[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / VR_N);
+  }
+}
+
+// Median of the first n values (reorders them): quickselect
+inline float vibRpmMedian(float *a, uint16_t n) {
+  int16_t lo = 0, hi = n - 1, mid = n / 2;
+  while (lo < hi) {
+    float x, pivot = a[mid];
+    a[mid] = a[hi]; a[hi] = pivot;
+    int16_t s = lo;
+    for (int16_t i = lo; i < hi; i++) {
+      if (a[i] < pivot) { x = a[i]; a[i] = a[s]; a[s++] = x; }
+    }
+    a[hi] = a[s]; a[s] = pivot;
+    if (s == mid) break;
+    if (s < mid) lo = s + 1;
+    else hi = s - 1;
+  }
+  return a[mid];
+}
+
+// Pick the firing peak out of t.power and set hz, rpm, conf
+inline void vibRpmPeak(VibRpm &t) {
+  // Power within ±VR_BAND bins: a peak smeared by fast revs counts in
+  // full against a narrow one (its half order) instead of losing to it
+  float *e = t.band;
+  float run = 0.0f;
+  for (int16_t i = 0; i < VR_BAND && i < VR_BINS; i++) run += t.power[i];
+  for (int16_t i = 0; i < VR_BINS; i++) {
+    if (i + VR_BAND < VR_BINS) run += t.power[i + VR_BAND];
+    if (i - VR_BAND - 1 >= 0) run -= t.power[i - VR_BAND - 1];
+    e[i] = run;
+  }
+
+  uint16_t k = t.kMin;
+  for (uint16_t i = t.kMin + 1; i < VR_BINS; i++) {
+    if (e[i] > e[k]) k = i;
+  }
+
+  // Stay on the tracked order while it is still a real peak
+  if (t.hz > 0.0f) {
+    float c = (t.hz - VR_F_MIN) / VR_BIN_HZ;
+    int16_t lo = (int16_t)(c - VR_TRACK_HZ / VR_BIN_HZ);
+    int16_t hi = (int16_t)(c + VR_TRACK_HZ / VR_BIN_HZ + 1.0f);
+    if (lo < (int16_t)t.kMin + 1) lo = t.kMin + 1;
+    if (hi > VR_BINS - 2) hi = VR_BINS - 2;
+    int16_t kl = -1;
+    for (int16_t i = lo; i <= hi; i++) {
+      if (e[i] >= e[i - 1] && e[i] >= e[i + 1] && (kl < 0 || e[i] > e[kl])) kl = i;
+    }
+    if (kl >= 0 && e[kl] >= VR_TRACK_KEEP * e[k]) k = (uint16_t)kl;
+  }
+
+  memcpy(t.scratch, e, sizeof(t.scratch));
+  float noise = vibRpmMedian(t.scratch, VR_BINS);
+  float db = (noise > 0.0f && e[k] > 0.0f) ? 10.0f * log10f(e[k] / noise) : 0.0f;
+  float q = (db - VR_SNR_MIN_DB) / (VR_SNR_FULL_DB - VR_SNR_MIN_DB);
+  // Rising into the bottom of the range: a lower order, not a peak
+  if (k > 0 && e[k - 1] > e[k]) q = 0.0f;
+  if (q <= 0.0f) {
+    t.hz = 0.0f;
+    t.rpm = 0.0f;
+    t.conf = 0;
+    return;
+  }
+  if (q > 1.0f) q = 1.0f;
+
+  // Sharpest bin of the band, then between bins: vertex of the parabola
+  // through the log powers
+  const float *p = t.power;
+  int16_t lo = k > VR_BAND ? k - VR_BAND : 0;
+  int16_t hi = k + VR_BAND < VR_BINS - 1 ? k + VR_BAND : VR_BINS - 1;
+  for (int16_t i = lo; i <= hi; i++) {
+    if (p[i] > p[k]) k = i;
+  }
+  float d = 0.0f;
+  if (k > 0 && k < VR_BINS - 1 && p[k - 1] > 0.0f && p[k + 1] > 0.0f) {
+    float a = logf(p[k - 1]), b = logf(p[k]), c = logf(p[k + 1]);
+    float den = a - 2.0f * b + c;
+    if (den < 0.0f) d = 0.5f * (a - c) / den;
+  }
+  t.hz = VR_F_MIN + (k + d) * VR_BIN_HZ;
+  t.rpm = t.hz * 60.0f / t.order;
+  t.conf = (uint8_t)(q * 100.0f + 0.5f);
+}
+
+// One accel sample (g, any frame). Returns true when it completed a
+// window and hz/rpm/conf are new.
+inline bool vibRpmAdd(VibRpm &t, const float acc[3]) {
+  const float w = t.win[t.n];
+  for (uint8_t a = 0; a < 3; a++) {
+    const float x = (acc[a] - t.dc[a]) * w;
+    const float *c = t.coeff;
+    float *s1 = t.s1[a], *s2 = t.s2[a];
+    for (uint16_t k = 0; k < VR_BINS; k++) {
+      float s0 = x + c[k] * s1[k] - s2[k];
+      s2[k] = s1[k];
+      s1[k] = s0;
+    }
+    t.sum[a] += acc[a];
+  }
+  if (++t.n < VR_N) return false;
+
+  for (uint16_t k = 0; k < VR_BINS; k++) {
+    float pw = 0.0f;
+    for (uint8_t a = 0; a < 3; a++) {
+      float x1 = t.s1[a][k], x2 = t.s2[a][k];
+      pw += x1 * x1 + x2 * x2 - t.coeff[k] * x1 * x2;
+    }
+    t.power[k] = pw;
+  }
+  for (uint8_t a = 0; a < 3; a++) t.dc[a] = t.sum[a] / VR_N;
+  vibRpmPeak(t);
+  t.windows++;
+  vibRpmRestart(t);
+  return true;
+}
+
+#endif // AB_VIB_RPM_H
@@ -3,6 +3,8 @@
  *
  *  Connects to ws://<host>/ws, receives JSON at 5Hz,
  *  updates all gauge elements and the G-force canvas.
+ *  On connect the firmware first sends one binary frame holding the
+ *  last ~2 minutes of telemetry (web/history.h) to pre-fill the trail.
  *
  *  Falls back to demo mode (simulated Potrero Hill → Portola Valley
  *  route data) when WebSocket connection is unavailable — e.g. when
@@ -33,6 +35,7 @@ const el = {
   vss:      document.getElementById('vss-val'),
   gpsSpd:   document.getElementById('gps-spd-val'),
   map:      document.getElementById('map-val'),
+  rpm:      document.getElementById('rpm-val'),
   // G-force
   gCanvas:  document.getElementById('g-canvas'),
   gLat:     document.getElementById('g-lat'),
@@ -42,6 +45,8 @@ const el = {
   gx: document.getElementById('imu-gx'), gy: document.getElementById('imu-gy'), gz: document.getElementById('imu-gz'),
   mx: document.getElementById('imu-mx'), my: document.getElementById('imu-my'), mz: document.getElementById('imu-mz'),
   tmp: document.getElementById('imu-tmp'),
+  roll: document.getElementById('imu-roll'), pitch: document.getElementById('imu-pitch'),
+  yaw: document.getElementById('imu-yaw'),
   // Recording
   recInfo:  document.getElementById('rec-info'),
   recFile:  document.getElementById('rec-file'),
@@ -52,9 +57,65 @@ const el = {
 
 const gCtx = el.gCanvas.getContext('2d');
 
+//----------------------------------------------------------------
+// Recent telemetry — seeded by the history backfill, then appended
+// by every live frame. Drives the G-force trail.
+//----------------------------------------------------------------
+const HISTORY_MAX = 600;  // 120s at 5Hz, matches HISTORY_SECONDS
+const HIST_CHANNELS = ['ax', 'ay', 'afr', 'afr1', 'spd', 'vss', 'map', 'oil', 'clt'];
+let history = [];
+
+function pushHistory(p) {
+  history.push(p);
+  if (history.length > HISTORY_MAX) history.splice(0, history.length - HISTORY_MAX);
+}
+
+// Decode the binary history frame (layout documented in web/history.h)
+function decodeHistory(buf) {
+  const v = new DataView(buf);
+  if (v.getUint8(0) !== 0x48 || v.getUint8(1) !== 1) return [];  // 'H', v1
+  const nch = v.getUint8(2);
+  const periodMs = v.getUint16(4, true);
+  const nblocks = v.getUint16(6, true);
+  let o = 12;
+  const scale = [];
+  for (let c = 0; c < nch; c++, o += 2) scale.push(v.getUint16(o, true));
+
+  const points = [];
+  const toPoint = (ms, q) => {
+    const p = { t: ms / 1000 };
+    HIST_CHANNELS.forEach((name, c) => { if (c < nch) p[name] = q[c] / scale[c]; });
+    return p;
+  };
+  for (let b = 0; b < nblocks; b++) {
+    const startMs = v.getUint32(o, true);
+    const frames = v.getUint8(o + 4);
+    o += 5;
+    const q = [];
+    for (let c = 0; c < nch; c++, o += 2) q.push(v.getInt16(o, true));
+    points.push(toPoint(startMs, q));
+    for (let f = 1; f < frames; f++) {
+      for (let c = 0; c < nch; c++, o++) q[c] += v.getInt8(o);
+      points.push(toPoint(startMs + f * periodMs, q));
+    }
+  }
+  return points;
+}
+
 //----------------------------------------------------------------
 // AFR color coding
 //----------------------------------------------------------------
+// LC-1 status codes (Lc1Status in isp2_defs.h); anything but lambda
+// means the bank's AFR is not a reading
+const LC1_LAMBDA = 1;
+const LC1_LABELS = ['--', '', 'O2', 'CAL', 'NEED CAL', 'WARM', 'HTR CAL', 'ERR', '--'];
+
+function lc1Label(stat, detail) {
+  if (stat === 5) return 'WARM ' + Math.round(detail / 10) + '%';
+  if (stat === 7) return 'ERR ' + detail;
+  return LC1_LABELS[stat] || '--';
+}
+
 function afrClass(val) {
   if (val <= 0) return 'afr-stoich';
   if (val < 12.0) return 'afr-rich';
@@ -100,6 +161,16 @@ function drawGForce(ax, ay) {
   gCtx.arc(cx, cy, scale, 0, Math.PI * 2);
   gCtx.stroke();
 
+  // Trail — recent history, fading toward the oldest point
+  const n = history.length;
+  for (let i = 1; i < n; i++) {
+    gCtx.strokeStyle = `rgba(79, 195, 247, ${(0.05 + 0.35 * i / n).toFixed(2)})`;
+    gCtx.beginPath();
+    gCtx.moveTo(cx + history[i - 1].ay * scale, cy - history[i - 1].ax * scale);
+    gCtx.lineTo(cx + history[i].ay * scale, cy - history[i].ax * scale);
+    gCtx.stroke();
+  }
+
   // G dot (lateral = right on screen, forward = up on screen)
   const dotX = cx + ay * scale;  // ay = lateral (right positive)
   const dotY = cy - ax * scale;  // ax = forward (up positive)
@@ -124,8 +195,11 @@ function update(d) {
   // AFR — combined average is the big number, banks are smaller
   const afr1 = d.eng.afr;
   const afr2 = d.eng.afr1;
-  const hasAfr1 = afr1 > 0;
-  const hasAfr2 = afr2 > 0;
+  // Older firmware (and demo mode) sends no status: fall back to AFR > 0
+  const st1 = d.eng.afrSt;
+  const st2 = d.eng.afr1St;
+  const hasAfr1 = afr1 > 0 && (st1 === undefined || st1 === LC1_LAMBDA);
+  const hasAfr2 = afr2 > 0 && (st2 === undefined || st2 === LC1_LAMBDA);
   let afrAvg = 0;
   if (hasAfr1 && hasAfr2) afrAvg = (afr1 + afr2) / 2;
   else if (hasAfr1) afrAvg = afr1;
@@ -137,8 +211,8 @@ function update(d) {
   el.afrAvg.textContent = afrNoData ? '--' : afrAvg.toFixed(1);
   el.afrAvg.className = 'gauge-value ' + (afrNoData ? 'warn-oil' : afrClass(afrAvg));
   el.afrCard.classList.toggle('alarm-active', afrAlarm);
-  el.afr1.textContent = hasAfr1 ? afr1.toFixed(1) : '--';
-  el.afr2.textContent = hasAfr2 ? afr2.toFixed(1) : '--';
+  el.afr1.textContent = hasAfr1 ? afr1.toFixed(1) : lc1Label(st1, d.eng.afrDet);
+  el.afr2.textContent = hasAfr2 ? afr2.toFixed(1) : lc1Label(st2, d.eng.afr1Det);
 
   // Oil pressure — alarm if under 5 psi (including 0 = engine off)
   const oilVal = d.eng.oil;
@@ -159,15 +233,26 @@ function update(d) {
   el.gpsSpd.textContent = d.gps.spd > 0 ? d.gps.spd.toFixed(0) : '0';
   el.vss.textContent = d.eng.vss > 0 ? d.eng.vss.toFixed(0) : '0';
   el.map.textContent = d.eng.map !== undefined ? d.eng.map.toFixed(1) : '--';
+  // Vibration RPM: no reading while the firmware has no confident peak
+  el.rpm.textContent = d.eng.rpmQ > 0 ? Math.round(d.eng.rpm) : '--';
 
   // GPS
   el.gpsSats.textContent = d.gps.sat + ' sat' + (d.gps.stale ? '!' : '');
   el.gpsSats.className = d.gps.stale ? 'text-red-400' : 'text-slate-500';
 
-  // G-force
-  drawGForce(d.imu.ax, d.imu.ay);
-  el.gLat.textContent = d.imu.ay.toFixed(2);
-  el.gFwd.textContent = d.imu.ax.toFixed(2);
+  // G-force: gravity-free accel from the attitude filter while it has a
+  // speed to work with (lok), raw accel otherwise or from firmware that
+  // does not send it
+  const hasLin = d.imu.lok !== undefined ? d.imu.lok : d.imu.lx !== undefined;
+  const gFwd = hasLin ? d.imu.lx : d.imu.ax;
+  const gLat = hasLin ? d.imu.ly : d.imu.ay;
+  pushHistory({
+    t: d.t, ax: gFwd, ay: gLat, afr: d.eng.afr, afr1: d.eng.afr1,
+    spd: d.gps.spd, vss: d.eng.vss, map: d.eng.map, oil: d.eng.oil, clt: d.eng.clt,
+  });
+  drawGForce(gFwd, gLat);
+  el.gLat.textContent = gLat.toFixed(2);
+  el.gFwd.textContent = gFwd.toFixed(2);
 
   // IMU detail
   el.ax.textContent = d.imu.ax.toFixed(2);
@@ -180,6 +265,11 @@ function update(d) {
   el.my.textContent = d.imu.my.toFixed(0);
   el.mz.textContent = d.imu.mz.toFixed(0);
   el.tmp.textContent = d.imu.tmp.toFixed(1);
+  if (d.imu.roll !== undefined) {
+    el.roll.textContent = d.imu.roll.toFixed(1);
+    el.pitch.textContent = d.imu.pitch.toFixed(1);
+    el.yaw.textContent = d.imu.yaw.toFixed(0);
+  }
 
   // Recording
   if (d.rec.on) {
@@ -196,21 +286,42 @@ function update(d) {
 }
 
 //----------------------------------------------------------------
-// Serial command buttons — send single-char over WebSocket
+// Command buttons — send {"id","cmd"} over WebSocket; the firmware
+// answers with {"ack":id,"ok":...} once the command has run.
 //----------------------------------------------------------------
+const ACK_TIMEOUT_MS = 1500;
+const pendingCmds = new Map();  // id -> { btn, timer }
+let nextCmdId = 1;
+
+function flashBtn(btn, cls, ms) {
+  btn.classList.add(cls);
+  setTimeout(() => btn.classList.remove(cls), ms);
+}
+
+function handleAck(a) {
+  const p = pendingCmds.get(a.ack);
+  if (!p) return;
+  clearTimeout(p.timer);
+  pendingCmds.delete(a.ack);
+  flashBtn(p.btn, a.ok ? '!bg-sky-900' : '!bg-red-900', a.ok ? 200 : 300);
+}
+
 document.querySelectorAll('.cmd-btn').forEach(btn => {
   btn.addEventListener('click', () => {
-    const cmd = btn.dataset.cmd;
-    if (ws && ws.readyState === WebSocket.OPEN) {
-      ws.send(cmd);
-      // Brief visual feedback
-      btn.classList.add('!bg-sky-900');
-      setTimeout(() => btn.classList.remove('!bg-sky-900'), 200);
-    } else {
+    if (!ws || ws.readyState !== WebSocket.OPEN) {
       // Flash red if not connected
-      btn.classList.add('!bg-red-900');
-      setTimeout(() => btn.classList.remove('!bg-red-900'), 300);
+      flashBtn(btn, '!bg-red-900', 300);
+      return;
     }
+    const id = nextCmdId++;
+    ws.send(JSON.stringify({ id, cmd: btn.dataset.cmd }));
+    pendingCmds.set(id, {
+      btn,
+      timer: setTimeout(() => {
+        pendingCmds.delete(id);
+        flashBtn(btn, '!bg-red-900', 300);
+      }, ACK_TIMEOUT_MS),
+    });
   });
 });
 
@@ -223,6 +334,7 @@ let failCount = 0;
 const DEMO_AFTER_FAILS = 2; // Enter demo after 2 failed WS attempts (~4s)
 
 function enterDemoMode() {
+  history = [];
   el.wsDot.className = 'w-2 h-2 rounded-full bg-amber-500 transition-colors';
   el.wsStatus.textContent = 'Demo Mode';
   startDemo(update);
@@ -237,6 +349,7 @@ function connect() {
 
   const url = `ws://${location.host}/ws`;
   ws = new WebSocket(url);
+  ws.binaryType = 'arraybuffer';
 
   ws.onopen = () => {
     failCount = 0;
@@ -268,9 +381,17 @@ function connect() {
   };
 
   ws.onmessage = (event) => {
+    // Binary frame = history backfill, sent once right after connect
+    if (event.data instanceof ArrayBuffer) {
+      history = decodeHistory(event.data).slice(-HISTORY_MAX);
+      const last = history[history.length - 1];
+      if (last) drawGForce(last.ax, last.ay);
+      return;
+    }
     try {
       const d = JSON.parse(event.data);
-      update(d);
+      if (d.ack !== undefined) handleAck(d);
+      else update(d);
     } catch (e) {
       // Ignore parse errors
     }
@@ -0,0 +1,228 @@
+/**
+ *  Analog Bridge — Attitude Filter Benchmark
+ *
+ *  Runs the shared AHRS (firmware/shared/ahrs.h) over a synthetic drive
+ *  with known attitude and reports per-update cost and accuracy.
+ *
+ *  The drive: random segments of launch, cruise, braking and constant-
+ *  radius corners up to 0.8 g on rolling hills (±6 % grade), with body
+ *  pitch and roll from the suspension (2°/g, 4°/g). Truth is stepped at
+ *  1 kHz; the filter sees it at the firmware's SAMPLE_INTERVAL (80 ms)
+ *  as the IMU would: gyro with noise and a residual bias, accel with
+ *  noise and engine vibration, mag with noise, VSS with pulse jitter at
+ *  the CSV's 0.01 mph.
+ *
+ *  Compared per run: the filter as shipped, without wheel-speed aiding,
+ *  and without the magnetometer. "raw" is accx/accy used as is (what the
+ *  G-G plot showed before), scored against true gravity-free accel.
+ *
+ *  Build:  g++ -std=c++11 -O2 -I../../firmware/shared -o ahrs_bench ahrs_bench.cpp
+ *  Usage:  ./ahrs_bench [minutes]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "ahrs.h"
+
+#define TRUTH_HZ     1000
+#define SAMPLE_MS    80
+#define SUSP_PITCH   2.0      // deg nose down per g of braking
+#define SUSP_ROLL    4.0      // deg per g lateral
+
+// One IMU sample as the firmware sees it, plus the truth at that instant
+struct Sample {
+  float gyro[3], acc[3], mag[3];
+  float speed;                    // m/s, quantized like VSS
+  double roll, pitch, yaw;        // truth, ahrsEuler convention
+  double lin[3];                  // truth, gravity-free accel (g)
+};
+
+static double gauss() {
+  double s = 0.0;
+  for (int i = 0; i < 12; i++) s += rand() / (double)RAND_MAX;
+  return s - 6.0;
+}
+
+// Body → earth rotation from ZYX angles (rad; yaw counterclockwise)
+static void rotation(double roll, double pitch, double yaw, double R[3][3]) {
+  double cr = cos(roll), sr = sin(roll), cp = cos(pitch), sp = sin(pitch);
+  double cy = cos(yaw), sy = sin(yaw);
+  R[0][0] = cy * cp; R[0][1] = cy * sp * sr - sy * cr; R[0][2] = cy * sp * cr + sy * sr;
+  R[1][0] = sy * cp; R[1][1] = sy * sp * sr + cy * cr; R[1][2] = sy * sp * cr - cy * sr;
+  R[2][0] = -sp;     R[2][1] = cp * sr;                R[2][2] = cp * cr;
+}
+
+static std::vector<Sample> makeDrive(double minutes) {
+  std::vector<Sample> out;
+  srand(1969);
+  const double dt = 1.0 / TRUTH_HZ;
+  const double g = AHRS_G;
+  const double earthB[3] = { 20.0, 0.0, -45.0 };  // uT, north + down (z up)
+  const double gyroBias[3] = { 0.05, -0.03, 0.04 };
+
+  double v = 0.0, yaw = 0.3, dist = 0.0;
+  double aLon = 0.0, aLat = 0.0;                  // commanded, m/s²
+  double lonS = 0.0, latS = 0.0;                  // smoothed, m/s²
+  double segLeft = 0.0;
+  double prevR[3][3], prevVel[3] = { 0, 0, 0 };
+  bool first = true;
+  int sampleEvery = TRUTH_HZ * SAMPLE_MS / 1000;
+  long steps = (long)(minutes * 60.0 * TRUTH_HZ);
+
+  for (long i = 0; i < steps; i++) {
+    if (segLeft <= 0.0) {
+      int kind = rand() % 5;
+      segLeft = 3.0 + rand() % 8;
+      double lat = (0.2 + 0.6 * rand() / (double)RAND_MAX) * g * (rand() % 2 ? 1 : -1);
+      if (kind == 0) { aLon = 0.35 * g; aLat = 0.0; }
+      else if (kind == 1) { aLon = -0.7 * g; aLat = 0.0; segLeft = 2.0; }
+      else if (kind == 2) { aLon = 0.0; aLat = lat; }
+      else if (kind == 3) { aLon = -0.3 * g; aLat = lat * 0.5; }
+      else { aLon = 0.0; aLat = 0.0; }
+    }
+    segLeft -= dt;
+    // Smooth the commands so jerk stays finite
+    lonS += (aLon - lonS) * dt / 0.4;
+    latS += (aLat - latS) * dt / 0.4;
+    double lon = lonS, latA = latS;
+    if (v <= 0.5 && lon < 0.0) lon = 0.0;
+    if (v >= 45.0 && lon > 0.0) lon = 0.0;
+    if (v < 3.0) latA = 0.0;
+    v += lon * dt;
+    if (v < 0.0) v = 0.0;
+    double yawRate = v > 0.1 ? latA / v : 0.0;
+    yaw += yawRate * dt;
+    dist += v * dt;
+
+    // Road grade (rad) and body attitude on the suspension
+    double grade = atan(0.06 * sin(dist / 300.0));
+    double pitch = grade - SUSP_PITCH / 57.29578 * (lon / g);   // ZYX: + = nose down
+    double roll = SUSP_ROLL / 57.29578 * (latA / g);
+
+    double R[3][3];
+    rotation(roll, pitch, yaw, R);
+    // Velocity along the road, not the body: suspension pitch is not motion
+    double cg = cos(grade), sg = sin(grade);
+    double vel[3] = { v * cg * cos(yaw), v * cg * sin(yaw), -v * sg };
+    bool emit = !first && i % sampleEvery == 0;
+
+    if (emit) {
+      Sample s;
+      // Body rate from the rotation step: Rᵀ·dR/dt = [ω]×
+      double W[3][3];
+      for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++) {
+          double d = 0.0;
+          for (int k = 0; k < 3; k++) d += prevR[k][r] * (R[k][c] - prevR[k][c]);
+          W[r][c] = d / dt;
+        }
+      double w[3] = { (W[2][1] - W[1][2]) / 2, (W[0][2] - W[2][0]) / 2, (W[1][0] - W[0][1]) / 2 };
+      double aE[3] = { (vel[0] - prevVel[0]) / dt / g, (vel[1] - prevVel[1]) / dt / g,
+                       (vel[2] - prevVel[2]) / dt / g + 1.0 };
+      double aErel[3] = { aE[0], aE[1], aE[2] - 1.0 };
+      double vib = 0.03 * sin(i * 0.37) + 0.02 * gauss();    // engine shake, g
+      for (int k = 0; k < 3; k++) {
+        double f = R[0][k] * aE[0] + R[1][k] * aE[1] + R[2][k] * aE[2];
+        double l = R[0][k] * aErel[0] + R[1][k] * aErel[1] + R[2][k] * aErel[2];
+        double m = R[0][k] * earthB[0] + R[1][k] * earthB[1] + R[2][k] * earthB[2];
+        s.lin[k] = l;
+        s.acc[k] = (float)(f + 0.01 * gauss() + (k == 2 ? vib : vib * 0.3));
+        s.gyro[k] = (float)(w[k] * 57.29578 + gyroBias[k] + 0.1 * gauss());
+        s.mag[k] = (float)(m + 0.5 * gauss());
+      }
+      double mph = v / 0.44704 + (v > 0.5 ? 0.1 * gauss() : 0.0);   // pulse jitter
+      s.speed = (float)(floor(fmax(mph, 0.0) * 100.0 + 0.5) / 100.0 * 0.44704);
+      s.roll = roll * 57.29578;
+      s.pitch = -pitch * 57.29578;
+      s.yaw = fmod(-yaw * 57.29578 + 3600.0, 360.0);
+      out.push_back(s);
+    }
+    first = false;
+    for (int r = 0; r < 3; r++) {
+      prevVel[r] = vel[r];
+      for (int c = 0; c < 3; c++) prevR[r][c] = R[r][c];
+    }
+  }
+  return out;
+}
+
+struct Score {
+  double roll2, pitch2, yaw2, lin2, raw2;
+  double rollMax, pitchMax, yawMax;
+  long n;
+};
+
+static double angleDiff(double a, double b) {
+  double d = fmod(a - b + 540.0, 360.0) - 180.0;
+  return d;
+}
+
+static Score run(const std::vector<Sample> &drive, bool aid, bool useMag) {
+  Ahrs a;
+  ahrsReset(a);
+  Score s = {};
+  const float dt = SAMPLE_MS / 1000.0f;
+  for (size_t i = 0; i < drive.size(); i++) {
+    const Sample &d = drive[i];
+    ahrsUpdate(a, d.gyro, d.acc, useMag ? d.mag : nullptr, d.speed, aid, dt);
+    if (i < 250) continue;     // 20 s to settle a wrong initial heading/tilt
+    float roll, pitch, yaw, lin[3];
+    ahrsEuler(a, roll, pitch, yaw);
+    ahrsLinear(a, d.acc, lin);
+    double er = angleDiff(roll, d.roll), ep = pitch - d.pitch, ey = angleDiff(yaw, d.yaw);
+    s.roll2 += er * er;
+    s.pitch2 += ep * ep;
+    s.yaw2 += ey * ey;
+    s.rollMax = fmax(s.rollMax, fabs(er));
+    s.pitchMax = fmax(s.pitchMax, fabs(ep));
+    s.yawMax = fmax(s.yawMax, fabs(ey));
+    for (int k = 0; k < 2; k++) {
+      double el = lin[k] - d.lin[k];
+      double er2 = d.acc[k] - d.lin[k];
+      s.lin2 += el * el;
+      s.raw2 += er2 * er2;
+    }
+    s.n++;
+  }
+  return s;
+}
+
+static void print(const char *name, const Score &s) {
+  printf("%-12s roll %5.2f (max %5.2f)  pitch %5.2f (max %5.2f)  yaw %6.2f (max %6.2f)  "
+         "lon/lat %.3f g (raw %.3f g)\n", name,
+    sqrt(s.roll2 / s.n), s.rollMax, sqrt(s.pitch2 / s.n), s.pitchMax,
+    sqrt(s.yaw2 / s.n), s.yawMax, sqrt(s.lin2 / (2 * s.n)), sqrt(s.raw2 / (2 * s.n)));
+}
+
+int main(int argc, char** argv) {
+  double minutes = argc > 1 ? atof(argv[1]) : 30.0;
+  std::vector<Sample> drive = makeDrive(minutes);
+  printf("%.0f min drive, %zu samples at %d ms\n", minutes, drive.size(), SAMPLE_MS);
+  printf("RMS error, degrees / g (after 20 s):\n");
+  print("ahrs", run(drive, true, true));
+  print("no VSS aid", run(drive, false, true));
+  print("no mag", run(drive, true, false));
+
+  // Cost per update, mag on: the whole drive, repeated
+  const int reps = 50;
+  Ahrs a;
+  ahrsReset(a);
+  float sink = 0.0f;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++) {
+    for (size_t i = 0; i < drive.size(); i++) {
+      const Sample &d = drive[i];
+      ahrsUpdate(a, d.gyro, d.acc, d.mag, d.speed, true, SAMPLE_MS / 1000.0f);
+      float roll, pitch, yaw, lin[3];
+      ahrsEuler(a, roll, pitch, yaw);
+      ahrsLinear(a, d.acc, lin);
+      sink += roll + lin[0];
+    }
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  printf("update + euler + linear: %.0f ns per sample (host, checksum %.1f)\n",
+    ns / (reps * drive.size()), sink);
+  return 0;
+}
@@ -0,0 +1,134 @@
+/**
+ *  Analog Bridge — Binary Log to CSV
+ *
+ *  Converts a binary log (.bin, see firmware/shared/binlog.h) from
+ *  either target into the CSV the device writes in CSV mode,
+ *  date line and units row included, so log-analyzer.html and other
+ *  CSV tools read it unchanged.
+ *
+ *  SensorFrame fields are fixed point at the CSV's own precision and are
+ *  printed from the integers directly; no float round trip. Columns and
+ *  formats come from channels.h, so the tool must be built from the
+ *  same tree as the firmware that wrote the log (the header's channel
+ *  count is checked).
+ *
+ *  Conversion stops at the first record without BINLOG_SYNC or with
+ *  time running backwards: the zero/erased tail of a preallocated AVR
+ *  file that was not closed cleanly.
+ *
+ *  Build:  g++ -std=c++11 -O2 -I../../firmware/shared -o bin2csv bin2csv.cpp
+ *  Usage:  ./bin2csv LOG_0.bin > LOG_0.csv
+ *
+ *  Record counts go to stderr.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "binlog.h"
+
+static bool readFile(const char* path, std::vector<uint8_t> &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    out.insert(out.end(), buf, buf + n);
+  }
+  fclose(f);
+  return true;
+}
+
+// Fixed-point value with the given number of decimals, e.g. -5 / 2 → "-0.05"
+static void printQ(int32_t v, uint8_t decimals) {
+  static const int32_t pow10[] = { 1, 10, 100, 1000 };
+  if (decimals == 0) {
+    printf("%d", v);
+    return;
+  }
+  int64_t a = v < 0 ? -(int64_t)v : v;
+  printf("%s%lld.%0*lld", v < 0 ? "-" : "", (long long)(a / pow10[decimals]),
+    decimals, (long long)(a % pow10[decimals]));
+}
+
+static void printQ16(int16_t v, uint8_t decimals) {
+  if (v == SF_NAN) printf("nan");
+  else printQ(v, decimals);
+}
+
+static void printDegE7(int32_t v) {
+  int64_t a = v < 0 ? -(int64_t)v : v;
+  printf("%s%lld.%07lld", v < 0 ? "-" : "", (long long)(a / 10000000), (long long)(a % 10000000));
+}
+
+#define CSV_TIME(m, store, dg)  printQ(r.timeMs, dg)
+#define CSV_KEY(m, store, dg)   printf("%u", r.keyframe)
+#define CSV_DEG(m, store, dg)   printDegE7(f.m)
+#define CSV_F(m, store, dg)     CSV_F_##store(f.m, dg)
+#define CSV_F_I32(v, dg)        printQ(v, dg)
+#define CSV_F_U16(v, dg)        printQ(v, dg)
+#define CSV_F_I16(v, dg)        printQ16(v, dg)
+#define CSV_U8(m, store, dg)    printf("%u", f.m)
+#define CSV_BOOL(m, store, dg)  printf("%u", f.m)
+#define CSV_FIELD(name, unit, m, type, store, dg, group, json)  CSV_##type(m, store, dg);
+
+static void printRecord(const BinlogRecord &r) {
+  const SensorFrame &f = r.frame;
+  AB_CHANNELS(CSV_FIELD, putchar(',');)
+  putchar('\n');
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s log.bin\n", argv[0]);
+    return 2;
+  }
+  const char* path = argv[1];
+
+  std::vector<uint8_t> file;
+  if (!readFile(path, file)) {
+    fprintf(stderr, "ERR: cannot read %s\n", path);
+    return 1;
+  }
+  BinlogHeader h;
+  if (file.size() < BINLOG_BLOCK) {
+    fprintf(stderr, "ERR: %s: too short\n", path);
+    return 1;
+  }
+  memcpy(&h, file.data(), sizeof(h));
+  if (!binlogHeaderValid(h)) {
+    fprintf(stderr, "ERR: %s: not a binary log (v%d, %d channels)\n", path,
+      BINLOG_VERSION, AB_CHANNEL_COUNT);
+    return 1;
+  }
+
+  h.date[sizeof(h.date) - 1] = '\0';
+  h.firmware[sizeof(h.firmware) - 1] = '\0';
+  if (h.date[0]) printf("%s\n", h.date);
+  printf("%s\n%s\n", AB_CSV_HEADER, AB_CSV_UNITS);
+
+  uint32_t rows = 0;
+  uint32_t lastMs = 0;
+  const char *end = "end of file";
+  for (size_t pos = BINLOG_BLOCK; pos + sizeof(BinlogRecord) <= file.size();
+       pos = binlogNextRecord(pos)) {
+    BinlogRecord r;
+    memcpy(&r, &file[pos], sizeof(r));
+    if (r.sync != BINLOG_SYNC) {
+      end = "first unwritten record";
+      break;
+    }
+    if (rows > 0 && r.timeMs < lastMs) {
+      end = "time going backwards";
+      break;
+    }
+    printRecord(r);
+    lastMs = r.timeMs;
+    rows++;
+  }
+
+  fprintf(stderr, "%s: %s v%s, %u ms period, %u rows (stopped at %s)\n", path,
+    h.source == BINLOG_SRC_AVR ? "AVR" : h.source == BINLOG_SRC_ESP32 ? "ESP32" : "?",
+    h.firmware, h.sampleMs, rows, end);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ *  Analog Bridge — ISP2 Parser Benchmark
+ *
+ *  Host throughput of the shared parser (firmware/shared/isp2_parser.h)
+ *  decoding a synthetic Nova-chain stream into SensorData through the
+ *  compile-time map, fed one byte at a time (the old per-byte loop) and
+ *  in spans the size of typical UART reads.
+ *
+ *  Build:  g++ -std=c++11 -O2 -I../../firmware/shared -o isp2_bench isp2_bench.cpp
+ *  Usage:  ./isp2_bench [packets]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "isp2_parser.h"
+#include "sensor_data.h"
+
+static void putAux(std::vector<uint8_t> &s, uint16_t raw) {
+  s.push_back((raw >> 7) & 0x07);
+  s.push_back(raw & 0x7F);
+}
+
+static void putLc1(std::vector<uint8_t> &s, uint16_t lambda) {
+  const uint16_t afrMult = 147;
+  s.push_back(0x42 | ((afrMult >> 7) & 0x01));
+  s.push_back(afrMult & 0x7F);
+  s.push_back((lambda >> 7) & 0x3F);
+  s.push_back(lambda & 0x7F);
+}
+
+// Nova chain packet: 2 aux, 2 LC-1, 2 aux = 8 words, plus a byte of
+// line noise every so often to exercise sync hunting
+static std::vector<uint8_t> makeStream(uint32_t packets) {
+  std::vector<uint8_t> s;
+  srand(1969);
+  for (uint32_t i = 0; i < packets; i++) {
+    s.push_back(0xB2);
+    s.push_back(0x80 | 8);
+    putAux(s, 400 + rand() % 16);
+    putAux(s, 600 + rand() % 16);
+    putLc1(s, 480 + rand() % 40);
+    putLc1(s, 480 + rand() % 40);
+    putAux(s, 700 + rand() % 16);
+    putAux(s, 100 + rand() % 64);
+    if (i % 16 == 0) s.push_back(0x00);
+  }
+  return s;
+}
+
+static double run(const std::vector<uint8_t> &stream, size_t span, uint32_t &packets) {
+  ISP2Parser parser = {};
+  SensorData data = {};
+  ISP2NovaSink<SensorData> sink(data);
+  uint32_t t = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t pos = 0; pos < stream.size(); pos += span) {
+    size_t n = stream.size() - pos < span ? stream.size() - pos : span;
+    parser.tick(t);
+    parser.feed(&stream[pos], n, t, sink);
+    t += 1000;
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  packets = parser.stats.packets;
+  volatile float sinkHole = data.afr + data.coolant;  // keep the stores
+  (void)sinkHole;
+  return std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000000;
+  std::vector<uint8_t> stream = makeStream(count);
+  printf("%u packets, %zu bytes\n", count, stream.size());
+
+  const size_t spans[] = { 1, 18, 64, 128 };
+  for (size_t span : spans) {
+    uint32_t packets;
+    double sec = run(stream, span, packets);
+    printf("span %3zu: %7.1f MB/s  %6.1f ns/packet  (%u decoded)\n", span,
+      stream.size() / sec / 1e6, sec * 1e9 / packets, packets);
+  }
+  return 0;
+}
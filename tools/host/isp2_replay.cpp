@@ -0,0 +1,151 @@
+/**
+ *  Analog Bridge — ISP2 Capture Replay
+ *
+ *  Replays a raw ISP2 capture (.isp, see firmware/shared/isp2_capture.h)
+ *  through the firmware's own parser (isp2_parser.h) and calibration
+ *  tables (isp2_defs.h), and prints the engine channels as CSV, one row
+ *  per decoded packet. Chunks are fed with their recorded timestamps,
+ *  so framing, timeouts and link statistics match the device exactly.
+ *
+ *  Each row carries the plausibility verdict the device would log
+ *  (engQual, engine_validate.h); there is no GPS here, so only the
+ *  range and rate checks apply.
+ *
+ *  Uses the compile-time Nova channel map (ISP2NovaSink, the ESP32's
+ *  default map). To re-convert an old session with new curves, edit
+ *  isp2_defs.h and rebuild.
+ *
+ *  Build:  g++ -std=c++11 -O2 -I../../firmware/shared -o isp2_replay isp2_replay.cpp
+ *  Usage:  ./isp2_replay [--hex] LOG_0.isp > LOG_0_engine.csv
+ *          --hex  append each packet's raw payload as a hex column
+ *
+ *  Link statistics go to stderr.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "isp2_capture.h"
+#include "isp2_parser.h"
+#include "engine_validate.h"
+#include "sensor_data.h"
+
+// Compile-time Nova map (same defaults as the ESP32 channel map);
+// prints one CSV row per packet
+struct ReplaySink : ISP2NovaSink<SensorData> {
+  bool hex;
+  uint64_t elapsedUs;
+  EngineValidator val;
+
+  ReplaySink(SensorData &d, bool hexOut) : ISP2NovaSink<SensorData>(d), hex(hexOut), elapsedUs(0), val() {}
+
+  void done(const ISP2Parser &p, ISP2Layout) {
+    engineValidate(val, data, p.stats.lastPacketUs);
+    printf("%.6f,%.2f,%.2f,%u,%u,%u,%u,%.2f,%.2f,%.2f,%.2f,%u",
+      elapsedUs / 1e6, data.afr, data.afr1, data.afrStat, data.afr1Stat,
+      data.afrDetail, data.afr1Detail, data.vss, data.map, data.oilp, data.coolant,
+      data.engQual);
+    if (hex) {
+      putchar(',');
+      for (uint8_t k = 0; k < p.packetLen * 2; k++) printf("%02X", p.data[k]);
+    }
+    putchar('\n');
+  }
+};
+
+static bool readFile(const char* path, std::vector<uint8_t> &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    out.insert(out.end(), buf, buf + n);
+  }
+  fclose(f);
+  return true;
+}
+
+static void printStats(const ISP2Stats &s, uint32_t records, uint32_t gaps) {
+  fprintf(stderr, "Records: %u  Gaps: %u\n", records, gaps);
+  fprintf(stderr, "Bytes: %u  Packets: %u (+%u non-data)  Discarded: %u\n",
+    s.bytes, s.packets, s.otherPackets, s.discarded);
+  fprintf(stderr, "Sync losses: %u  Timeouts: %u  Bad lengths: %u\n",
+    s.syncLosses, s.timeouts, s.badLengths);
+  fprintf(stderr, "Interval: min %.1f / avg %.1f / max %.1f ms (nominal %.2f)\n",
+    s.intervalMinUs / 1000.0, isp2StatsMeanUs(s) / 1000.0,
+    s.intervalMaxUs / 1000.0, ISP2_FRAME_US / 1000.0);
+  fprintf(stderr, "Missed frames: %u  Outages: %u  Capture: %.2f%%\n",
+    s.missedFrames, s.outages, isp2StatsCapturePct(s));
+}
+
+static void printRejects(const EngineValidator &v) {
+  fprintf(stderr, "Rejected: %u range  %u rate  (of %u packets)\n",
+    v.rangeRejects, v.rateRejects, v.packets);
+}
+
+int main(int argc, char** argv) {
+  bool hex = false;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--hex") == 0) hex = true;
+    else path = argv[i];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [--hex] capture.isp\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> file;
+  if (!readFile(path, file)) {
+    fprintf(stderr, "ERR: cannot read %s\n", path);
+    return 1;
+  }
+  Isp2CaptureHeader h;
+  if (file.size() < sizeof(h)) {
+    fprintf(stderr, "ERR: %s: too short\n", path);
+    return 1;
+  }
+  memcpy(&h, file.data(), sizeof(h));
+  if (!isp2CapHeaderValid(h)) {
+    fprintf(stderr, "ERR: %s: not an ISP2 capture (v%d)\n", path, ISP2_CAP_VERSION);
+    return 1;
+  }
+
+  printf("time,afr,afr1,afrStat,afr1Stat,afrDetail,afr1Detail,vss,map,oilp,coolant,engQual%s\n",
+    hex ? ",packet" : "");
+
+  ISP2Parser parser = {};
+  SensorData data = {};
+  data.gpsStale = true;
+  ReplaySink sink(data, hex);
+  uint32_t records = 0, gaps = 0;
+
+  size_t pos = sizeof(h);
+  while (pos < file.size()) {
+    uint32_t dt, n;
+    uint8_t a = isp2CapGetVarint(&file[pos], file.size() - pos, dt);
+    uint8_t b = a ? isp2CapGetVarint(&file[pos + a], file.size() - pos - a, n) : 0;
+    if (!b || pos + a + b + n > file.size()) {
+      fprintf(stderr, "WRN: truncated record at offset %zu\n", pos);
+      break;
+    }
+    pos += a + b;
+    sink.elapsedUs += dt;
+    uint32_t nowUs = h.startUs + (uint32_t)sink.elapsedUs;  // wraps like micros()
+    records++;
+
+    if (n == 0) {
+      // Bytes lost on the device side: resync rather than splice
+      gaps++;
+      parser.state = ISP2_SYNC_HIGH;
+      continue;
+    }
+
+    parser.tick(nowUs);
+    parser.feed(&file[pos], n, nowUs, sink);
+    pos += n;
+  }
+
+  printStats(parser.stats, records, gaps);
+  printRejects(sink.val);
+  return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ *  Analog Bridge — Vibration RPM Benchmark
+ *
+ *  Runs the shared estimator (firmware/shared/vib_rpm.h) over synthetic
+ *  accel with a known RPM trace and reports per-sample cost and
+ *  accuracy per window.
+ *
+ *  The session: engine off with people moving around the car, cold
+ *  start with fast idle settling and idle hunt, free revs in neutral,
+ *  then random pulls through the gears (2500 / 1500 / 900 rpm/s, 0.3 s
+ *  shifts), cruise, decel and stops. Vibration per axis: firing order
+ *  (cylinders/2) growing with RPM, orders 1, 2 and 2×firing at fixed
+ *  fractions of it, each axis its own mix and phase; when moving, road
+ *  noise, a 1.5 Hz body bounce and the wheel order. Synthesized at
+ *  4 kHz, through the MPU9250's 420 Hz accel DLPF (two-pole), sampled
+ *  at VR_FS with chip noise and 2 g-range quantization.
+ *
+ *  Build:  g++ -std=c++11 -O2 -I../../firmware/shared -o vib_rpm_bench vib_rpm_bench.cpp
+ *  Usage:  ./vib_rpm_bench [minutes] [cylinders]   (default 20 min, 8)
+ *
+ *  The per-sample cost is the host's. On the S3, the 'C' serial command
+ *  prints the same figure for the FIFO drain (I2C burst included); the
+ *  IMUFIFO row of 't' and ab_imu_fifo_us in /api/metrics break it down.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "vib_rpm.h"
+
+#define SYNTH_X      4          // synthesis rate = VR_FS × this
+#define DLPF_HZ      420.0      // MPU9250 A_DLPF_CFG 7
+
+struct Truth {
+  float acc[3];
+  float rpm;                    // 0 = engine off
+};
+
+static double uniform() { return rand() / (double)RAND_MAX; }
+
+static double gauss() {
+  double s = 0.0;
+  for (int i = 0; i < 12; i++) s += uniform();
+  return s - 6.0;
+}
+
+// RPM and road speed (mph) against time: a list of ramps
+struct Ramp { double secs, rpm0, rpm1, mph0, mph1; };
+
+static void drivePlan(std::vector<Ramp> &plan, double minutes) {
+  plan.push_back({ 20.0, 0, 0, 0, 0 });              // off, doors and people
+  plan.push_back({ 10.0, 1300, 750, 0, 0 });         // start, fast idle settles
+  for (int i = 0; i < 3; i++) {                      // free revs
+    plan.push_back({ 1.4, 750, 4500, 0, 0 });
+    plan.push_back({ 2.0, 4500, 750, 0, 0 });
+    plan.push_back({ 3.0, 750, 750, 0, 0 });
+  }
+  double t = 0.0;
+  for (size_t i = 0; i < plan.size(); i++) t += plan[i].secs;
+  while (t < minutes * 60.0) {
+    size_t start = plan.size();
+    double top = 4200 + 1300 * uniform();           // shift point
+    plan.push_back({ 1.5, 750, 1500, 0, 3 });        // clutch out
+    plan.push_back({ (top - 1500) / 2500, 1500, top, 3, top / 1500 * 9 });
+    double v = top / 1500 * 9;
+    plan.push_back({ 0.3, top, top * 0.6, v, v });
+    plan.push_back({ (top - top * 0.6) / 1500, top * 0.6, top, v, v * 1.6 });
+    v *= 1.6;
+    plan.push_back({ 0.3, top, top * 0.68, v, v });
+    plan.push_back({ (top - top * 0.68) / 900, top * 0.68, top, v, v * 1.45 });
+    v *= 1.45;
+    plan.push_back({ 0.4, top, 2200, v, v });
+    plan.push_back({ 20 + 40 * uniform(), 2200, 2000 + 400 * uniform(), v, v });
+    plan.push_back({ 6.0, 2200, 900, v, 0 });        // decel and stop
+    plan.push_back({ 5 + 10 * uniform(), 750, 750, 0, 0 });
+    for (size_t i = start; i < plan.size(); i++) t += plan[i].secs;
+  }
+}
+
+static std::vector<Truth> makeSession(double minutes, uint8_t cylinders) {
+  srand(502);
+  std::vector<Ramp> plan;
+  drivePlan(plan, minutes);
+
+  const double fs = VR_FS * SYNTH_X, dt = 1.0 / fs;
+  const double order = cylinders * 0.5;
+  // Orders relative to firing, amplitude relative to firing
+  const double ord[4] = { 1.0 / order, 2.0 / order, 1.0, 2.0 };
+  const double rel[4] = { 0.15, 0.3, 1.0, 0.5 };
+  double gain[4][3], phase[4][3], gainRoad[3];
+  for (int o = 0; o < 4; o++)
+    for (int a = 0; a < 3; a++) {
+      gain[o][a] = 0.3 + 0.7 * uniform();
+      phase[o][a] = 2 * M_PI * uniform();
+    }
+  for (int a = 0; a < 3; a++) gainRoad[a] = 0.5 + 0.5 * uniform();
+
+  // Two-pole Butterworth at DLPF_HZ (bilinear)
+  double k = tan(M_PI * DLPF_HZ / fs), nrm = 1.0 / (1.0 + sqrt(2.0) * k + k * k);
+  double b0 = k * k * nrm, b1 = 2 * b0, b2 = b0;
+  double a1 = 2 * (k * k - 1) * nrm, a2 = (1 - sqrt(2.0) * k + k * k) * nrm;
+  double z1[3] = { 0, 0, 0 }, z2[3] = { 0, 0, 0 };
+
+  std::vector<Truth> out;
+  double crank = 0.0, wheel = 0.0, time = 0.0;
+  long n = 0;
+  for (size_t r = 0; r < plan.size(); r++) {
+    const Ramp &p = plan[r];
+    long steps = (long)(p.secs * fs);
+    for (long i = 0; i < steps; i++, n++) {
+      double f = (double)i / steps;
+      double rpm = p.rpm0 + (p.rpm1 - p.rpm0) * f;
+      double mph = p.mph0 + (p.mph1 - p.mph0) * f;
+      if (rpm > 0.0 && rpm < 1000.0 && p.rpm0 == p.rpm1) {
+        rpm += 40.0 * sin(2 * M_PI * 0.7 * time);    // idle hunt
+      }
+      time += dt;
+      crank += 2 * M_PI * rpm / 60.0 * dt;           // crank angle
+      wheel += 2 * M_PI * mph * 0.44704 / 2.23 * dt; // 2.23 m tire
+      double firing = rpm > 0.0 ? 0.01 + 0.03 * rpm / 6000.0 : 0.0;
+      double bounce = 0.08 * (mph > 0.5) * sin(2 * M_PI * 1.5 * time);
+      double x[3];
+      for (int a = 0; a < 3; a++) {
+        double v = 0.0;
+        for (int o = 0; o < 4; o++) {
+          v += firing * rel[o] * gain[o][a] * sin(ord[o] * order * crank + phase[o][a]);
+        }
+        if (mph > 0.5) {
+          v += gainRoad[a] * (0.06 * gauss() + 0.02 * sin(wheel) + bounce);
+        } else if (rpm == 0.0) {
+          v += 0.01 * gauss() + 0.03 * sin(2 * M_PI * 0.8 * time) * (sin(0.2 * time) > 0.5);
+        }
+        if (a == 2) v += 1.0;                          // gravity
+        double y = b0 * v + z1[a];
+        z1[a] = b1 * v - a1 * y + z2[a];
+        z2[a] = b2 * v - a2 * y;
+        x[a] = y;
+      }
+      if (n % SYNTH_X) continue;
+      Truth t;
+      for (int a = 0; a < 3; a++) {
+        double g = x[a] + 0.006 * gauss();             // ~300 ug/rtHz over the DLPF
+        t.acc[a] = (float)(floor(g * 16384.0 + 0.5) / 16384.0);
+      }
+      t.rpm = (float)rpm;
+      out.push_back(t);
+    }
+  }
+  return out;
+}
+
+int main(int argc, char** argv) {
+  double minutes = argc > 1 ? atof(argv[1]) : 20.0;
+  uint8_t cylinders = argc > 2 ? (uint8_t)atoi(argv[2]) : 8;
+  std::vector<Truth> s = makeSession(minutes, cylinders);
+  printf("%.0f min session, %d cylinders, %zu samples at %.0f Hz, %d-sample windows\n",
+    minutes, cylinders, s.size(), VR_FS, VR_N);
+
+  static VibRpm t;
+  vibRpmInit(t, cylinders);
+  std::vector<double> err;
+  long on = 0, onConf = 0, off = 0, offConf = 0, gross = 0, hi = 0, hiGross = 0;
+  double truthSum = 0.0, mono = 0.0;
+  bool engineOff = true;
+  for (size_t i = 0; i < s.size(); i++) {
+    truthSum += s[i].rpm;
+    engineOff = engineOff && s[i].rpm == 0.0f;
+    if (!vibRpmAdd(t, s[i].acc)) continue;
+    double truth = truthSum / VR_N;
+    bool wasOff = engineOff;
+    truthSum = 0.0;
+    engineOff = true;
+    if (wasOff) {
+      off++;
+      if (t.conf > 0) offConf++;
+      continue;
+    }
+    if (truth <= 0.0) continue;                      // window spans the start
+    on++;
+    if (t.conf == 0) continue;
+    onConf++;
+    double e = fabs(t.rpm - truth);
+    err.push_back(e);
+    if (e > 0.1 * truth) gross++;
+    if (t.conf >= 50) {
+      hi++;
+      if (e > 0.1 * truth) hiGross++;
+    }
+    mono += t.rpm;
+  }
+  std::sort(err.begin(), err.end());
+  long within = 0;
+  for (size_t i = 0; i < err.size(); i++) within += err[i] <= 50.0;
+  printf("engine off:  %ld windows, %ld with an estimate\n", off, offConf);
+  printf("engine on:   %ld windows, %.1f %% with an estimate\n", on, 100.0 * onConf / on);
+  if (!err.empty()) {
+    printf("error:       median %.0f rpm, p95 %.0f rpm, %.1f %% within 50 rpm\n",
+      err[err.size() / 2], err[err.size() * 95 / 100], 100.0 * within / err.size());
+  }
+  printf("gross (>10 %%): %ld of %ld; at conf >= 50: %ld of %ld\n", gross, onConf, hiGross, hi);
+
+  // Cost per sample: the whole session, repeated
+  const int reps = 5;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++) {
+    vibRpmInit(t, cylinders);
+    for (size_t i = 0; i < s.size(); i++) mono += vibRpmAdd(t, s[i].acc) ? t.rpm : 0.0f;
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  printf("%.0f ns per sample, %.2f ms per %d-sample window (host, checksum %.0f)\n",
+    ns / (reps * s.size()), ns / (reps * s.size()) * VR_N / 1e6, VR_N, mono);
+  return 0;
+}